@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/bind_handler.hpp>
+#include <ma/detail/functional.hpp>
+
+namespace ma {
+namespace benchmark_bind_handler {
+
+class io_handler
+{
+public:
+  explicit io_handler(std::size_t& counter)
+    : counter_(&counter)
+  {
+  }
+
+  void operator()(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    if (!error)
+    {
+      *counter_ += bytes_transferred;
+    }
+  }
+
+private:
+  std::size_t* counter_;
+}; // class io_handler
+
+void invoke_bind_handler(benchmark::State& state)
+{
+  std::size_t counter = 0;
+  const boost::system::error_code error;
+  for (auto _ : state)
+  {
+    bind_handler(io_handler(counter), error, std::size_t(1))();
+    benchmark::DoNotOptimize(counter);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(invoke_bind_handler);
+
+void invoke_bind(benchmark::State& state)
+{
+  std::size_t counter = 0;
+  const boost::system::error_code error;
+  for (auto _ : state)
+  {
+    detail::bind<void>(io_handler(counter), error, std::size_t(1))();
+    benchmark::DoNotOptimize(counter);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(invoke_bind);
+
+void post_bind_handler(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  std::size_t counter = 0;
+  const boost::system::error_code error;
+  for (auto _ : state)
+  {
+    io_service.post(bind_handler(io_handler(counter), error, std::size_t(1)));
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(post_bind_handler);
+
+void post_bind(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  std::size_t counter = 0;
+  const boost::system::error_code error;
+  for (auto _ : state)
+  {
+    io_service.post(detail::bind<void>(io_handler(counter), error,
+        std::size_t(1)));
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(post_bind);
+
+} // namespace benchmark_bind_handler
+} // namespace ma
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/custom_alloc_handler.hpp>
+
+namespace ma {
+namespace benchmark_custom_alloc_handler {
+
+/// Handler of the size close to the size of typical handler of async
+/// operation (bound member function with a few arguments).
+class counting_handler
+{
+public:
+  explicit counting_handler(std::size_t& counter)
+    : counter_(&counter)
+  {
+    for (std::size_t i = 0; i != sizeof(payload_) / sizeof(payload_[0]); ++i)
+    {
+      payload_[i] = i;
+    }
+  }
+
+  void operator()()
+  {
+    ++*counter_;
+  }
+
+private:
+  std::size_t* counter_;
+  std::size_t  payload_[6];
+}; // class counting_handler
+
+void post_plain_handler(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    io_service.post(counting_handler(counter));
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(post_plain_handler);
+
+void post_in_place_alloc_handler(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  in_place_handler_allocator<256> allocator;
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    io_service.post(make_custom_alloc_handler(allocator,
+        counting_handler(counter)));
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(post_in_place_alloc_handler);
+
+void post_in_heap_alloc_handler(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  in_heap_handler_allocator allocator(256);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    io_service.post(make_custom_alloc_handler(allocator,
+        counting_handler(counter)));
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(post_in_heap_alloc_handler);
+
+} // namespace benchmark_custom_alloc_handler
+} // namespace ma
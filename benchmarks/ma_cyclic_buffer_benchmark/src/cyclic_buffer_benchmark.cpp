@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/cyclic_buffer.hpp>
+
+namespace ma {
+namespace benchmark_cyclic_buffer {
+
+const std::size_t buffer_size = 4096;
+
+/// Prepares buffer to have data wrapped around its end, i.e. both
+/// data and prepared sequences consist of two buffers.
+void wrap_around(cyclic_buffer& buffer)
+{
+  buffer.consume(buffer_size * 3 / 4);
+  buffer.commit(buffer_size / 2);
+  buffer.consume(buffer_size / 2);
+}
+
+void consume_commit(benchmark::State& state)
+{
+  const std::size_t chunk_size = static_cast<std::size_t>(state.range(0));
+  cyclic_buffer buffer(buffer_size);
+  for (auto _ : state)
+  {
+    // Is the same as one step of echo: read into buffer, write from buffer
+    benchmark::DoNotOptimize(buffer.prepared());
+    buffer.consume(chunk_size);
+    benchmark::DoNotOptimize(buffer.data());
+    buffer.commit(chunk_size);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+      * static_cast<int64_t>(chunk_size));
+}
+
+BENCHMARK(consume_commit)->Arg(64)->Arg(1024)->Arg(4000);
+
+void data(benchmark::State& state)
+{
+  cyclic_buffer buffer(buffer_size);
+  if (state.range(0))
+  {
+    wrap_around(buffer);
+  }
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(buffer.data());
+  }
+}
+
+BENCHMARK(data)->ArgName("wrapped")->Arg(0)->Arg(1);
+
+void prepared(benchmark::State& state)
+{
+  cyclic_buffer buffer(buffer_size);
+  if (state.range(0))
+  {
+    wrap_around(buffer);
+  }
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(buffer.prepared());
+  }
+}
+
+BENCHMARK(prepared)->ArgName("wrapped")->Arg(0)->Arg(1);
+
+void limited_data(benchmark::State& state)
+{
+  cyclic_buffer buffer(buffer_size);
+  wrap_around(buffer);
+  const std::size_t max_size = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(buffer.data(max_size));
+  }
+}
+
+BENCHMARK(limited_data)->Arg(64)->Arg(1024);
+
+} // namespace benchmark_cyclic_buffer
+} // namespace ma
@@ -0,0 +1,217 @@
+#!/bin/bash
+
+#
+# Copyright (c) 2019 Marat Abrarov (abrarov@gmail.com)
+#
+# Distributed under the Boost Software License, Version 1.0. (See accompanying
+# file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+
+# Runs ma_echo_server and ma_asio_performance_test_client on loopback for
+# each combination of parameters, writes the report and compares it with
+# the baseline (if given).
+#
+# Parameters are passed through environment variables:
+#   ECHO_SERVER              - path to ma_echo_server
+#   PERFORMANCE_TEST_CLIENT  - path to ma_asio_performance_test_client
+#   REPORT_FILE              - path to the report (CSV) to write
+#   PORT                     - TCP port to use
+#   THREADS                  - space separated list of thread counts
+#   SESSIONS                 - space separated list of session counts
+#   BUFFERS                  - space separated list of buffer sizes (bytes)
+#   DEMUX                    - space separated list of demultiplexer-per-work-
+#                              thread modes (on / off)
+#   PROFILES                 - space separated list of server socket profiles
+#                              (none / latency / throughput), optional
+#   DURATION                 - duration of each run (seconds)
+#   BASELINE_FILE            - report of the previous run to compare with,
+#                              optional
+#   THRESHOLD                - allowed degradation comparing with the baseline
+#                              (percents)
+
+set -e
+
+port="${PORT:-17777}"
+profiles="${PROFILES:-none}"
+duration="${DURATION:-3}"
+threshold="${THRESHOLD:-10}"
+warmup=1
+if [[ "${duration}" -le "${warmup}" ]]; then
+  warmup=0
+fi
+measured_duration=$((duration - warmup))
+# Time given to the server to start accepting connections (seconds)
+server_start_timeout=10
+
+server_pid=""
+
+stop_server() {
+  if [[ -n "${server_pid}" ]]; then
+    kill -TERM "${server_pid}" 2>/dev/null || true
+    wait "${server_pid}" 2>/dev/null || true
+    server_pid=""
+  fi
+}
+
+trap stop_server EXIT
+
+start_server() {
+  local threads="${1}"
+  local buffer="${2}"
+  local demux="${3}"
+  local profile="${4}"
+  "${ECHO_SERVER}" \
+    --port "${port}" \
+    --session-threads "${threads}" \
+    --buffer "${buffer}" \
+    --demux-per-work-thread "${demux}" \
+    --sock-profile "${profile}" \
+    > /dev/null 2>&1 &
+  server_pid=$!
+  wait_server
+}
+
+# Waits until the server accepts connections or fails if it doesn't happen
+# during start timeout
+wait_server() {
+  local attempts=$((server_start_timeout * 10))
+  while ! (exec 3<>"/dev/tcp/127.0.0.1/${port}") 2>/dev/null; do
+    if ! kill -0 "${server_pid}" 2>/dev/null; then
+      echo "Echo server exited before accepting connections" >&2
+      server_pid=""
+      return 1
+    fi
+    attempts=$((attempts - 1))
+    if [[ "${attempts}" -le 0 ]]; then
+      echo "Echo server doesn't accept connections at port ${port}" >&2
+      return 1
+    fi
+    sleep 0.1
+  done
+}
+
+# Prints the output of test client
+run_client() {
+  local mode="${1}"
+  local threads="${2}"
+  local sessions="${3}"
+  local buffer="${4}"
+  local demux="${5}"
+  "${PERFORMANCE_TEST_CLIENT}" \
+    --host 127.0.0.1 \
+    --port "${port}" \
+    --mode "${mode}" \
+    --threads "${threads}" \
+    --sessions "${sessions}" \
+    --batch-size "${sessions}" \
+    --buffer "${buffer}" \
+    --demux-per-work-thread "${demux}" \
+    --no-delay 1 \
+    --time "${duration}" \
+    --warmup "${warmup}" \
+    --sample-interval 0
+}
+
+# Prints the value of "Name : value" line of the client output
+total_value() {
+  sed -r "s/^${1}[[:space:]]*:[[:space:]]*>?([[:digit:]]+)$/\1/;t;d" | head -n 1
+}
+
+# Prints the value of percentile line of the round trip time section
+round_trip_value() {
+  sed -n '/^Round trip time/,/^  max/p' | total_value "  ${1}"
+}
+
+to_demux_flag() {
+  if [[ "${1}" == "on" ]]; then
+    echo 1
+  else
+    echo 0
+  fi
+}
+
+echo "threads,sessions,buffer,demux,profile,throughput_bytes_per_second,round_trip_p50_us,round_trip_p99_us" \
+  > "${REPORT_FILE}"
+
+for threads in ${THREADS}; do
+  for sessions in ${SESSIONS}; do
+    for buffer in ${BUFFERS}; do
+      for demux in ${DEMUX}; do
+        for profile in ${profiles}; do
+          demux_flag="$(to_demux_flag "${demux}")"
+          start_server "${threads}" "${buffer}" "${demux_flag}" "${profile}"
+
+          stream_output="$(run_client stream "${threads}" "${sessions}" \
+            "${buffer}" "${demux_flag}")"
+          bytes_read="$(echo "${stream_output}" | total_value "Total bytes read")"
+          throughput=$((${bytes_read:-0} / measured_duration))
+
+          ping_pong_output="$(run_client ping-pong "${threads}" "${sessions}" \
+            "${buffer}" "${demux_flag}")"
+          p50="$(echo "${ping_pong_output}" | round_trip_value p50)"
+          p99="$(echo "${ping_pong_output}" | round_trip_value p99)"
+
+          stop_server
+
+          echo "${threads},${sessions},${buffer},${demux},${profile},${throughput},${p50:-0},${p99:-0}" \
+            >> "${REPORT_FILE}"
+          echo "threads: ${threads}, sessions: ${sessions}, buffer: ${buffer}, demux: ${demux}, profile: ${profile}:" \
+            "throughput: ${throughput} B/s, round trip p50: ${p50:-n/a} us, p99: ${p99:-n/a} us"
+        done
+      done
+    done
+  done
+done
+
+echo "Report is written into ${REPORT_FILE}"
+
+if [[ -z "${BASELINE_FILE}" ]]; then
+  exit 0
+fi
+
+if [[ ! -f "${BASELINE_FILE}" ]]; then
+  echo "Baseline file ${BASELINE_FILE} not found" >&2
+  exit 1
+fi
+
+# Throughput is expected to not decrease and latency is expected to not
+# increase by more than threshold percents. Combinations missing in the
+# baseline are skipped.
+awk -F, -v threshold="${threshold}" '
+  FNR == 1 {
+    next
+  }
+  NR == FNR {
+    key = $1 "," $2 "," $3 "," $4 "," $5
+    baseline_throughput[key] = $6
+    baseline_p50[key] = $7
+    baseline_p99[key] = $8
+    next
+  }
+  {
+    key = $1 "," $2 "," $3 "," $4 "," $5
+    if (!(key in baseline_throughput)) {
+      next
+    }
+    if ($6 < baseline_throughput[key] * (1 - threshold / 100)) {
+      printf "Regression of throughput for %s: %s B/s, baseline: %s B/s\n", \
+        key, $6, baseline_throughput[key]
+      failed = 1
+    }
+    if ($7 > baseline_p50[key] * (1 + threshold / 100)) {
+      printf "Regression of round trip p50 for %s: %s us, baseline: %s us\n", \
+        key, $7, baseline_p50[key]
+      failed = 1
+    }
+    if ($8 > baseline_p99[key] * (1 + threshold / 100)) {
+      printf "Regression of round trip p99 for %s: %s us, baseline: %s us\n", \
+        key, $8, baseline_p99[key]
+      failed = 1
+    }
+  }
+  END {
+    exit failed
+  }
+' "${BASELINE_FILE}" "${REPORT_FILE}"
+
+echo "No regressions comparing with ${BASELINE_FILE} (threshold: ${threshold}%)"
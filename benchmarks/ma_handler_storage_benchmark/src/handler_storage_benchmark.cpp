@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/handler_storage.hpp>
+
+namespace ma {
+namespace benchmark_handler_storage {
+
+typedef handler_storage<int> handler_storage_type;
+
+class counting_handler
+{
+public:
+  explicit counting_handler(std::size_t& counter)
+    : counter_(&counter)
+  {
+  }
+
+  void operator()(int value)
+  {
+    *counter_ += static_cast<std::size_t>(value);
+  }
+
+private:
+  std::size_t* counter_;
+}; // class counting_handler
+
+void store_clear(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  handler_storage_type storage(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    storage.store(counting_handler(counter));
+    storage.clear();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(store_clear);
+
+void store_post(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  handler_storage_type storage(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    storage.store(counting_handler(counter));
+    storage.post(1);
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(store_post);
+
+void store_post_custom_alloc(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  handler_storage_type storage(io_service);
+  in_place_handler_allocator<256> allocator;
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    storage.store(make_custom_alloc_handler(allocator,
+        counting_handler(counter)));
+    storage.post(1);
+    io_service.poll_one();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(store_post_custom_alloc);
+
+} // namespace benchmark_handler_storage
+} // namespace ma
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/sp_intrusive_list.hpp>
+#include <ma/detail/memory.hpp>
+
+namespace ma {
+namespace benchmark_sp_intrusive_list {
+
+class item : public sp_intrusive_list<item>::base_hook
+{
+}; // class item
+
+typedef sp_intrusive_list<item>     item_list;
+typedef detail::shared_ptr<item>    item_ptr;
+typedef std::vector<item_ptr>       item_vector;
+
+item_vector create_items(std::size_t count)
+{
+  item_vector items;
+  items.reserve(count);
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    items.push_back(detail::make_shared<item>());
+  }
+  return items;
+}
+
+void push_front_erase(benchmark::State& state)
+{
+  const item_vector items =
+      create_items(static_cast<std::size_t>(state.range(0)));
+  item_list list;
+  for (auto _ : state)
+  {
+    for (item_vector::const_iterator i = items.begin(), end = items.end();
+        i != end; ++i)
+    {
+      list.push_front(*i);
+    }
+    // Erase in the order of insertion, i.e. from the back of list
+    for (item_vector::const_iterator i = items.begin(), end = items.end();
+        i != end; ++i)
+    {
+      list.erase(*i);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+      * static_cast<int64_t>(items.size()));
+}
+
+BENCHMARK(push_front_erase)->Arg(1)->Arg(100)->Arg(10000);
+
+void erase_middle(benchmark::State& state)
+{
+  const item_vector items =
+      create_items(static_cast<std::size_t>(state.range(0)));
+  item_list list;
+  for (item_vector::const_iterator i = items.begin(), end = items.end();
+      i != end; ++i)
+  {
+    list.push_front(*i);
+  }
+  const item_ptr& middle = items[items.size() / 2];
+  for (auto _ : state)
+  {
+    list.erase(middle);
+    list.push_front(middle);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(erase_middle)->Arg(100)->Arg(10000);
+
+} // namespace benchmark_sp_intrusive_list
+} // namespace ma
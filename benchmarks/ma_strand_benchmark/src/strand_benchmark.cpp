@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <benchmark/benchmark.h>
+#include <ma/config.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/strand.hpp>
+
+namespace ma {
+namespace benchmark_strand {
+
+class counting_handler
+{
+public:
+  explicit counting_handler(std::size_t& counter)
+    : counter_(&counter)
+  {
+  }
+
+  void operator()()
+  {
+    ++*counter_;
+  }
+
+private:
+  std::size_t* counter_;
+}; // class counting_handler
+
+// Number of handlers posted at once is given by benchmark argument, so
+// the cost of queueing is measured too.
+
+void io_service_post(benchmark::State& state)
+{
+  const std::size_t batch_size = static_cast<std::size_t>(state.range(0));
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    for (std::size_t i = 0; i != batch_size; ++i)
+    {
+      io_service.post(counting_handler(counter));
+    }
+    io_service.poll();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(io_service_post)->Arg(1)->Arg(100);
+
+void strand_post(benchmark::State& state)
+{
+  const std::size_t batch_size = static_cast<std::size_t>(state.range(0));
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  strand strand(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    for (std::size_t i = 0; i != batch_size; ++i)
+    {
+      strand.post(counting_handler(counter));
+    }
+    io_service.poll();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(strand_post)->Arg(1)->Arg(100);
+
+class dispatching_handler
+{
+public:
+  dispatching_handler(strand& strand, std::size_t batch_size,
+      std::size_t& counter)
+    : strand_(&strand)
+    , batch_size_(batch_size)
+    , counter_(&counter)
+  {
+  }
+
+  void operator()()
+  {
+    for (std::size_t i = 0; i != batch_size_; ++i)
+    {
+      strand_->dispatch(counting_handler(*counter_));
+    }
+  }
+
+private:
+  strand*      strand_;
+  std::size_t  batch_size_;
+  std::size_t* counter_;
+}; // class dispatching_handler
+
+void strand_dispatch(benchmark::State& state)
+{
+  const std::size_t batch_size = static_cast<std::size_t>(state.range(0));
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  strand strand(io_service);
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    // Handlers are invoked inside dispatch because it is called by
+    // the thread running io_service and strand is not running at this
+    // moment in any other thread
+    io_service.post(dispatching_handler(strand, batch_size, counter));
+    io_service.poll();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(strand_dispatch)->Arg(1)->Arg(100);
+
+void strand_wrapped_post(benchmark::State& state)
+{
+  boost::asio::io_service io_service(1);
+  boost::asio::io_service::work work(io_service);
+  strand strand(io_service);
+  in_place_handler_allocator<256> allocator;
+  std::size_t counter = 0;
+  for (auto _ : state)
+  {
+    // The way the handlers of async operations are wrapped by sessions
+    io_service.post(strand.wrap(make_custom_alloc_handler(allocator,
+        counting_handler(counter))));
+    io_service.poll();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(counter));
+}
+
+BENCHMARK(strand_wrapped_post);
+
+} // namespace benchmark_strand
+} // namespace ma
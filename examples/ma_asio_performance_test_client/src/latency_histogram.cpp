@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <iomanip>
+#include "latency_histogram.hpp"
+
+namespace performance_test_client {
+
+namespace {
+
+const unsigned    sub_bucket_bits      = 5;
+const std::size_t sub_bucket_count     = std::size_t(1) << sub_bucket_bits;
+const std::size_t linear_bucket_count  = sub_bucket_count * 2;
+
+unsigned most_significant_bit(latency_histogram::value_type value)
+{
+  unsigned bit = 0;
+  while (value >>= 1)
+  {
+    ++bit;
+  }
+  return bit;
+}
+
+} // anonymous namespace
+
+latency_histogram::latency_histogram()
+  : buckets_()
+  , count_(0)
+  , min_((std::numeric_limits<value_type>::max)())
+  , max_(0)
+  , sum_(0)
+{
+}
+
+void latency_histogram::record(value_type value)
+{
+  const std::size_t index = bucket_index(value);
+  if (buckets_.size() <= index)
+  {
+    buckets_.resize(index + 1);
+  }
+  ++buckets_[index];
+  ++count_;
+  min_ = (std::min)(min_, value);
+  max_ = (std::max)(max_, value);
+  sum_ += static_cast<double>(value);
+}
+
+void latency_histogram::merge(const latency_histogram& other)
+{
+  if (!other.count_)
+  {
+    return;
+  }
+  if (buckets_.size() < other.buckets_.size())
+  {
+    buckets_.resize(other.buckets_.size());
+  }
+  for (std::size_t i = 0, size = other.buckets_.size(); i != size; ++i)
+  {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  min_ = (std::min)(min_, other.min_);
+  max_ = (std::max)(max_, other.max_);
+  sum_ += other.sum_;
+}
+
+void latency_histogram::reset()
+{
+  buckets_.clear();
+  count_ = 0;
+  min_ = (std::numeric_limits<value_type>::max)();
+  max_ = 0;
+  sum_ = 0;
+}
+
+void latency_histogram::save(std::ostream& stream) const
+{
+  stream << count_ << ' ' << min_ << ' ' << max_ << ' '
+         << std::setprecision(17) << sum_ << ' ' << buckets_.size();
+  for (std::vector<count_type>::const_iterator i = buckets_.begin(),
+      end = buckets_.end(); i != end; ++i)
+  {
+    stream << ' ' << *i;
+  }
+  stream << '\n';
+}
+
+bool latency_histogram::load(std::istream& stream)
+{
+  latency_histogram loaded;
+  std::size_t bucket_count = 0;
+  if (!(stream >> loaded.count_ >> loaded.min_ >> loaded.max_ >> loaded.sum_
+      >> bucket_count))
+  {
+    return false;
+  }
+  loaded.buckets_.resize(bucket_count);
+  for (std::size_t i = 0; i != bucket_count; ++i)
+  {
+    if (!(stream >> loaded.buckets_[i]))
+    {
+      return false;
+    }
+  }
+  *this = loaded;
+  return true;
+}
+
+latency_histogram::count_type latency_histogram::count() const
+{
+  return count_;
+}
+
+latency_histogram::value_type latency_histogram::min() const
+{
+  return count_ ? min_ : 0;
+}
+
+latency_histogram::value_type latency_histogram::max() const
+{
+  return max_;
+}
+
+double latency_histogram::mean() const
+{
+  return count_ ? sum_ / static_cast<double>(count_) : 0;
+}
+
+latency_histogram::value_type latency_histogram::value_at_percentile(
+    double percentile) const
+{
+  if (!count_)
+  {
+    return 0;
+  }
+
+  const double clamped_percentile = (std::min)(100.0, (std::max)(0.0,
+      percentile));
+  count_type required_count = static_cast<count_type>(std::ceil(
+      clamped_percentile * static_cast<double>(count_) / 100));
+  if (!required_count)
+  {
+    required_count = 1;
+  }
+
+  count_type seen_count = 0;
+  for (std::size_t i = 0, size = buckets_.size(); i != size; ++i)
+  {
+    seen_count += buckets_[i];
+    if (seen_count >= required_count)
+    {
+      return (std::min)(bucket_upper_bound(i), max_);
+    }
+  }
+  return max_;
+}
+
+std::size_t latency_histogram::bucket_index(value_type value)
+{
+  if (value < linear_bucket_count)
+  {
+    return static_cast<std::size_t>(value);
+  }
+  // Keep sub_bucket_bits + 1 most significant bits of value
+  const unsigned shift = most_significant_bit(value) - sub_bucket_bits;
+  const std::size_t sub_bucket =
+      static_cast<std::size_t>(value >> shift) - sub_bucket_count;
+  return linear_bucket_count + (shift - 1) * sub_bucket_count + sub_bucket;
+}
+
+latency_histogram::value_type latency_histogram::bucket_upper_bound(
+    std::size_t index)
+{
+  if (index < linear_bucket_count)
+  {
+    return index;
+  }
+  const std::size_t exp_index = index - linear_bucket_count;
+  const unsigned shift = static_cast<unsigned>(exp_index / sub_bucket_count) + 1;
+  const value_type sub_bucket = exp_index % sub_bucket_count + sub_bucket_count;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+} // namespace performance_test_client
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <boost/cstdint.hpp>
+
+namespace performance_test_client {
+
+/// Histogram of latencies (microseconds) with log-linear buckets.
+/**
+ * Values less than linear_bucket_count are recorded exactly, greater values
+ * are recorded with relative error not greater than 1 / sub_bucket_count
+ * (~3%). Buckets are allocated on demand, so histogram of small latencies
+ * stays small.
+ */
+class latency_histogram
+{
+public:
+  typedef boost::uint64_t value_type;
+  typedef boost::uint64_t count_type;
+
+  latency_histogram();
+
+  void record(value_type value);
+  void merge(const latency_histogram& other);
+  void reset();
+
+  /// Writes histogram in text form which can be read back by load.
+  void save(std::ostream& stream) const;
+  /// Returns false if stream doesn't hold valid histogram.
+  bool load(std::istream& stream);
+
+  count_type count() const;
+  value_type min() const;
+  value_type max() const;
+  double mean() const;
+
+  /// Returns the (upper bound of) value which is not exceeded by the given
+  /// percentage (0..100) of recorded values.
+  value_type value_at_percentile(double percentile) const;
+
+private:
+  static std::size_t bucket_index(value_type value);
+  static value_type  bucket_upper_bound(std::size_t index);
+
+  std::vector<count_type> buckets_;
+  count_type count_;
+  value_type min_;
+  value_type max_;
+  double     sum_;
+}; // class latency_histogram
+
+} // namespace performance_test_client
+
+#endif // LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef LIVE_STATS_HPP
+#define LIVE_STATS_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <ma/detail/atomic.hpp>
+
+namespace performance_test_client {
+
+/// Counters updated by sessions during the test and read by stats_sampler.
+/**
+ * Counters are split into slots - one slot per io_service (i.e. per work
+ * thread in demultiplexer-per-work-thread mode) - so sessions of different
+ * threads never write into the same cache line. Readers sum up the slots
+ * without locking, so the snapshot is not consistent across slots.
+ */
+class live_stats : private boost::noncopyable
+{
+public:
+  struct snapshot
+  {
+    snapshot();
+
+    boost::uint64_t connected_sessions;
+    boost::uint64_t connects;
+    boost::uint64_t bytes_written;
+    boost::uint64_t bytes_read;
+    boost::uint64_t messages;
+  }; // struct snapshot
+
+  class counters : private boost::noncopyable
+  {
+  public:
+    counters();
+
+    void session_connected();
+    void session_disconnected();
+    void add_connects(std::size_t count);
+    void add_bytes_written(std::size_t size);
+    void add_bytes_read(std::size_t size);
+    void add_messages(std::size_t count);
+
+  private:
+    friend class live_stats;
+
+    typedef ma::detail::atomic<boost::uint64_t> counter_type;
+
+    static void add(counter_type& counter, boost::uint64_t value);
+    void add_to(snapshot& values) const;
+
+    counter_type connected_sessions_;
+    counter_type connects_;
+    counter_type bytes_written_;
+    counter_type bytes_read_;
+    counter_type messages_;
+    // Keeps the counters of adjacent slots in different cache lines
+    char padding_[64];
+  }; // class counters
+
+  explicit live_stats(std::size_t counters_count);
+
+  counters& counters_at(std::size_t index);
+  snapshot get() const;
+
+private:
+  const std::size_t counters_count_;
+  boost::scoped_array<counters> counters_;
+}; // class live_stats
+
+inline live_stats::snapshot::snapshot()
+  : connected_sessions(0)
+  , connects(0)
+  , bytes_written(0)
+  , bytes_read(0)
+  , messages(0)
+{
+}
+
+inline live_stats::counters::counters()
+  : connected_sessions_(0)
+  , connects_(0)
+  , bytes_written_(0)
+  , bytes_read_(0)
+  , messages_(0)
+{
+}
+
+inline void live_stats::counters::session_connected()
+{
+  add(connected_sessions_, 1);
+}
+
+inline void live_stats::counters::session_disconnected()
+{
+  connected_sessions_.fetch_sub(1, ma::detail::memory_order_relaxed);
+}
+
+inline void live_stats::counters::add_connects(std::size_t count)
+{
+  add(connects_, count);
+}
+
+inline void live_stats::counters::add_bytes_written(std::size_t size)
+{
+  add(bytes_written_, size);
+}
+
+inline void live_stats::counters::add_bytes_read(std::size_t size)
+{
+  add(bytes_read_, size);
+}
+
+inline void live_stats::counters::add_messages(std::size_t count)
+{
+  add(messages_, count);
+}
+
+inline void live_stats::counters::add(counter_type& counter,
+    boost::uint64_t value)
+{
+  // Counters are used only for statistics so no ordering is required.
+  // Slot is not shared by different threads in
+  // demultiplexer-per-work-thread mode so there is no contention.
+  counter.fetch_add(value, ma::detail::memory_order_relaxed);
+}
+
+inline void live_stats::counters::add_to(snapshot& values) const
+{
+  values.connected_sessions +=
+      connected_sessions_.load(ma::detail::memory_order_relaxed);
+  values.connects += connects_.load(ma::detail::memory_order_relaxed);
+  values.bytes_written += bytes_written_.load(ma::detail::memory_order_relaxed);
+  values.bytes_read += bytes_read_.load(ma::detail::memory_order_relaxed);
+  values.messages += messages_.load(ma::detail::memory_order_relaxed);
+}
+
+inline live_stats::live_stats(std::size_t counters_count)
+  : counters_count_(counters_count)
+  , counters_(new counters[counters_count])
+{
+  BOOST_ASSERT_MSG(counters_count > 0, "counters_count must be > 0");
+}
+
+inline live_stats::counters& live_stats::counters_at(std::size_t index)
+{
+  BOOST_ASSERT_MSG(index < counters_count_, "index is out of range");
+  return counters_[index];
+}
+
+inline live_stats::snapshot live_stats::get() const
+{
+  snapshot values;
+  for (std::size_t i = 0; i != counters_count_; ++i)
+  {
+    counters_[i].add_to(values);
+  }
+  return values;
+}
+
+} // namespace performance_test_client
+
+#endif // LIVE_STATS_HPP
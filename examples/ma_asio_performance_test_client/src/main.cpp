@@ -12,12 +12,18 @@
 #include <tchar.h>
 #endif
 
+#include <cmath>
 #include <cstdlib>
 #include <cstddef>
+#include <deque>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <exception>
 #include <boost/assert.hpp>
 #include <boost/asio.hpp>
@@ -25,6 +31,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/logic/tribool.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
 #include <boost/program_options.hpp>
 #include <boost/optional.hpp>
 #include <boost/utility/in_place_factory.hpp>
@@ -41,13 +48,34 @@
 #include <ma/detail/memory.hpp>
 #include <ma/detail/functional.hpp>
 #include <ma/detail/thread.hpp>
+#include <ma/detail/atomic.hpp>
 
 #if defined(MA_HAS_BOOST_TIMER)
 #include <boost/timer/timer.hpp>
 #endif // defined(MA_HAS_BOOST_TIMER)
 
+#include "latency_histogram.hpp"
+#include "payload_sequence.hpp"
+#include "live_stats.hpp"
+#include "stats_sampler.hpp"
+#include "process_group.hpp"
+#include "xorshift_engine.hpp"
+#include "size_distribution.hpp"
+#include "size_bucket_stats.hpp"
+
 namespace {
 
+using performance_test_client::latency_histogram;
+using performance_test_client::payload_sequence;
+using performance_test_client::live_stats;
+using performance_test_client::stats_sampler;
+using performance_test_client::sample_output_format;
+using performance_test_client::process_group;
+using performance_test_client::xorshift_engine;
+using performance_test_client::size_distribution;
+using performance_test_client::size_distribution_type;
+using performance_test_client::size_bucket_stats;
+
 class work_state : private boost::noncopyable
 {
 private:
@@ -64,10 +92,10 @@ public:
 
   void dec_outstanding()
   {
-    lock_guard_type lock(mutex_);
-    --outstanding_;
-    if (!outstanding_)
+    // Mutex is locked only by the last one to not miss notification
+    if (1 == outstanding_.fetch_sub(1, ma::detail::memory_order_acq_rel))
     {
+      lock_guard_type lock(mutex_);
       condition_.notify_all();
     }
   }
@@ -75,7 +103,7 @@ public:
   void wait(const boost::posix_time::time_duration& timeout)
   {
     unique_lock_type lock(mutex_);
-    while (outstanding_)
+    while (outstanding_.load(ma::detail::memory_order_acquire))
     {
       if (!condition_.timed_wait(lock, timeout))
       {
@@ -85,7 +113,7 @@ public:
   }
 
 private:
-  std::size_t outstanding_;
+  ma::detail::atomic<std::size_t> outstanding_;
   mutex_type  mutex_;
   condition_variable_type condition_;
 }; // class work_state
@@ -111,22 +139,132 @@ std::string to_string(const ma::limited_int<Integer>& limited_value)
   }
 }
 
+void save(std::ostream& stream, const limited_counter& value)
+{
+  stream << value.value() << ' ' << value.overflowed() << ' ';
+}
+
+bool load(std::istream& stream, limited_counter& value)
+{
+  limited_counter::value_type loaded_value;
+  bool overflowed;
+  if (!(stream >> loaded_value >> overflowed))
+  {
+    return false;
+  }
+  value = limited_counter(loaded_value);
+  if (overflowed)
+  {
+    value = limited_counter((limited_counter::max)());
+    ++value;
+  }
+  return true;
+}
+
 class stats : private boost::noncopyable
 {
 public:
   stats()
     : total_sessions_connected_()
+    , total_connects_()
     , total_bytes_written_()
     , total_bytes_read_()
+    , total_bytes_verified_()
+    , total_verification_failures_()
+    , total_scheduled_sends_()
+    , total_late_sends_()
+    , total_unsent_messages_()
+    , round_trip_times_()
+    , connect_times_()
+    , size_buckets_()
   {
   }
 
-  void add(const limited_counter& bytes_written,
-      const limited_counter& bytes_read)
+  void add(const limited_counter& connects,
+      const limited_counter& bytes_written,
+      const limited_counter& bytes_read,
+      const limited_counter& bytes_verified,
+      bool verification_failed,
+      const limited_counter& scheduled_sends,
+      const limited_counter& late_sends,
+      std::size_t unsent_messages,
+      const latency_histogram& round_trip_times,
+      const latency_histogram& connect_times,
+      const size_bucket_stats& size_buckets)
   {
     ++total_sessions_connected_;
-    total_bytes_written_ += bytes_written;
-    total_bytes_read_    += bytes_read;
+    total_connects_        += connects;
+    total_bytes_written_   += bytes_written;
+    total_bytes_read_      += bytes_read;
+    total_bytes_verified_  += bytes_verified;
+    if (verification_failed)
+    {
+      ++total_verification_failures_;
+    }
+    total_scheduled_sends_ += scheduled_sends;
+    total_late_sends_      += late_sends;
+    total_unsent_messages_ += unsent_messages;
+    round_trip_times_.merge(round_trip_times);
+    connect_times_.merge(connect_times);
+    size_buckets_.merge(size_buckets);
+  }
+
+  void merge(const stats& other)
+  {
+    total_sessions_connected_    += other.total_sessions_connected_;
+    total_connects_              += other.total_connects_;
+    total_bytes_written_         += other.total_bytes_written_;
+    total_bytes_read_            += other.total_bytes_read_;
+    total_bytes_verified_        += other.total_bytes_verified_;
+    total_verification_failures_ += other.total_verification_failures_;
+    total_scheduled_sends_       += other.total_scheduled_sends_;
+    total_late_sends_            += other.total_late_sends_;
+    total_unsent_messages_       += other.total_unsent_messages_;
+    round_trip_times_.merge(other.round_trip_times_);
+    connect_times_.merge(other.connect_times_);
+    size_buckets_.merge(other.size_buckets_);
+  }
+
+  bool has_verification_failures() const
+  {
+    return 0 != total_verification_failures_.value();
+  }
+
+  /// Writes stats in text form which can be read back by load.
+  void save(std::ostream& stream) const
+  {
+    using ::save;
+    save(stream, total_sessions_connected_);
+    save(stream, total_connects_);
+    save(stream, total_bytes_written_);
+    save(stream, total_bytes_read_);
+    save(stream, total_bytes_verified_);
+    save(stream, total_verification_failures_);
+    save(stream, total_scheduled_sends_);
+    save(stream, total_late_sends_);
+    save(stream, total_unsent_messages_);
+    stream << '\n';
+    round_trip_times_.save(stream);
+    connect_times_.save(stream);
+    size_buckets_.save(stream);
+  }
+
+  /// Returns false if stream doesn't hold valid stats.
+  bool load(std::istream& stream)
+  {
+    using ::load;
+    return load(stream, total_sessions_connected_)
+        && load(stream, total_connects_)
+        && load(stream, total_bytes_written_)
+        && load(stream, total_bytes_read_)
+        && load(stream, total_bytes_verified_)
+        && load(stream, total_verification_failures_)
+        && load(stream, total_scheduled_sends_)
+        && load(stream, total_late_sends_)
+        && load(stream, total_unsent_messages_)
+        && round_trip_times_.load(stream)
+        && connect_times_.load(stream)
+        && size_buckets_.load(stream);
   }
 
   void print()
@@ -140,26 +278,164 @@ public:
               << "Total bytes read        : "
               << to_string(total_bytes_read_)
               << std::endl;
+
+    if (total_bytes_verified_.value() || total_verification_failures_.value())
+    {
+      std::cout << "Total bytes verified    : "
+                << to_string(total_bytes_verified_)
+                << std::endl
+                << "Verification failures   : "
+                << to_string(total_verification_failures_)
+                << std::endl;
+    }
+
+    if (total_scheduled_sends_.value())
+    {
+      std::cout << "Total scheduled sends   : "
+                << to_string(total_scheduled_sends_)
+                << std::endl
+                << "Total late sends        : "
+                << to_string(total_late_sends_)
+                << std::endl
+                << "Total unsent messages   : "
+                << to_string(total_unsent_messages_)
+                << std::endl;
+    }
+
+    if (round_trip_times_.count())
+    {
+      std::cout << "Total round trips       : "
+                << integer_to_string(round_trip_times_.count())
+                << std::endl;
+      print("Round trip time (microseconds)", round_trip_times_);
+    }
+
+    // Connects are recorded only in churn mode
+    if (connect_times_.count())
+    {
+      std::cout << "Total connects          : "
+                << to_string(total_connects_)
+                << std::endl;
+      print("Connect time (microseconds)", connect_times_);
+    }
+
+    if (size_buckets_.used_bucket_count() > 1)
+    {
+      print(size_buckets_);
+    }
   }
 
 private:
+  static void print(const char* title, const latency_histogram& histogram)
+  {
+    std::cout << title
+              << std::endl
+              << "  min   : " << histogram.min()
+              << std::endl
+              << "  mean  : " << std::fixed << std::setprecision(1)
+              << histogram.mean()
+              << std::endl;
+
+    const double percentiles[] = {50, 90, 99, 99.9, 99.99};
+    for (std::size_t i = 0; i != sizeof(percentiles) / sizeof(percentiles[0]);
+        ++i)
+    {
+      std::ostringstream name;
+      name << 'p' << percentiles[i];
+      std::cout << "  " << std::setw(6) << std::left << name.str() << ": "
+                << histogram.value_at_percentile(percentiles[i])
+                << std::endl;
+    }
+
+    std::cout << "  max   : " << histogram.max()
+              << std::endl;
+  }
+
+  static void print(const size_bucket_stats& size_buckets)
+  {
+    std::cout << "Writes by size (bytes)"
+              << std::endl;
+    for (std::size_t i = 0, count = size_buckets.bucket_count(); i != count;
+        ++i)
+    {
+      const size_bucket_stats::bucket& bucket = size_buckets.bucket_at(i);
+      if (!bucket.writes)
+      {
+        continue;
+      }
+
+      std::ostringstream range;
+      range << size_bucket_stats::bucket_lower_bound(i) << '-'
+            << size_bucket_stats::bucket_upper_bound(i);
+      std::cout << "  " << std::setw(21) << std::left << range.str()
+                << ": writes: " << bucket.writes
+                << ", bytes: " << bucket.bytes;
+      const latency_histogram& round_trip_times = bucket.round_trip_times;
+      if (round_trip_times.count())
+      {
+        std::cout << ", round trip time (microseconds) p50: "
+                  << round_trip_times.value_at_percentile(50)
+                  << ", p99: "
+                  << round_trip_times.value_at_percentile(99)
+                  << ", max: " << round_trip_times.max();
+      }
+      std::cout << std::endl;
+    }
+  }
+
   limited_counter total_sessions_connected_;
+  limited_counter total_connects_;
   limited_counter total_bytes_written_;
   limited_counter total_bytes_read_;
+  limited_counter total_bytes_verified_;
+  limited_counter total_verification_failures_;
+  limited_counter total_scheduled_sends_;
+  limited_counter total_late_sends_;
+  limited_counter total_unsent_messages_;
+  latency_histogram round_trip_times_;
+  latency_histogram connect_times_;
+  size_bucket_stats size_buckets_;
 }; // class stats
 
 typedef boost::logic::tribool tribool;
 typedef boost::optional<int>  optional_int;
+typedef boost::optional<double> optional_double;
+typedef ma::steady_deadline_timer      deadline_timer;
+typedef deadline_timer::duration_type  duration_type;
+typedef boost::optional<duration_type> optional_duration;
+
+struct test_mode
+{
+  // stream    - write and read as fast as possible (throughput),
+  // ping_pong - write message, wait for its echo, measure round trip time,
+  // open_loop - write messages by fixed schedule not waiting for echo,
+  //             measure time from scheduled send till receipt of echo,
+  // churn     - connect, exchange single message, close connection and
+  //             start again, measure connect time and rate
+  enum value_t {stream, ping_pong, open_loop, churn};
+};
 
 struct session_config
 {
 public:
-  session_config(std::size_t the_buffer_size,
+  session_config(test_mode::value_t the_mode,
+      std::size_t the_buffer_size,
+      std::size_t the_message_size,
+      const size_distribution& the_message_sizes,
+      const optional_double& the_send_interval,
+      std::size_t the_send_phase_count,
+      bool the_verify,
       std::size_t the_max_connect_attempts,
       const optional_int& the_socket_recv_buffer_size,
       const optional_int& the_socket_send_buffer_size,
       const tribool& the_no_delay)
-    : buffer_size(the_buffer_size)
+    : mode(the_mode)
+    , buffer_size(the_buffer_size)
+    , message_size(the_message_size)
+    , message_sizes(the_message_sizes)
+    , send_interval(the_send_interval)
+    , send_phase_count(the_send_phase_count)
+    , verify(the_verify)
     , max_connect_attempts(the_max_connect_attempts)
     , socket_recv_buffer_size(the_socket_recv_buffer_size)
     , socket_send_buffer_size(the_socket_send_buffer_size)
@@ -167,6 +443,22 @@ public:
   {
     BOOST_ASSERT_MSG(the_buffer_size > 0, "buffer_size must be > 0");
 
+    BOOST_ASSERT_MSG(the_message_size > 0, "message_size must be > 0");
+
+    BOOST_ASSERT_MSG((test_mode::stream != the_mode)
+        || (the_message_sizes.max_size() <= the_buffer_size),
+        "message_sizes must not exceed buffer_size in stream mode");
+
+    BOOST_ASSERT_MSG((test_mode::open_loop != the_mode)
+        || (the_send_interval && (*the_send_interval > 0)),
+        "send_interval must be defined and > 0 for open loop mode");
+
+    BOOST_ASSERT_MSG(the_send_phase_count > 0,
+        "send_phase_count must be > 0");
+
+    BOOST_ASSERT_MSG((test_mode::stream == the_mode) || !the_verify,
+        "verify is supported only for stream mode");
+
     BOOST_ASSERT_MSG(
         !the_socket_recv_buffer_size || (*the_socket_recv_buffer_size) >= 0,
         "Defined socket_recv_buffer_size must be >= 0");
@@ -176,7 +468,20 @@ public:
         "Defined socket_send_buffer_size must be >= 0");
   }
 
+  test_mode::value_t mode;
   std::size_t   buffer_size;
+  std::size_t   message_size;
+  /// Sizes of writes. Fixed distribution in stream mode means writing of all
+  /// available data.
+  size_distribution message_sizes;
+  /// Interval between scheduled sends of session in open loop mode
+  /// (microseconds, fractional).
+  optional_double send_interval;
+  /// Sessions with index i start sending at i * send_interval /
+  /// send_phase_count (modulo send_interval), so sends of different sessions
+  /// are spread over the interval instead of coming in bursts.
+  std::size_t   send_phase_count;
+  bool          verify;
   std::size_t   max_connect_attempts;
   optional_int  socket_recv_buffer_size;
   optional_int  socket_send_buffer_size;
@@ -186,28 +491,81 @@ public:
 class session : private boost::noncopyable
 {
   typedef session this_type;
+  typedef deadline_timer::time_type   time_type;
+  typedef deadline_timer::traits_type time_traits_type;
+
+  struct message_info
+  {
+    message_info(const time_type& the_time, std::size_t the_size)
+      : time(the_time)
+      , size(the_size)
+    {
+    }
+
+    time_type   time;
+    std::size_t size;
+  }; // struct message_info
+
+  typedef std::deque<message_info> message_queue;
 
 public:
   typedef boost::asio::ip::tcp protocol;
 
   session(boost::asio::io_service& io_service, const session_config& config,
-      work_state& work_state)
-    : max_connect_attempts_(config.max_connect_attempts)
+      std::size_t index, work_state& work_state,
+      live_stats::counters& live_counters)
+    : mode_(config.mode)
+    , send_interval_(config.send_interval)
+    , send_phase_(send_phase(config, index))
+    , verify_(config.verify)
+    , sized_writes_((test_mode::stream != config.mode)
+        || (size_distribution_type::fixed != config.message_sizes.type()))
+    , max_connect_attempts_(config.max_connect_attempts)
     , socket_recv_buffer_size_(config.socket_recv_buffer_size)
     , socket_send_buffer_size_(config.socket_send_buffer_size)
     , no_delay_(config.no_delay)
     , strand_(io_service)
     , socket_(io_service)
+    , send_timer_(io_service)
     , buffer_(config.buffer_size)
+    , message_()
+    , reply_()
+    , message_sizes_(config.message_sizes)
+    , size_engine_(size_seed(index))
+    , initial_endpoint_iterator_()
+    , connects_()
     , bytes_written_()
     , bytes_read_()
+    , bytes_verified_()
+    , send_sequence_(payload_seed(index))
+    , check_sequence_(payload_seed(index))
+    , scheduled_sends_()
+    , late_sends_()
+    , round_trip_times_()
+    , connect_times_()
+    , size_buckets_()
+    , ping_start_time_()
+    , connect_start_time_()
+    , send_start_time_()
+    , next_send_time_()
+    , next_send_index_(0)
+    , warmup_end_time_()
+    , unsent_messages_()
+    , sent_messages_()
+    , reply_size_(0)
+    , ping_size_(0)
+    , write_size_(0)
     , connected_(false)
     , write_in_progress_(false)
     , read_in_progress_(false)
+    , timer_in_progress_(false)
     , started_(false)
     , stopped_(false)
     , was_connected_(false)
+    , measuring_(false)
+    , verification_failed_(false)
     , work_state_(work_state)
+    , live_counters_(live_counters)
   {
     typedef ma::cyclic_buffer::mutable_buffers_type buffers_type;
     std::size_t filled_size = config.buffer_size / 2;
@@ -220,10 +578,30 @@ public:
       std::size_t s = boost::asio::buffer_size(*i);
       for (; size_to_fill && s; ++b, --size_to_fill, --s)
       {
-        *b = static_cast<char>(config.buffer_size % 128);
+        *b = verify_ ? static_cast<char>(send_sequence_.next())
+            : static_cast<char>(config.buffer_size % 128);
       }
     }
     buffer_.consume(filled_size);
+
+    switch (mode_)
+    {
+    case test_mode::ping_pong:
+    case test_mode::churn:
+      message_.assign(message_sizes_.max_size(),
+          static_cast<char>(config.message_size % 128));
+      reply_.resize(message_sizes_.max_size());
+      break;
+
+    case test_mode::open_loop:
+      message_.assign(message_sizes_.max_size(),
+          static_cast<char>(config.message_size % 128));
+      reply_.resize(config.buffer_size);
+      break;
+
+    default:
+      break;
+    }
   }
 
   ~session()
@@ -231,14 +609,18 @@ public:
     BOOST_ASSERT_MSG(!connected_, "Invalid connect state");
     BOOST_ASSERT_MSG(!read_in_progress_, "Invalid read state");
     BOOST_ASSERT_MSG(!write_in_progress_, "Invalid write state");
+    BOOST_ASSERT_MSG(!timer_in_progress_, "Invalid timer state");
     BOOST_ASSERT_MSG(!started_ || (started_ && stopped_),
         "Session was not stopped");
   }
 
-  void async_start(const protocol::resolver::iterator& endpoint_iterator)
+  /// Statistics collected till warmup_end_time are not included into totals.
+  void async_start(const protocol::resolver::iterator& endpoint_iterator,
+      const time_type& warmup_end_time)
   {
     strand_.post(ma::make_custom_alloc_handler(write_allocator_,
-        ma::detail::bind(&this_type::do_start, this, endpoint_iterator)));
+        ma::detail::bind(&this_type::do_start, this, endpoint_iterator,
+            warmup_end_time)));
   }
 
   void async_stop()
@@ -252,6 +634,11 @@ public:
     return was_connected_;
   }
 
+  limited_counter connects() const
+  {
+    return connects_;
+  }
+
   limited_counter bytes_written() const
   {
     return bytes_written_;
@@ -262,8 +649,49 @@ public:
     return bytes_read_;
   }
 
+  limited_counter bytes_verified() const
+  {
+    return bytes_verified_;
+  }
+
+  bool verification_failed() const
+  {
+    return verification_failed_;
+  }
+
+  limited_counter scheduled_sends() const
+  {
+    return scheduled_sends_;
+  }
+
+  limited_counter late_sends() const
+  {
+    return late_sends_;
+  }
+
+  std::size_t unsent_messages() const
+  {
+    return unsent_messages_.size();
+  }
+
+  const latency_histogram& round_trip_times() const
+  {
+    return round_trip_times_;
+  }
+
+  const latency_histogram& connect_times() const
+  {
+    return connect_times_;
+  }
+
+  const size_bucket_stats& size_buckets() const
+  {
+    return size_buckets_;
+  }
+
 private:
-  void do_start(const protocol::resolver::iterator& initial_endpoint_iterator)
+  void do_start(const protocol::resolver::iterator& initial_endpoint_iterator,
+      const time_type& warmup_end_time)
   {
     if (stopped_)
     {
@@ -271,6 +699,7 @@ private:
     }
 
     started_ = true;
+    warmup_end_time_ = warmup_end_time;
     start_connect(0, initial_endpoint_iterator, initial_endpoint_iterator);
   }
 
@@ -292,6 +721,7 @@ private:
       const protocol::resolver::iterator& initial_endpoint_iterator,
       const protocol::resolver::iterator& current_endpoint_iterator)
   {
+    connect_start_time_ = time_traits_type::now();
     protocol::endpoint endpoint = *current_endpoint_iterator;
     ma::async_connect(socket_, endpoint, strand_.wrap(
         ma::make_custom_alloc_handler(write_allocator_,
@@ -306,7 +736,11 @@ private:
       protocol::resolver::iterator current_endpoint_iterator)
   {
     // Collect statistics at first step
-    was_connected_ = !error;
+    if (!error)
+    {
+      was_connected_ = true;
+      register_connect();
+    }
 
     if (stopped_)
     {
@@ -341,6 +775,7 @@ private:
     }
 
     connected_ = true;
+    live_counters_.session_connected();
 
     if (apply_socket_options())
     {
@@ -348,8 +783,330 @@ private:
       return;
     }
 
-    start_write_some();
-    start_read_some();
+    switch (mode_)
+    {
+    case test_mode::ping_pong:
+    case test_mode::churn:
+      initial_endpoint_iterator_ = initial_endpoint_iterator;
+      start_ping();
+      break;
+
+    case test_mode::open_loop:
+      send_start_time_ = time_traits_type::now();
+      next_send_index_ = 0;
+      next_send_time_  = scheduled_send_time(next_send_index_);
+      schedule_sends();
+      start_reply_read();
+      break;
+
+    default:
+      start_write_some();
+      start_read_some();
+      break;
+    }
+  }
+
+  void schedule_sends()
+  {
+    // Schedule all sends which time has come. Sends are never skipped, so
+    // the echo latency of the late sends includes the time they were delayed
+    const time_type now = time_traits_type::now();
+    while (!time_traits_type::less_than(now, next_send_time_))
+    {
+      unsent_messages_.push_back(
+          message_info(next_send_time_, message_sizes_(size_engine_)));
+      if (is_measuring())
+      {
+        ++scheduled_sends_;
+      }
+      next_send_time_ = scheduled_send_time(++next_send_index_);
+    }
+
+    if (!write_in_progress_ && !unsent_messages_.empty())
+    {
+      start_scheduled_write();
+    }
+
+    send_timer_.expires_at(next_send_time_);
+    send_timer_.async_wait(strand_.wrap(
+        ma::make_custom_alloc_handler(timer_allocator_,
+            ma::detail::bind(&this_type::handle_send_timer, this,
+                ma::detail::placeholders::_1))));
+    timer_in_progress_ = true;
+  }
+
+  void handle_send_timer(const boost::system::error_code& error)
+  {
+    timer_in_progress_ = false;
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (error && (boost::asio::error::operation_aborted != error))
+    {
+      stop();
+      return;
+    }
+
+    schedule_sends();
+  }
+
+  void start_scheduled_write()
+  {
+    const message_info message = unsent_messages_.front();
+    unsent_messages_.pop_front();
+    const boost::int64_t delay = time_traits_type::to_posix_duration(
+        time_traits_type::subtract(time_traits_type::now(), message.time))
+            .total_microseconds();
+    if (*send_interval_ < static_cast<double>(delay))
+    {
+      // Send can't be started in time
+      if (is_measuring())
+      {
+        ++late_sends_;
+      }
+    }
+    sent_messages_.push_back(message);
+    write_size_ = message.size;
+
+    boost::asio::async_write(socket_,
+        boost::asio::buffer(message_, message.size),
+        strand_.wrap(ma::make_custom_alloc_handler(write_allocator_,
+            ma::detail::bind(&this_type::handle_scheduled_write, this,
+                ma::detail::placeholders::_1,
+                ma::detail::placeholders::_2))));
+    write_in_progress_ = true;
+  }
+
+  void handle_scheduled_write(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    write_in_progress_ = false;
+
+    // Collect statistics at first step
+    register_bytes_written(bytes_transferred);
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    if (!unsent_messages_.empty())
+    {
+      start_scheduled_write();
+    }
+  }
+
+  void start_reply_read()
+  {
+    socket_.async_read_some(boost::asio::buffer(reply_), strand_.wrap(
+        ma::make_custom_alloc_handler(read_allocator_,
+            ma::detail::bind(&this_type::handle_reply_read, this,
+                ma::detail::placeholders::_1,
+                ma::detail::placeholders::_2))));
+    read_in_progress_ = true;
+  }
+
+  void handle_reply_read(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    read_in_progress_ = false;
+
+    // Collect statistics at first step
+    register_bytes_read(bytes_transferred);
+    reply_size_ += bytes_transferred;
+    if (!sent_messages_.empty() && (reply_size_ >= sent_messages_.front().size))
+    {
+      const time_type now = time_traits_type::now();
+      // Echo keeps the order of messages
+      while (!sent_messages_.empty()
+          && (reply_size_ >= sent_messages_.front().size))
+      {
+        const message_info& message = sent_messages_.front();
+        register_round_trip(now, message.time, message.size);
+        reply_size_ -= message.size;
+        sent_messages_.pop_front();
+      }
+    }
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (boost::asio::error::eof == error)
+    {
+      shutdown_socket();
+      stop();
+      return;
+    }
+
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    start_reply_read();
+  }
+
+  void start_ping()
+  {
+    ping_size_ = message_sizes_(size_engine_);
+    write_size_ = ping_size_;
+    ping_start_time_ = time_traits_type::now();
+
+    // Read is started at the same time as write to not block the echo of
+    // the message which is larger than socket buffers
+    boost::asio::async_write(socket_, boost::asio::buffer(message_, ping_size_),
+        strand_.wrap(ma::make_custom_alloc_handler(write_allocator_,
+            ma::detail::bind(&this_type::handle_ping_write, this,
+                ma::detail::placeholders::_1,
+                ma::detail::placeholders::_2))));
+    write_in_progress_ = true;
+
+    boost::asio::async_read(socket_, boost::asio::buffer(reply_, ping_size_),
+        strand_.wrap(ma::make_custom_alloc_handler(read_allocator_,
+            ma::detail::bind(&this_type::handle_pong_read, this,
+                ma::detail::placeholders::_1,
+                ma::detail::placeholders::_2))));
+    read_in_progress_ = true;
+  }
+
+  void handle_ping_write(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    write_in_progress_ = false;
+
+    // Collect statistics at first step
+    register_bytes_written(bytes_transferred);
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    if (!read_in_progress_)
+    {
+      // Echo has been received already
+      continue_ping();
+    }
+  }
+
+  void handle_pong_read(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    read_in_progress_ = false;
+
+    // Collect statistics at first step
+    register_bytes_read(bytes_transferred);
+    if (!error)
+    {
+      register_round_trip(time_traits_type::now(), ping_start_time_,
+          ping_size_);
+    }
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (boost::asio::error::eof == error)
+    {
+      shutdown_socket();
+      stop();
+      return;
+    }
+
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    if (!write_in_progress_)
+    {
+      continue_ping();
+    }
+  }
+
+  void continue_ping()
+  {
+    if (test_mode::churn == mode_)
+    {
+      start_disconnect();
+    }
+    else
+    {
+      start_ping();
+    }
+  }
+
+  void start_disconnect()
+  {
+    // Graceful close: wait for the remote peer to close its side too so the
+    // complete session life cycle is done by the remote peer
+    if (shutdown_socket())
+    {
+      stop();
+      return;
+    }
+    start_disconnect_read();
+  }
+
+  void handle_disconnect_read(const boost::system::error_code& error,
+      std::size_t bytes_transferred)
+  {
+    read_in_progress_ = false;
+
+    // Collect statistics at first step
+    register_bytes_read(bytes_transferred);
+
+    if (stopped_)
+    {
+      return;
+    }
+
+    if (boost::asio::error::eof == error)
+    {
+      close_socket();
+      connected_ = false;
+      live_counters_.session_disconnected();
+      start_connect(0, initial_endpoint_iterator_, initial_endpoint_iterator_);
+      return;
+    }
+
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    start_disconnect_read();
+  }
+
+  void start_disconnect_read()
+  {
+    socket_.async_read_some(boost::asio::buffer(reply_), strand_.wrap(
+        ma::make_custom_alloc_handler(read_allocator_,
+            ma::detail::bind(&this_type::handle_disconnect_read, this,
+                ma::detail::placeholders::_1,
+                ma::detail::placeholders::_2))));
+    read_in_progress_ = true;
   }
 
   void handle_read(const boost::system::error_code& error,
@@ -358,7 +1115,8 @@ private:
     read_in_progress_ = false;
 
     // Collect statistics at first step
-    bytes_read_ += bytes_transferred;
+    register_bytes_read(bytes_transferred);
+    const bool verified = !verify_ || verify_received(bytes_transferred);
     buffer_.consume(bytes_transferred);
 
     if (stopped_)
@@ -366,6 +1124,12 @@ private:
       return;
     }
 
+    if (!verified)
+    {
+      stop();
+      return;
+    }
+
     if (boost::asio::error::eof == error)
     {
       shutdown_socket();
@@ -392,7 +1156,7 @@ private:
     write_in_progress_ = false;
 
     // Collect statistics at first step
-    bytes_written_ += bytes_transferred;
+    register_bytes_written(bytes_transferred);
     buffer_.commit(bytes_transferred);
 
     if (stopped_)
@@ -400,22 +1164,160 @@ private:
       return;
     }
 
-    if (error)
+    if (error)
+    {
+      stop();
+      return;
+    }
+
+    if (!read_in_progress_)
+    {
+      start_read_some();
+    }
+    start_write_some();
+  }
+
+  bool is_measuring()
+  {
+    if (!measuring_)
+    {
+      measuring_ = !time_traits_type::less_than(time_traits_type::now(),
+          warmup_end_time_);
+    }
+    return measuring_;
+  }
+
+  void register_connect()
+  {
+    live_counters_.add_connects(1);
+    // Connect time is a subject of measurement only in churn mode, in other
+    // modes it is just a single connect at the session start
+    if ((test_mode::churn == mode_) && is_measuring())
+    {
+      ++connects_;
+      connect_times_.record(static_cast<latency_histogram::value_type>(
+          time_traits_type::to_posix_duration(time_traits_type::subtract(
+              time_traits_type::now(), connect_start_time_))
+                  .total_microseconds()));
+    }
+  }
+
+  void register_bytes_written(std::size_t size)
+  {
+    live_counters_.add_bytes_written(size);
+    if (is_measuring())
+    {
+      bytes_written_ += size;
+      if (sized_writes_)
+      {
+        size_buckets_.record_write(write_size_, size);
+      }
+    }
+  }
+
+  void register_bytes_read(std::size_t size)
+  {
+    live_counters_.add_bytes_read(size);
+    if (is_measuring())
+    {
+      bytes_read_ += size;
+    }
+  }
+
+  void register_round_trip(const time_type& now, const time_type& start_time,
+      std::size_t size)
+  {
+    live_counters_.add_messages(1);
+    if (is_measuring())
+    {
+      const latency_histogram::value_type round_trip_time =
+          static_cast<latency_histogram::value_type>(
+              time_traits_type::to_posix_duration(time_traits_type::subtract(
+                  now, start_time)).total_microseconds());
+      round_trip_times_.record(round_trip_time);
+      size_buckets_.record_round_trip(size, round_trip_time);
+    }
+  }
+
+  static double send_phase(const session_config& config, std::size_t index)
+  {
+    if (!config.send_interval)
+    {
+      return 0;
+    }
+    return *config.send_interval
+        * static_cast<double>(index % config.send_phase_count)
+        / static_cast<double>(config.send_phase_count);
+  }
+
+  // Time of n-th send is counted from the start of schedule (and not from
+  // the previous send), so fractional interval doesn't accumulate rounding
+  // errors and the average rate is exact
+  time_type scheduled_send_time(boost::uint64_t n) const
+  {
+    const double offset = send_phase_
+        + static_cast<double>(n) * (*send_interval_);
+    return time_traits_type::add(send_start_time_,
+        ma::to_steady_deadline_timer_duration(boost::posix_time::microseconds(
+            static_cast<boost::int64_t>(offset))));
+  }
+
+  static boost::uint64_t payload_seed(std::size_t index)
+  {
+    // Makes seeds of adjacent sessions different in all bits. Result is non
+    // zero because multiplier is odd.
+    return (static_cast<boost::uint64_t>(index) + 1)
+        * 0x9E3779B97F4A7C15ULL;
+  }
+
+  static boost::uint64_t size_seed(std::size_t index)
+  {
+    // Differs from payload seed and is never zero
+    return (payload_seed(index) << 1) | 1;
+  }
+
+  /// Checks just received data (head of nonfilled sequence of buffer_) and
+  /// replaces it with the next part of sent data, so the data sent back is
+  /// not a copy of previously sent data.
+  bool verify_received(std::size_t size)
+  {
+    typedef ma::cyclic_buffer::mutable_buffers_type buffers_type;
+    const buffers_type data = buffer_.prepared(size);
+    for (buffers_type::const_iterator i = data.begin(), end = data.end();
+        i != end; ++i)
     {
-      stop();
-      return;
+      unsigned char* b = boost::asio::buffer_cast<unsigned char*>(*i);
+      for (std::size_t s = boost::asio::buffer_size(*i); s; ++b, --s)
+      {
+        if (check_sequence_.next() != *b)
+        {
+          verification_failed_ = true;
+          return false;
+        }
+        *b = send_sequence_.next();
+      }
     }
-
-    if (!read_in_progress_)
+    // All data is verified but only measured part is reported to be
+    // comparable with the number of read bytes
+    if (is_measuring())
     {
-      start_read_some();
+      bytes_verified_ += size;
     }
-    start_write_some();
+    return true;
   }
 
   void stop()
   {
+    if (timer_in_progress_)
+    {
+      boost::system::error_code ignored;
+      send_timer_.cancel(ignored);
+    }
     close_socket();
+    if (connected_)
+    {
+      live_counters_.session_disconnected();
+    }
     connected_ = false;
     stopped_   = true;
     work_state_.dec_outstanding();
@@ -423,7 +1325,12 @@ private:
 
   void start_write_some()
   {
-    ma::cyclic_buffer::const_buffers_type write_data = buffer_.data();
+    if (sized_writes_)
+    {
+      write_size_ = message_sizes_(size_engine_);
+    }
+    ma::cyclic_buffer::const_buffers_type write_data = sized_writes_
+        ? buffer_.data(write_size_) : buffer_.data();
     if (!write_data.empty())
     {
       socket_.async_write_some(write_data, strand_.wrap(
@@ -490,7 +1397,7 @@ private:
     if (!boost::logic::indeterminate(no_delay_))
     {
       boost::system::error_code error;
-      socket_type::linger opt(static_cast<bool>(no_delay_), 0);
+      protocol::no_delay opt(static_cast<bool>(no_delay_));
       socket_.set_option(opt, error);
       if (error)
       {
@@ -514,31 +1421,64 @@ private:
     socket_.close(ignored);
   }
 
+  const test_mode::value_t mode_;
+  const optional_double    send_interval_;
+  const double             send_phase_;
+  const bool          verify_;
+  const bool          sized_writes_;
   const std::size_t   max_connect_attempts_;
   const optional_int  socket_recv_buffer_size_;
   const optional_int  socket_send_buffer_size_;
   const tribool       no_delay_;
   ma::strand          strand_;
   protocol::socket    socket_;
+  deadline_timer      send_timer_;
   ma::cyclic_buffer   buffer_;
+  std::vector<char>   message_;
+  std::vector<char>   reply_;
+  size_distribution   message_sizes_;
+  xorshift_engine     size_engine_;
+  protocol::resolver::iterator initial_endpoint_iterator_;
+  limited_counter     connects_;
   limited_counter     bytes_written_;
   limited_counter     bytes_read_;
+  limited_counter     bytes_verified_;
+  payload_sequence    send_sequence_;
+  payload_sequence    check_sequence_;
+  limited_counter     scheduled_sends_;
+  limited_counter     late_sends_;
+  latency_histogram   round_trip_times_;
+  latency_histogram   connect_times_;
+  size_bucket_stats   size_buckets_;
+  time_type           ping_start_time_;
+  time_type           connect_start_time_;
+  time_type           send_start_time_;
+  time_type           next_send_time_;
+  boost::uint64_t     next_send_index_;
+  time_type           warmup_end_time_;
+  message_queue       unsent_messages_;
+  message_queue       sent_messages_;
+  std::size_t         reply_size_;
+  std::size_t         ping_size_;
+  std::size_t         write_size_;
   bool connected_;
   bool write_in_progress_;
   bool read_in_progress_;
+  bool timer_in_progress_;
   bool started_;
   bool stopped_;
   bool was_connected_;
+  bool measuring_;
+  bool verification_failed_;
   work_state& work_state_;
+  live_stats::counters& live_counters_;
   ma::in_place_handler_allocator<256> stop_allocator_;
   ma::in_place_handler_allocator<512> read_allocator_;
   ma::in_place_handler_allocator<512> write_allocator_;
+  ma::in_place_handler_allocator<256> timer_allocator_;
 }; // class session
 
 typedef ma::detail::shared_ptr<session> session_ptr;
-typedef ma::steady_deadline_timer       deadline_timer;
-typedef deadline_timer::duration_type   duration_type;
-typedef boost::optional<duration_type>  optional_duration;
 
 struct session_manager_config
 {
@@ -546,10 +1486,12 @@ public:
   session_manager_config(std::size_t the_session_count,
       std::size_t the_batch_size,
       const optional_duration& the_batch_interval,
+      const duration_type& the_warmup,
       const session_config& the_managed_session_config)
     : session_count(the_session_count)
     , batch_size(the_batch_size)
     , batch_interval(the_batch_interval)
+    , warmup(the_warmup)
     , managed_session_config(the_managed_session_config)
   {
   }
@@ -557,6 +1499,7 @@ public:
   std::size_t       session_count;
   std::size_t       batch_size;
   optional_duration batch_interval;
+  duration_type     warmup;
   session_config    managed_session_config;
 }; // struct session_manager_config
 
@@ -570,15 +1513,24 @@ class session_manager : private boost::noncopyable
 {
 private:
   typedef session_manager this_type;
+  typedef deadline_timer::time_type   time_type;
+  typedef deadline_timer::traits_type time_traits_type;
 
 public:
   typedef session::protocol protocol;
+  typedef std::vector<protocol::resolver::iterator> endpoint_iterator_vector;
 
+  /// Sessions are numbered starting from first_session_index, which allows
+  /// to run the test by a group of session managers (processes).
   session_manager(boost::asio::io_service& session_manager_io_service,
       const io_service_vector& session_io_services,
-      const session_manager_config& config)
+      const session_manager_config& config, std::size_t first_session_index,
+      live_stats& live_stats)
     : batch_size_(config.batch_size)
+    , first_session_index_(first_session_index)
     , batch_interval_(config.batch_interval)
+    , warmup_(config.warmup)
+    , warmup_end_time_()
     , io_service_(session_manager_io_service)
     , strand_(session_manager_io_service)
     , timer_(session_manager_io_service)
@@ -593,12 +1545,15 @@ public:
     const iterator send   = session_io_services.end();
     for (std::size_t i = 0; i != config.session_count;)
     {
+      std::size_t io_service_index = 0;
       for (iterator j = sbegin; (j != send) && (i != config.session_count);
-          ++j, ++i)
+          ++j, ++i, ++io_service_index)
       {
         sessions_.push_back(ma::detail::make_shared<session>(
             ma::detail::ref(**j), config.managed_session_config,
-            ma::detail::ref(work_state_)));
+            first_session_index + i,
+            ma::detail::ref(work_state_),
+            ma::detail::ref(live_stats.counters_at(io_service_index))));
       }
     }
     started_sessions_end_ = sessions_.begin();
@@ -607,17 +1562,15 @@ public:
   ~session_manager()
   {
     BOOST_ASSERT_MSG(!timer_in_progess_, "Invalid timer state");
-
-    std::for_each(session_vector::const_iterator(sessions_.begin()),
-        started_sessions_end_, ma::detail::bind(&this_type::register_stats,
-            this, ma::detail::placeholders::_1));
-    stats_.print();
   }
 
-  void async_start(const protocol::resolver::iterator& endpoint_iterator)
+  void async_start(const endpoint_iterator_vector& endpoint_iterators)
   {
+    BOOST_ASSERT_MSG(!endpoint_iterators.empty(),
+        "endpoint_iterators must not be empty");
+
     strand_.post(ma::make_custom_alloc_handler(start_allocator_,
-        ma::detail::bind(&this_type::do_start, this, endpoint_iterator)));
+        ma::detail::bind(&this_type::do_start, this, endpoint_iterators)));
   }
 
   void async_stop()
@@ -631,41 +1584,53 @@ public:
     work_state_.wait(timeout);
   }
 
+  /// Can be used only when all io_services are stopped.
+  void collect_stats(stats& total) const
+  {
+    std::for_each(session_vector::const_iterator(sessions_.begin()),
+        started_sessions_end_, ma::detail::bind(&this_type::register_stats,
+            ma::detail::ref(total), ma::detail::placeholders::_1));
+  }
+
 private:
   typedef std::vector<session_ptr> session_vector;
 
-  static session_vector::const_iterator start_sessions(
-      const protocol::resolver::iterator& endpoint_iterator,
-      const session_vector::const_iterator& begin,
-      const session_vector::const_iterator& end,
-      std::size_t max_count)
+  session_vector::const_iterator start_sessions(
+      const session_vector::const_iterator& begin, std::size_t max_count)
   {
+    const session_vector::const_iterator end = sessions_.end();
     session_vector::const_iterator i = begin;
     std::size_t count = 0;
     for (; (end != i) && (count != max_count); ++i, ++count)
     {
-      (*i)->async_start(endpoint_iterator);
+      // Sessions are distributed among targets evenly (round-robin)
+      const std::size_t session_index = first_session_index_
+          + static_cast<std::size_t>(i - sessions_.begin());
+      (*i)->async_start(
+          endpoint_iterators_[session_index % endpoint_iterators_.size()],
+          warmup_end_time_);
     }
     return i;
   }
 
-  void do_start(const protocol::resolver::iterator& endpoint_iterator)
+  void do_start(const endpoint_iterator_vector& endpoint_iterators)
   {
     if (stopped_)
     {
       return;
     }
 
-    started_sessions_end_ = start_sessions(endpoint_iterator,
-        started_sessions_end_, sessions_.end(), batch_size_);
+    endpoint_iterators_ = endpoint_iterators;
+    // Warm-up period is counted from the start of test
+    warmup_end_time_ = time_traits_type::add(time_traits_type::now(), warmup_);
+    started_sessions_end_ = start_sessions(started_sessions_end_, batch_size_);
     if (sessions_.end() != started_sessions_end_)
     {
-      schedule_session_start(endpoint_iterator);
+      schedule_session_start();
     }
   }
 
-  void schedule_session_start(
-      const protocol::resolver::iterator& endpoint_iterator)
+  void schedule_session_start()
   {
     if (batch_interval_)
     {
@@ -675,19 +1640,18 @@ private:
       timer_.async_wait(strand_.wrap(
           ma::make_custom_alloc_handler(timer_allocator_,
               ma::detail::bind(&this_type::handle_scheduled_session_start, this,
-                  ma::detail::placeholders::_1, endpoint_iterator))));
+                  ma::detail::placeholders::_1))));
       timer_in_progess_ = true;
     }
     else
     {
       strand_.post(ma::make_custom_alloc_handler(timer_allocator_,
           ma::detail::bind(&this_type::handle_scheduled_session_start, this,
-              boost::system::error_code(), endpoint_iterator)));
+              boost::system::error_code())));
     }
   }
 
-  void handle_scheduled_session_start(const boost::system::error_code& error,
-      const protocol::resolver::iterator& endpoint_iterator)
+  void handle_scheduled_session_start(const boost::system::error_code& error)
   {
     timer_in_progess_ = false;
 
@@ -702,11 +1666,10 @@ private:
       return;
     }
 
-    started_sessions_end_ = start_sessions(endpoint_iterator,
-        started_sessions_end_, sessions_.end(), batch_size_);
+    started_sessions_end_ = start_sessions(started_sessions_end_, batch_size_);
     if (sessions_.end() != started_sessions_end_)
     {
-      schedule_session_start(endpoint_iterator);
+      schedule_session_start();
     }
   }
 
@@ -733,24 +1696,32 @@ private:
             ma::detail::placeholders::_1));
   }
 
-  void register_stats(const session_ptr& session)
+  static void register_stats(stats& total, const session_ptr& session)
   {
     if (session->was_connected())
     {
-      stats_.add(session->bytes_written(), session->bytes_read());
+      total.add(session->connects(), session->bytes_written(),
+          session->bytes_read(), session->bytes_verified(),
+          session->verification_failed(), session->scheduled_sends(),
+          session->late_sends(), session->unsent_messages(),
+          session->round_trip_times(), session->connect_times(),
+          session->size_buckets());
     }
   }
 
   const std::size_t        batch_size_;
+  const std::size_t        first_session_index_;
   const optional_duration  batch_interval_;
+  const duration_type      warmup_;
+  time_type                warmup_end_time_;
   boost::asio::io_service& io_service_;
   boost::asio::io_service::strand strand_;
   deadline_timer timer_;
   session_vector sessions_;
   session_vector::const_iterator started_sessions_end_;
+  endpoint_iterator_vector endpoint_iterators_;
   bool  stopped_;
   bool  timer_in_progess_;
-  stats stats_;
   work_state work_state_;
   ma::in_place_handler_allocator<256> start_allocator_;
   ma::in_place_handler_allocator<256> stop_allocator_;
@@ -767,46 +1738,101 @@ optional_duration to_optional_duration(long milliseconds)
   return boost::none;
 }
 
+typedef boost::optional<std::string> optional_string;
+
+struct target
+{
+public:
+  target(const std::string& the_host, const std::string& the_port)
+    : host(the_host)
+    , port(the_port)
+  {
+  }
+
+  std::string host;
+  std::string port;
+}; // struct target
+
+typedef std::vector<target> target_vector;
+
 struct client_config
 {
 public:
   client_config(bool the_ios_per_work_thread,
-      const std::string& the_host,
-      const std::string& the_port,
+      const target_vector& the_targets,
+      std::size_t the_process_count,
       std::size_t the_thread_count,
       const boost::posix_time::time_duration& the_test_duration,
+      const boost::posix_time::time_duration& the_sample_interval,
+      const optional_string& the_output_file,
+      sample_output_format::value_t the_output_format,
       const session_manager_config& the_session_manager_config)
     : ios_per_work_thread(the_ios_per_work_thread)
-    , host(the_host)
-    , port(the_port)
+    , targets(the_targets)
+    , process_count(the_process_count)
     , thread_count(the_thread_count)
     , test_duration(the_test_duration)
+    , sample_interval(the_sample_interval)
+    , output_file(the_output_file)
+    , output_format(the_output_format)
     , client_session_manager_config(the_session_manager_config)
   {
   }
 
-  bool        ios_per_work_thread;
-  std::string host;
-  std::string port;
-  std::size_t thread_count;
+  bool          ios_per_work_thread;
+  target_vector targets;
+  std::size_t   process_count;
+  std::size_t   thread_count;
   boost::posix_time::time_duration test_duration;
+  boost::posix_time::time_duration sample_interval;
+  optional_string output_file;
+  sample_output_format::value_t output_format;
   session_manager_config client_session_manager_config;
 }; // struct client_config
 
 const char* help_option_name                    = "help";
 const char* host_option_name                    = "host";
 const char* port_option_name                    = "port";
+const char* target_option_name                  = "target";
+const char* processes_option_name               = "processes";
 const char* demux_option_name                   = "demux-per-work-thread";
 const char* threads_option_name                 = "threads";
 const char* sessions_option_name                = "sessions";
 const char* batch_size_option_name              = "batch-size";
 const char* batch_interval_option_name          = "batch-interval";
 const char* buffer_option_name                  = "buffer";
+const char* mode_option_name                    = "mode";
+const char* message_size_option_name            = "message-size";
+const char* verify_option_name                  = "verify";
+const char* size_distribution_option_name       = "size-distribution";
+const char* size_min_option_name                = "size-min";
+const char* size_max_option_name                = "size-max";
+const char* size_median_option_name             = "size-median";
+const char* size_sigma_option_name              = "size-sigma";
+const char* size_table_option_name              = "size-table";
+const char* rate_option_name                    = "rate";
+const char* rate_scope_option_name              = "rate-scope";
 const char* connect_attempts_option_name        = "connect-attempts";
 const char* socket_recv_buffer_size_option_name = "sock-recv-buffer";
 const char* socket_send_buffer_size_option_name = "sock-send-buffer";
 const char* no_delay_option_name                = "no-delay";
 const char* time_option_name                    = "time";
+const char* warmup_option_name                  = "warmup";
+const char* sample_interval_option_name         = "sample-interval";
+const char* output_file_option_name             = "output-file";
+const char* output_format_option_name           = "output-format";
+const char* stream_mode_name                    = "stream";
+const char* ping_pong_mode_name                 = "ping-pong";
+const char* open_loop_mode_name                 = "open-loop";
+const char* churn_mode_name                     = "churn";
+const char* fixed_size_distribution_name         = "fixed";
+const char* uniform_size_distribution_name       = "uniform";
+const char* lognormal_size_distribution_name     = "lognormal";
+const char* table_size_distribution_name         = "table";
+const char* global_rate_scope_name              = "global";
+const char* session_rate_scope_name             = "session";
+const char* csv_output_format_name              = "csv";
+const char* json_output_format_name             = "json";
 
 std::size_t calc_thread_count(std::size_t hardware_concurrency)
 {
@@ -843,6 +1869,20 @@ boost::program_options::options_description build_cmd_options_description(
       boost::program_options::value<std::string>(),
       "set the remote peer's port"
     )
+    (
+      target_option_name,
+      boost::program_options::value<std::vector<std::string> >()->composing(),
+      "add the remote peer (host:port) to distribute sessions among," \
+          " can be used several times instead of or together with" \
+          " host and port"
+    )
+    (
+      processes_option_name,
+      boost::program_options::value<std::size_t>()->default_value(1),
+      "set the number of processes running the test together, sessions" \
+          " are distributed among processes and each process uses" \
+          " the given number of threads"
+    )
     (
       demux_option_name,
       boost::program_options::value<bool>()->default_value(
@@ -875,6 +1915,78 @@ boost::program_options::options_description build_cmd_options_description(
       boost::program_options::value<std::size_t>()->default_value(4096),
       "set the size of session's buffer (bytes)"
     )
+    (
+      mode_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          stream_mode_name),
+      "set the test mode: stream (measure throughput), ping-pong" \
+          " (measure round trip time of single message), open-loop" \
+          " (send messages with constant rate and measure their latency)" \
+          " or churn (connect, exchange single message, disconnect and" \
+          " repeat, measure connect time and rate)"
+    )
+    (
+      message_size_option_name,
+      boost::program_options::value<std::size_t>()->default_value(64),
+      "set the size of message in ping-pong, open-loop and churn modes" \
+          " (bytes)"
+    )
+    (
+      verify_option_name,
+      boost::program_options::value<bool>()->default_value(false),
+      "set verification of echoed data in stream mode on: sent data is" \
+          " pseudo-random sequence unique for each session"
+    )
+    (
+      size_distribution_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          fixed_size_distribution_name),
+      "set the distribution of message (write) sizes: fixed (message size" \
+          " or whole available data in stream mode), uniform, lognormal or" \
+          " table (read from file), size is sampled for each write"
+    )
+    (
+      size_min_option_name,
+      boost::program_options::value<std::size_t>()->default_value(1),
+      "set the minimal size of message for uniform and lognormal" \
+          " distributions (bytes)"
+    )
+    (
+      size_max_option_name,
+      boost::program_options::value<std::size_t>(),
+      "set the maximal size of message for uniform and lognormal" \
+          " distributions (bytes), default is message size or buffer size" \
+          " in stream mode"
+    )
+    (
+      size_median_option_name,
+      boost::program_options::value<double>(),
+      "set the median of lognormal distribution (bytes), default is" \
+          " geometric mean of minimal and maximal sizes"
+    )
+    (
+      size_sigma_option_name,
+      boost::program_options::value<double>()->default_value(1.0),
+      "set the shape (sigma) of lognormal distribution"
+    )
+    (
+      size_table_option_name,
+      boost::program_options::value<std::string>(),
+      "set the file with the table of message sizes: each line holds" \
+          " size (bytes) and its weight, lines starting with # are skipped"
+    )
+    (
+      rate_option_name,
+      boost::program_options::value<double>()->default_value(1000),
+      "set the target rate of messages in open-loop mode (messages/second)"
+    )
+    (
+      rate_scope_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          global_rate_scope_name),
+      "set if the target rate is for all sessions together (global) or" \
+          " for each session (session)"
+    )
     (
       connect_attempts_option_name,
       boost::program_options::value<std::size_t>()->default_value(0),
@@ -900,6 +2012,29 @@ boost::program_options::options_description build_cmd_options_description(
       time_option_name,
       boost::program_options::value<long>()->default_value(600),
       "set the duration of test (seconds)"
+    )
+    (
+      warmup_option_name,
+      boost::program_options::value<long>()->default_value(0),
+      "set the duration of warm-up period at the start of test which is" \
+          " excluded from the totals (seconds)"
+    )
+    (
+      sample_interval_option_name,
+      boost::program_options::value<long>()->default_value(1000),
+      "set the interval of throughput sampling (milliseconds)" \
+          ", 0 means no sampling"
+    )
+    (
+      output_file_option_name,
+      boost::program_options::value<std::string>(),
+      "set the file to write the samples of throughput into"
+    )
+    (
+      output_format_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          csv_output_format_name),
+      "set the format of output file: csv or json"
     );
 
   return description;
@@ -930,8 +2065,193 @@ bool is_help_mode(const boost::program_options::variables_map& options_values)
 bool is_required_specified(
     const boost::program_options::variables_map& options_values)
 {
-  return (0 != options_values.count(port_option_name))
-      && (0 != options_values.count(host_option_name));
+  return ((0 != options_values.count(port_option_name))
+      && (0 != options_values.count(host_option_name)))
+      || (0 != options_values.count(target_option_name));
+}
+
+test_mode::value_t read_test_mode(
+    const boost::program_options::variables_map& options_values)
+{
+  const std::string mode_name =
+      options_values[mode_option_name].as<std::string>();
+  if (stream_mode_name == mode_name)
+  {
+    return test_mode::stream;
+  }
+  if (ping_pong_mode_name == mode_name)
+  {
+    return test_mode::ping_pong;
+  }
+  if (open_loop_mode_name == mode_name)
+  {
+    return test_mode::open_loop;
+  }
+  if (churn_mode_name == mode_name)
+  {
+    return test_mode::churn;
+  }
+  using boost::program_options::validation_error;
+  boost::throw_exception(validation_error(
+      validation_error::invalid_option_value, std::string(), mode_option_name));
+}
+
+optional_double build_send_interval(
+    const boost::program_options::variables_map& options_values,
+    test_mode::value_t mode, std::size_t session_count)
+{
+  if (test_mode::open_loop != mode)
+  {
+    return boost::none;
+  }
+
+  using boost::program_options::validation_error;
+
+  const double rate = options_values[rate_option_name].as<double>();
+  if (!(rate > 0))
+  {
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        rate_option_name));
+  }
+
+  const std::string rate_scope =
+      options_values[rate_scope_option_name].as<std::string>();
+  double session_rate = rate;
+  if (global_rate_scope_name == rate_scope)
+  {
+    session_rate = rate / static_cast<double>(session_count);
+  }
+  else if (session_rate_scope_name != rate_scope)
+  {
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        rate_scope_option_name));
+  }
+
+  // Interval isn't rounded, so any rate (including rates above 1M/s per
+  // session) is kept exactly on average
+  const double interval_micros = 1000000 / session_rate;
+  if (!(interval_micros > 0))
+  {
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        rate_option_name));
+  }
+
+  return interval_micros;
+}
+
+size_distribution build_message_sizes(
+    const boost::program_options::variables_map& options_values,
+    test_mode::value_t mode, std::size_t buffer_size, std::size_t message_size)
+{
+  using boost::program_options::validation_error;
+
+  const std::size_t default_size =
+      test_mode::stream == mode ? buffer_size : message_size;
+  const std::string distribution_name =
+      options_values[size_distribution_option_name].as<std::string>();
+  if (fixed_size_distribution_name == distribution_name)
+  {
+    return size_distribution::fixed(default_size);
+  }
+
+  if (table_size_distribution_name == distribution_name)
+  {
+    size_distribution::size_vector   sizes;
+    size_distribution::weight_vector weights;
+    if (!options_values.count(size_table_option_name))
+    {
+      boost::throw_exception(validation_error(
+          validation_error::at_least_one_value_required, std::string(),
+          size_table_option_name));
+    }
+    std::ifstream table_file(
+        options_values[size_table_option_name].as<std::string>().c_str());
+    if (!performance_test_client::read_size_table(table_file, sizes, weights)
+        || ((test_mode::stream == mode) && (buffer_size
+            < *std::max_element(sizes.begin(), sizes.end()))))
+    {
+      boost::throw_exception(validation_error(
+          validation_error::invalid_option_value, std::string(),
+          size_table_option_name));
+    }
+    return size_distribution::table(sizes, weights);
+  }
+
+  const std::size_t min_size =
+      options_values[size_min_option_name].as<std::size_t>();
+  if (!min_size)
+  {
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        size_min_option_name));
+  }
+  std::size_t max_size = default_size;
+  if (options_values.count(size_max_option_name))
+  {
+    max_size = options_values[size_max_option_name].as<std::size_t>();
+  }
+  if ((max_size < min_size)
+      || ((test_mode::stream == mode) && (max_size > buffer_size)))
+  {
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        size_max_option_name));
+  }
+
+  if (uniform_size_distribution_name == distribution_name)
+  {
+    return size_distribution::uniform(min_size, max_size);
+  }
+
+  if (lognormal_size_distribution_name == distribution_name)
+  {
+    double median = std::sqrt(
+        static_cast<double>(min_size) * static_cast<double>(max_size));
+    if (options_values.count(size_median_option_name))
+    {
+      median = options_values[size_median_option_name].as<double>();
+    }
+    if (!(median > 0))
+    {
+      boost::throw_exception(validation_error(
+          validation_error::invalid_option_value, std::string(),
+          size_median_option_name));
+    }
+    const double sigma = options_values[size_sigma_option_name].as<double>();
+    if (!(sigma > 0))
+    {
+      boost::throw_exception(validation_error(
+          validation_error::invalid_option_value, std::string(),
+          size_sigma_option_name));
+    }
+    return size_distribution::lognormal(median, sigma, min_size, max_size);
+  }
+
+  boost::throw_exception(validation_error(
+      validation_error::invalid_option_value, std::string(),
+      size_distribution_option_name));
+}
+
+sample_output_format::value_t read_output_format(
+    const boost::program_options::variables_map& options_values)
+{
+  const std::string format_name =
+      options_values[output_format_option_name].as<std::string>();
+  if (csv_output_format_name == format_name)
+  {
+    return sample_output_format::csv;
+  }
+  if (json_output_format_name == format_name)
+  {
+    return sample_output_format::json;
+  }
+  using boost::program_options::validation_error;
+  boost::throw_exception(validation_error(
+      validation_error::invalid_option_value, std::string(),
+      output_format_option_name));
 }
 
 optional_int build_optional_int(
@@ -945,17 +2265,92 @@ optional_int build_optional_int(
   return options_values[option_name].as<int>();
 }
 
+target parse_target(const std::string& text)
+{
+  // Port is separated by the last colon, IPv6 host can be put into brackets
+  const std::string::size_type separator_pos = text.rfind(':');
+  if ((std::string::npos == separator_pos) || !separator_pos
+      || (text.size() - 1 == separator_pos))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        target_option_name));
+  }
+  std::string host = text.substr(0, separator_pos);
+  if ((host.size() > 2) && ('[' == host[0]) && (']' == host[host.size() - 1]))
+  {
+    host = host.substr(1, host.size() - 2);
+  }
+  return target(host, text.substr(separator_pos + 1));
+}
+
+target_vector build_targets(
+    const boost::program_options::variables_map& options_values)
+{
+  target_vector targets;
+  if (options_values.count(host_option_name)
+      && options_values.count(port_option_name))
+  {
+    targets.push_back(target(
+        options_values[host_option_name].as<std::string>(),
+        options_values[port_option_name].as<std::string>()));
+  }
+  if (options_values.count(target_option_name))
+  {
+    const std::vector<std::string>& texts =
+        options_values[target_option_name].as<std::vector<std::string> >();
+    std::transform(texts.begin(), texts.end(), std::back_inserter(targets),
+        parse_target);
+  }
+  return targets;
+}
+
 client_config build_client_config(
     const boost::program_options::variables_map& options_values)
 {
-  const std::string host = options_values[host_option_name].as<std::string>();
-  const std::string port = options_values[port_option_name].as<std::string>();
+  const target_vector targets = build_targets(options_values);
   const std::size_t thread_count  =
       options_values[threads_option_name].as<std::size_t>();
   const long time_seconds =
       options_values[time_option_name].as<long>();
+  const long warmup_seconds =
+      options_values[warmup_option_name].as<long>();
+  if ((warmup_seconds < 0) || (warmup_seconds >= time_seconds))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        warmup_option_name));
+  }
+  const long sample_interval_millis =
+      options_values[sample_interval_option_name].as<long>();
+  if (sample_interval_millis < 0)
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        sample_interval_option_name));
+  }
+  optional_string output_file;
+  if (options_values.count(output_file_option_name))
+  {
+    output_file = options_values[output_file_option_name].as<std::string>();
+  }
+  const sample_output_format::value_t output_format =
+      read_output_format(options_values);
   const std::size_t session_count =
       options_values[sessions_option_name].as<std::size_t>();
+  const std::size_t process_count =
+      options_values[processes_option_name].as<std::size_t>();
+  if (!process_count || (process_count > session_count)
+      || ((process_count > 1) && !process_group::is_supported()))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        processes_option_name));
+  }
   const std::size_t batch_size =
       options_values[batch_size_option_name].as<std::size_t>();
   const long batch_interval_millis =
@@ -963,6 +2358,26 @@ client_config build_client_config(
 
   const std::size_t buffer_size =
       options_values[buffer_option_name].as<std::size_t>();
+  const test_mode::value_t mode = read_test_mode(options_values);
+  const std::size_t message_size =
+      options_values[message_size_option_name].as<std::size_t>();
+  if (!message_size)
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        message_size_option_name));
+  }
+  const bool verify = options_values[verify_option_name].as<bool>();
+  if (verify && (test_mode::stream != mode))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(),
+        verify_option_name));
+  }
+  const size_distribution message_sizes =
+      build_message_sizes(options_values, mode, buffer_size, message_size);
   const std::size_t max_connect_attempts =
       options_values[connect_attempts_option_name].as<std::size_t>();
 
@@ -977,18 +2392,27 @@ client_config build_client_config(
     no_delay = options_values[no_delay_option_name].as<bool>();
   }
 
-  session_config client_session_config(buffer_size, max_connect_attempts,
-      socket_recv_buffer_size, socket_send_buffer_size, no_delay);
+  const optional_double send_interval =
+      build_send_interval(options_values, mode, session_count);
+
+  session_config client_session_config(mode, buffer_size, message_size,
+      message_sizes, send_interval, session_count, verify, max_connect_attempts, socket_recv_buffer_size,
+      socket_send_buffer_size, no_delay);
 
   session_manager_config client_session_manager_config(session_count,
       batch_size, to_optional_duration(batch_interval_millis),
+      ma::to_steady_deadline_timer_duration(
+          boost::posix_time::seconds(warmup_seconds)),
       client_session_config);
 
   bool ios_per_work_thread =
       options_values[demux_option_name].as<bool>();
 
-  return client_config(ios_per_work_thread, host, port, thread_count,
-      boost::posix_time::seconds(time_seconds), client_session_manager_config);
+  return client_config(ios_per_work_thread, targets, process_count,
+      thread_count,
+      boost::posix_time::seconds(time_seconds),
+      boost::posix_time::milliseconds(sample_interval_millis), output_file,
+      output_format, client_session_manager_config);
 }
 
 std::string to_seconds_string(const boost::posix_time::time_duration& duration)
@@ -1012,6 +2436,20 @@ std::string to_milliseconds_string(const duration_type& duration)
 
 #endif // defined(MA_HAS_STEADY_DEADLINE_TIMER)
 
+std::string to_microseconds_string(const optional_double& micros)
+{
+  if (micros)
+  {
+    std::ostringstream stream;
+    stream << *micros;
+    return stream.str();
+  }
+  else
+  {
+    return "n/a";
+  }
+}
+
 std::string to_milliseconds_string(const optional_duration& duration)
 {
   if (duration)
@@ -1041,6 +2479,44 @@ std::string to_string(bool value)
   return value ? "on" : "off";
 }
 
+std::string to_string(test_mode::value_t value)
+{
+  switch (value)
+  {
+  case test_mode::ping_pong:
+    return ping_pong_mode_name;
+  case test_mode::open_loop:
+    return open_loop_mode_name;
+  case test_mode::churn:
+    return churn_mode_name;
+  default:
+    return stream_mode_name;
+  }
+}
+
+std::string to_string(const optional_string& value)
+{
+  if (value)
+  {
+    return *value;
+  }
+  else
+  {
+    return "n/a";
+  }
+}
+
+std::string to_string(sample_output_format::value_t value)
+{
+  switch (value)
+  {
+  case sample_output_format::json:
+    return json_output_format_name;
+  default:
+    return csv_output_format_name;
+  }
+}
+
 std::string to_string(const tribool& value)
 {
   if (boost::logic::indeterminate(value))
@@ -1057,11 +2533,16 @@ void print(const client_config& config)
   const session_config& managed_session_config =
       client_session_manager_config.managed_session_config;
 
-  std::cout << "Host      : "
-            << config.host
-            << std::endl
-            << "Port      : "
-            << config.port
+  std::cout << "Targets   : ";
+  for (target_vector::const_iterator i = config.targets.begin(),
+      end = config.targets.end(); i != end; ++i)
+  {
+    std::cout << (config.targets.begin() == i ? "" : ", ")
+              << i->host << ':' << i->port;
+  }
+  std::cout << std::endl
+            << "Processes : "
+            << config.process_count
             << std::endl
             << "Threads   : "
             << config.thread_count
@@ -1079,9 +2560,24 @@ void print(const client_config& config)
             << "Demultiplexer-per-work-thread mode: "
             << (to_string)(config.ios_per_work_thread)
             << std::endl
+            << "Test mode                         : "
+            << (to_string)(managed_session_config.mode)
+            << std::endl
             << "Session's buffer size (bytes)     : "
             << managed_session_config.buffer_size
             << std::endl
+            << "Message size (bytes)              : "
+            << managed_session_config.message_size
+            << std::endl
+            << "Message sizes                     : "
+            << managed_session_config.message_sizes.description()
+            << std::endl
+            << "Session's send interval (microseconds): "
+            << to_microseconds_string(managed_session_config.send_interval)
+            << std::endl
+            << "Verification of echoed data      : "
+            << (to_string)(managed_session_config.verify)
+            << std::endl
             << "Maximum number of connect attempts per session : "
             << managed_session_config.max_connect_attempts
             << std::endl
@@ -1096,6 +2592,19 @@ void print(const client_config& config)
             << std::endl
             << "Time (seconds): "
             << to_seconds_string(config.test_duration)
+            << std::endl
+            << "Warm-up (seconds)             : "
+            << to_seconds_string(deadline_timer::traits_type::to_posix_duration(
+                  client_session_manager_config.warmup))
+            << std::endl
+            << "Sample interval (milliseconds): "
+            << to_milliseconds_string(config.sample_interval)
+            << std::endl
+            << "Output file   : "
+            << (to_string)(config.output_file)
+            << std::endl
+            << "Output format : "
+            << (to_string)(config.output_format)
             << std::endl;
 }
 
@@ -1194,14 +2703,52 @@ int main(int argc, char* argv[])
     const client_config config = build_client_config(cmd_options);
     print(config);
 
+    std::ofstream output_file;
+    if (config.output_file)
+    {
+      output_file.open(config.output_file->c_str());
+      if (!output_file)
+      {
+        std::cerr << "Can't open output file: " << *config.output_file
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // Must be created before any thread and io_service
+    process_group processes(config.process_count);
+
+    // Sessions are distributed among processes as evenly as possible
+    session_manager_config process_session_manager_config =
+        config.client_session_manager_config;
+    const std::size_t base_session_count =
+        process_session_manager_config.session_count / processes.count();
+    const std::size_t extra_session_count =
+        process_session_manager_config.session_count % processes.count();
+    process_session_manager_config.session_count = base_session_count
+        + (processes.index() < extra_session_count ? 1 : 0);
+    const std::size_t first_session_index =
+        processes.index() * base_session_count
+        + (std::min)(processes.index(), extra_session_count);
+
     const io_service_vector session_io_services =
         create_session_io_services(config);
 
     boost::asio::io_service session_manager_io_service(
         ma::to_io_context_concurrency_hint(1));
     session_manager::protocol::resolver resolver(session_manager_io_service);
+    // Counters of live stats are split per io_service of sessions
+    live_stats client_live_stats(session_io_services.size());
+    // Samples of single process cover just a part of load when the test
+    // is run by a group of processes, so they are printed only after merge
+    stats_sampler client_stats_sampler(session_manager_io_service,
+        client_live_stats, config.sample_interval,
+        deadline_timer::traits_type::to_posix_duration(
+            config.client_session_manager_config.warmup),
+        1 == processes.count());
     session_manager client_session_manager(session_manager_io_service,
-        session_io_services, config.client_session_manager_config);
+        session_io_services, process_session_manager_config,
+        first_session_index, client_live_stats);
 
     ma::thread_group session_threads;
     io_service_work_vector session_work_guards =
@@ -1220,10 +2767,22 @@ int main(int argc, char* argv[])
     boost::timer::cpu_timer timer;
 #endif // defined(MA_HAS_BOOST_TIMER)
 
-    client_session_manager.async_start(resolver.resolve(
-        session_manager::protocol::resolver::query(config.host, config.port)));
+    session_manager::endpoint_iterator_vector endpoint_iterators;
+    for (target_vector::const_iterator i = config.targets.begin(),
+        end = config.targets.end(); i != end; ++i)
+    {
+      endpoint_iterators.push_back(resolver.resolve(
+          session_manager::protocol::resolver::query(i->host, i->port)));
+    }
+
+    processes.sync_start();
+
+    // Time series is collected by each process and merged by coordinator
+    client_stats_sampler.async_start();
+    client_session_manager.async_start(endpoint_iterators);
     client_session_manager.wait(config.test_duration);
     client_session_manager.async_stop();
+    client_stats_sampler.async_stop();
 
     session_manager_work_guard = boost::none;
     session_manager_threads.join_all();
@@ -1231,11 +2790,57 @@ int main(int argc, char* argv[])
     session_work_guards.clear();
     session_threads.join_all();
 
+    stats total_stats;
+    client_session_manager.collect_stats(total_stats);
+
+    if (!processes.is_coordinator())
+    {
+      std::ostringstream result;
+      total_stats.save(result);
+      client_stats_sampler.save(result);
+      processes.send_result(result.str());
+      return total_stats.has_verification_failures()
+          ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    const process_group::string_vector worker_results =
+        processes.receive_results();
+    for (process_group::string_vector::const_iterator
+        i = worker_results.begin(), end = worker_results.end(); i != end; ++i)
+    {
+      std::istringstream result(*i);
+      stats worker_stats;
+      if (!worker_stats.load(result) || !client_stats_sampler.merge(result))
+      {
+        std::cerr << "Failed to read result of worker process" << std::endl;
+        return EXIT_FAILURE;
+      }
+      total_stats.merge(worker_stats);
+    }
+
+    if (1 != processes.count())
+    {
+      client_stats_sampler.print();
+    }
+
+    if (output_file.is_open())
+    {
+      client_stats_sampler.write(output_file, config.output_format);
+    }
+
 #if defined(MA_HAS_BOOST_TIMER)
     timer.stop();
     std::cout << "Test duration :" << timer.format();
 #endif // defined(MA_HAS_BOOST_TIMER)
 
+    total_stats.print();
+
+    if (total_stats.has_verification_failures())
+    {
+      std::cerr << "Echoed data verification failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+
     return EXIT_SUCCESS;
   }
   catch (const boost::program_options::error& e)
@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef PAYLOAD_SEQUENCE_HPP
+#define PAYLOAD_SEQUENCE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <boost/cstdint.hpp>
+#include "xorshift_engine.hpp"
+
+namespace performance_test_client {
+
+/// Deterministic pseudo-random byte sequence.
+/**
+ * Two instances with the same seed produce the same sequence, so one of them
+ * can be used to generate sent data and the other one - to check received
+ * data.
+ */
+class payload_sequence
+{
+public:
+  explicit payload_sequence(boost::uint64_t seed);
+
+  unsigned char next();
+
+private:
+  xorshift_engine engine_;
+  boost::uint64_t word_;
+  unsigned        available_;
+}; // class payload_sequence
+
+inline payload_sequence::payload_sequence(boost::uint64_t seed)
+  : engine_(seed)
+  , word_(0)
+  , available_(0)
+{
+}
+
+inline unsigned char payload_sequence::next()
+{
+  if (!available_)
+  {
+    word_ = engine_();
+    available_ = sizeof(word_);
+  }
+  const unsigned char value = static_cast<unsigned char>(word_ & 0xff);
+  word_ >>= 8;
+  --available_;
+  return value;
+}
+
+} // namespace performance_test_client
+
+#endif // PAYLOAD_SEQUENCE_HPP
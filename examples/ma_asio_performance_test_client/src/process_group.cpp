@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cerrno>
+#include <stdexcept>
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/system/system_error.hpp>
+#include "process_group.hpp"
+
+#if !defined(WIN32)
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif // !defined(WIN32)
+
+namespace performance_test_client {
+
+namespace {
+
+#if !defined(WIN32)
+
+const char ready_message = 'r';
+const char start_message = 's';
+
+void throw_last_error(const char* what)
+{
+  boost::throw_exception(boost::system::system_error(
+      boost::system::error_code(errno, boost::system::system_category()),
+      what));
+}
+
+void write_all(int descriptor, const char* data, std::size_t size)
+{
+  while (size)
+  {
+    const ssize_t written = ::write(descriptor, data, size);
+    if (written < 0)
+    {
+      if (EINTR == errno)
+      {
+        continue;
+      }
+      throw_last_error("Failed to write to process group socket");
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+}
+
+/// Returns false if the end of stream is reached.
+bool read_some(int descriptor, char* data, std::size_t size,
+    std::size_t& bytes_read)
+{
+  for (;;)
+  {
+    const ssize_t result = ::read(descriptor, data, size);
+    if (result < 0)
+    {
+      if (EINTR == errno)
+      {
+        continue;
+      }
+      throw_last_error("Failed to read from process group socket");
+    }
+    bytes_read = static_cast<std::size_t>(result);
+    return 0 != result;
+  }
+}
+
+void read_message(int descriptor, char expected)
+{
+  char message = 0;
+  std::size_t bytes_read = 0;
+  if (!read_some(descriptor, &message, 1, bytes_read) || expected != message)
+  {
+    boost::throw_exception(std::runtime_error(
+        "Process of group has stopped unexpectedly"));
+  }
+}
+
+#endif // !defined(WIN32)
+
+} // anonymous namespace
+
+bool process_group::is_supported()
+{
+#if defined(WIN32)
+  return false;
+#else
+  return true;
+#endif
+}
+
+process_group::process_group(std::size_t count)
+  : count_(count)
+  , index_(0)
+{
+  BOOST_ASSERT_MSG(count > 0, "count must be > 0");
+
+#if defined(WIN32)
+  if (count > 1)
+  {
+    boost::throw_exception(std::runtime_error(
+        "Process group is not supported"));
+  }
+#else
+  for (std::size_t i = 1; i != count; ++i)
+  {
+    int pair[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair))
+    {
+      throw_last_error("Failed to create process group socket pair");
+    }
+
+    const pid_t pid = ::fork();
+    if (pid < 0)
+    {
+      ::close(pair[0]);
+      ::close(pair[1]);
+      throw_last_error("Failed to start worker process");
+    }
+
+    if (!pid)
+    {
+      // Worker process keeps only the socket connected with the coordinator
+      ::close(pair[0]);
+      close_all();
+      worker_pids_.clear();
+      sockets_.push_back(pair[1]);
+      index_ = i;
+      return;
+    }
+
+    ::close(pair[1]);
+    sockets_.push_back(pair[0]);
+    worker_pids_.push_back(static_cast<long>(pid));
+  }
+#endif // defined(WIN32)
+}
+
+process_group::~process_group()
+{
+  close_all();
+#if !defined(WIN32)
+  for (std::vector<long>::const_iterator i = worker_pids_.begin(),
+      end = worker_pids_.end(); i != end; ++i)
+  {
+    int status = 0;
+    while ((::waitpid(static_cast<pid_t>(*i), &status, 0) < 0)
+        && (EINTR == errno))
+    {
+    }
+  }
+#endif // !defined(WIN32)
+}
+
+std::size_t process_group::index() const
+{
+  return index_;
+}
+
+std::size_t process_group::count() const
+{
+  return count_;
+}
+
+bool process_group::is_coordinator() const
+{
+  return !index_;
+}
+
+void process_group::sync_start()
+{
+#if !defined(WIN32)
+  if (is_coordinator())
+  {
+    for (descriptor_vector::const_iterator i = sockets_.begin(),
+        end = sockets_.end(); i != end; ++i)
+    {
+      read_message(*i, ready_message);
+    }
+    for (descriptor_vector::const_iterator i = sockets_.begin(),
+        end = sockets_.end(); i != end; ++i)
+    {
+      write_all(*i, &start_message, 1);
+    }
+  }
+  else
+  {
+    write_all(sockets_.front(), &ready_message, 1);
+    read_message(sockets_.front(), start_message);
+  }
+#endif // !defined(WIN32)
+}
+
+void process_group::send_result(const std::string& result)
+{
+  BOOST_ASSERT_MSG(!is_coordinator(), "Coordinator has no one to send to");
+
+#if !defined(WIN32)
+  write_all(sockets_.front(), result.data(), result.size());
+  // End of stream marks the end of result
+  ::shutdown(sockets_.front(), SHUT_WR);
+#else
+  (void) result;
+#endif // !defined(WIN32)
+}
+
+process_group::string_vector process_group::receive_results()
+{
+  BOOST_ASSERT_MSG(is_coordinator(), "Only coordinator receives results");
+
+  string_vector results;
+#if !defined(WIN32)
+  for (descriptor_vector::const_iterator i = sockets_.begin(),
+      end = sockets_.end(); i != end; ++i)
+  {
+    std::string result;
+    char buffer[4096];
+    std::size_t bytes_read = 0;
+    while (read_some(*i, buffer, sizeof(buffer), bytes_read))
+    {
+      result.append(buffer, bytes_read);
+    }
+    results.push_back(result);
+  }
+#endif // !defined(WIN32)
+  return results;
+}
+
+void process_group::close_all()
+{
+#if !defined(WIN32)
+  for (descriptor_vector::const_iterator i = sockets_.begin(),
+      end = sockets_.end(); i != end; ++i)
+  {
+    ::close(*i);
+  }
+#endif // !defined(WIN32)
+  sockets_.clear();
+}
+
+} // namespace performance_test_client
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef PROCESS_GROUP_HPP
+#define PROCESS_GROUP_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace performance_test_client {
+
+/// Group of processes running the same test together.
+/**
+ * Process which creates the group becomes the coordinator (index 0) and
+ * forks (count - 1) worker processes. Each worker is connected with the
+ * coordinator by a pair of local sockets. Group has to be created before any
+ * thread is started. Methods throw boost::system::system_error in case of
+ * failure.
+ *
+ * Is supported only on POSIX systems.
+ */
+class process_group : private boost::noncopyable
+{
+public:
+  typedef std::vector<std::string> string_vector;
+
+  static bool is_supported();
+
+  explicit process_group(std::size_t count);
+  ~process_group();
+
+  std::size_t index() const;
+  std::size_t count() const;
+  bool is_coordinator() const;
+
+  /// Blocks until all processes of group are ready to start the test.
+  /// Worker reports its readiness and waits for command from the
+  /// coordinator. Coordinator waits for all workers and commands them to
+  /// start.
+  void sync_start();
+
+  /// Sends the result of worker to the coordinator.
+  void send_result(const std::string& result);
+
+  /// Receives the results of all workers. Can be used only by coordinator.
+  string_vector receive_results();
+
+private:
+  typedef std::vector<int> descriptor_vector;
+
+  void close_all();
+
+  std::size_t count_;
+  std::size_t index_;
+  /// Coordinator: sockets connected with workers,
+  /// worker: single socket connected with coordinator.
+  descriptor_vector sockets_;
+  std::vector<long> worker_pids_;
+}; // class process_group
+
+} // namespace performance_test_client
+
+#endif // PROCESS_GROUP_HPP
@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <boost/assert.hpp>
+#include "size_bucket_stats.hpp"
+
+namespace performance_test_client {
+
+namespace {
+
+std::size_t bucket_index(std::size_t size)
+{
+  std::size_t index = 0;
+  for (size >>= 1; size; size >>= 1)
+  {
+    ++index;
+  }
+  return index;
+}
+
+} // anonymous namespace
+
+size_bucket_stats::bucket::bucket()
+  : writes(0)
+  , bytes(0)
+  , round_trip_times()
+{
+}
+
+size_bucket_stats::size_bucket_stats()
+  : buckets_()
+{
+}
+
+void size_bucket_stats::record_write(std::size_t size,
+    std::size_t bytes_transferred)
+{
+  bucket& b = bucket_of(size);
+  ++b.writes;
+  b.bytes += bytes_transferred;
+}
+
+void size_bucket_stats::record_round_trip(std::size_t size,
+    latency_histogram::value_type latency)
+{
+  bucket_of(size).round_trip_times.record(latency);
+}
+
+void size_bucket_stats::merge(const size_bucket_stats& other)
+{
+  if (buckets_.size() < other.buckets_.size())
+  {
+    buckets_.resize(other.buckets_.size());
+  }
+  for (std::size_t i = 0, size = other.buckets_.size(); i != size; ++i)
+  {
+    const bucket& other_bucket = other.buckets_[i];
+    bucket& this_bucket = buckets_[i];
+    this_bucket.writes += other_bucket.writes;
+    this_bucket.bytes  += other_bucket.bytes;
+    this_bucket.round_trip_times.merge(other_bucket.round_trip_times);
+  }
+}
+
+void size_bucket_stats::save(std::ostream& stream) const
+{
+  stream << buckets_.size() << '\n';
+  for (std::vector<bucket>::const_iterator i = buckets_.begin(),
+      end = buckets_.end(); i != end; ++i)
+  {
+    stream << i->writes << ' ' << i->bytes << ' ';
+    i->round_trip_times.save(stream);
+  }
+}
+
+bool size_bucket_stats::load(std::istream& stream)
+{
+  std::size_t bucket_count = 0;
+  if (!(stream >> bucket_count))
+  {
+    return false;
+  }
+  std::vector<bucket> loaded(bucket_count);
+  for (std::vector<bucket>::iterator i = loaded.begin(), end = loaded.end();
+      i != end; ++i)
+  {
+    if (!(stream >> i->writes >> i->bytes) || !i->round_trip_times.load(stream))
+    {
+      return false;
+    }
+  }
+  buckets_.swap(loaded);
+  return true;
+}
+
+std::size_t size_bucket_stats::bucket_count() const
+{
+  return buckets_.size();
+}
+
+std::size_t size_bucket_stats::used_bucket_count() const
+{
+  std::size_t count = 0;
+  for (std::vector<bucket>::const_iterator i = buckets_.begin(),
+      end = buckets_.end(); i != end; ++i)
+  {
+    if (i->writes)
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+const size_bucket_stats::bucket& size_bucket_stats::bucket_at(
+    std::size_t index) const
+{
+  BOOST_ASSERT_MSG(index < buckets_.size(), "index is out of range");
+  return buckets_[index];
+}
+
+std::size_t size_bucket_stats::bucket_lower_bound(std::size_t index)
+{
+  return std::size_t(1) << index;
+}
+
+std::size_t size_bucket_stats::bucket_upper_bound(std::size_t index)
+{
+  return (bucket_lower_bound(index) - 1) * 2 + 1;
+}
+
+size_bucket_stats::bucket& size_bucket_stats::bucket_of(std::size_t size)
+{
+  const std::size_t index = bucket_index(size);
+  if (buckets_.size() <= index)
+  {
+    buckets_.resize(index + 1);
+  }
+  return buckets_[index];
+}
+
+} // namespace performance_test_client
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SIZE_BUCKET_STATS_HPP
+#define SIZE_BUCKET_STATS_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <boost/cstdint.hpp>
+#include "latency_histogram.hpp"
+
+namespace performance_test_client {
+
+/// Statistics of writes grouped by the size of message (write).
+/**
+ * Bucket k holds sizes [2^k, 2^(k+1) - 1]. Buckets are allocated on demand.
+ */
+class size_bucket_stats
+{
+public:
+  typedef boost::uint64_t count_type;
+
+  struct bucket
+  {
+    bucket();
+
+    count_type        writes;
+    count_type        bytes;
+    latency_histogram round_trip_times;
+  }; // struct bucket
+
+  size_bucket_stats();
+
+  void record_write(std::size_t size, std::size_t bytes_transferred);
+  void record_round_trip(std::size_t size,
+      latency_histogram::value_type latency);
+  void merge(const size_bucket_stats& other);
+
+  /// Writes stats in text form which can be read back by load.
+  void save(std::ostream& stream) const;
+  /// Returns false if stream doesn't hold valid stats.
+  bool load(std::istream& stream);
+
+  std::size_t bucket_count() const;
+  /// Returns the number of buckets having at least one write.
+  std::size_t used_bucket_count() const;
+  const bucket& bucket_at(std::size_t index) const;
+
+  static std::size_t bucket_lower_bound(std::size_t index);
+  static std::size_t bucket_upper_bound(std::size_t index);
+
+private:
+  bucket& bucket_of(std::size_t size);
+
+  std::vector<bucket> buckets_;
+}; // class size_bucket_stats
+
+} // namespace performance_test_client
+
+#endif // SIZE_BUCKET_STATS_HPP
@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <boost/assert.hpp>
+#include "size_distribution.hpp"
+
+namespace performance_test_client {
+
+size_distribution size_distribution::fixed(std::size_t size)
+{
+  BOOST_ASSERT_MSG(size > 0, "size must be > 0");
+
+  return size_distribution(size_distribution_type::fixed, size, size);
+}
+
+size_distribution size_distribution::uniform(std::size_t min_size,
+    std::size_t max_size)
+{
+  BOOST_ASSERT_MSG(min_size > 0, "min_size must be > 0");
+  BOOST_ASSERT_MSG(min_size <= max_size, "min_size must be <= max_size");
+
+  size_distribution distribution(size_distribution_type::uniform,
+      min_size, max_size);
+  distribution.uniform_ =
+      ma::detail::uniform_int_distribution<std::size_t>(min_size, max_size);
+  return distribution;
+}
+
+size_distribution size_distribution::lognormal(double median, double sigma,
+    std::size_t min_size, std::size_t max_size)
+{
+  BOOST_ASSERT_MSG(median > 0, "median must be > 0");
+  BOOST_ASSERT_MSG(sigma > 0, "sigma must be > 0");
+  BOOST_ASSERT_MSG(min_size > 0, "min_size must be > 0");
+  BOOST_ASSERT_MSG(min_size <= max_size, "min_size must be <= max_size");
+
+  size_distribution distribution(size_distribution_type::lognormal,
+      min_size, max_size);
+  distribution.median_ = median;
+  distribution.sigma_  = sigma;
+  // Median of log-normal distribution is exp(m)
+  distribution.lognormal_ =
+      ma::detail::lognormal_distribution<double>(std::log(median), sigma);
+  return distribution;
+}
+
+size_distribution size_distribution::table(const size_vector& sizes,
+    const weight_vector& weights)
+{
+  BOOST_ASSERT_MSG(!sizes.empty(), "sizes must not be empty");
+  BOOST_ASSERT_MSG(sizes.size() == weights.size(),
+      "sizes and weights must be of the same size");
+
+  size_distribution distribution(size_distribution_type::table,
+      *std::min_element(sizes.begin(), sizes.end()),
+      *std::max_element(sizes.begin(), sizes.end()));
+  distribution.table_sizes_   = sizes;
+  distribution.table_weights_ = weights;
+  distribution.table_index_ = ma::detail::discrete_distribution<std::size_t>(
+      weights.begin(), weights.end());
+  return distribution;
+}
+
+size_distribution::size_distribution(size_distribution_type::value_t type,
+    std::size_t min_size, std::size_t max_size)
+  : type_(type)
+  , min_size_(min_size)
+  , max_size_(max_size)
+  , median_(0)
+  , sigma_(0)
+  , uniform_()
+  , lognormal_()
+  , table_index_()
+  , table_sizes_()
+  , table_weights_()
+{
+}
+
+size_distribution_type::value_t size_distribution::type() const
+{
+  return type_;
+}
+
+std::size_t size_distribution::min_size() const
+{
+  return min_size_;
+}
+
+std::size_t size_distribution::max_size() const
+{
+  return max_size_;
+}
+
+std::string size_distribution::description() const
+{
+  std::ostringstream stream;
+  switch (type_)
+  {
+  case size_distribution_type::uniform:
+    stream << "uniform " << min_size_ << '-' << max_size_;
+    break;
+
+  case size_distribution_type::lognormal:
+    stream << "lognormal median " << median_ << ", sigma " << sigma_
+           << ", clamped by " << min_size_ << '-' << max_size_;
+    break;
+
+  case size_distribution_type::table:
+    stream << "table:";
+    for (std::size_t i = 0, size = table_sizes_.size(); i != size; ++i)
+    {
+      stream << ' ' << table_sizes_[i] << " (" << table_weights_[i] << ')';
+    }
+    break;
+
+  default:
+    stream << "fixed " << max_size_;
+    break;
+  }
+  return stream.str();
+}
+
+std::size_t size_distribution::operator()(xorshift_engine& engine)
+{
+  switch (type_)
+  {
+  case size_distribution_type::uniform:
+    return uniform_(engine);
+
+  case size_distribution_type::lognormal:
+    {
+      const double size = std::floor(lognormal_(engine) + 0.5);
+      if (size <= static_cast<double>(min_size_))
+      {
+        return min_size_;
+      }
+      if (size >= static_cast<double>(max_size_))
+      {
+        return max_size_;
+      }
+      return static_cast<std::size_t>(size);
+    }
+
+  case size_distribution_type::table:
+    return table_sizes_[table_index_(engine)];
+
+  default:
+    return max_size_;
+  }
+}
+
+bool read_size_table(std::istream& stream,
+    size_distribution::size_vector& sizes,
+    size_distribution::weight_vector& weights)
+{
+  size_distribution::size_vector   read_sizes;
+  size_distribution::weight_vector read_weights;
+  double total_weight = 0;
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    std::istringstream line_stream(line);
+    std::string first_token;
+    if (!(line_stream >> first_token) || ('#' == first_token[0]))
+    {
+      continue;
+    }
+
+    std::istringstream size_stream(first_token);
+    std::size_t size = 0;
+    double weight = 0;
+    if (!(size_stream >> size) || !size || !(line_stream >> weight)
+        || (weight < 0))
+    {
+      return false;
+    }
+    read_sizes.push_back(size);
+    read_weights.push_back(weight);
+    total_weight += weight;
+  }
+
+  if (read_sizes.empty() || !(total_weight > 0))
+  {
+    return false;
+  }
+  sizes.swap(read_sizes);
+  weights.swap(read_weights);
+  return true;
+}
+
+} // namespace performance_test_client
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SIZE_DISTRIBUTION_HPP
+#define SIZE_DISTRIBUTION_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <istream>
+#include <ma/detail/random.hpp>
+#include "xorshift_engine.hpp"
+
+namespace performance_test_client {
+
+struct size_distribution_type
+{
+  enum value_t {fixed, uniform, lognormal, table};
+};
+
+/// Distribution of sizes of messages (writes).
+/**
+ * Is copyable, so each session can have its own copy and sample sizes
+ * without synchronization.
+ */
+class size_distribution
+{
+public:
+  typedef std::vector<std::size_t> size_vector;
+  typedef std::vector<double>      weight_vector;
+
+  static size_distribution fixed(std::size_t size);
+  static size_distribution uniform(std::size_t min_size, std::size_t max_size);
+  /// Sampled sizes are clamped by [min_size, max_size].
+  static size_distribution lognormal(double median, double sigma,
+      std::size_t min_size, std::size_t max_size);
+  static size_distribution table(const size_vector& sizes,
+      const weight_vector& weights);
+
+  size_distribution_type::value_t type() const;
+  std::size_t min_size() const;
+  std::size_t max_size() const;
+  std::string description() const;
+
+  std::size_t operator()(xorshift_engine& engine);
+
+private:
+  size_distribution(size_distribution_type::value_t type,
+      std::size_t min_size, std::size_t max_size);
+
+  size_distribution_type::value_t type_;
+  std::size_t min_size_;
+  std::size_t max_size_;
+  double median_;
+  double sigma_;
+  ma::detail::uniform_int_distribution<std::size_t> uniform_;
+  ma::detail::lognormal_distribution<double>        lognormal_;
+  ma::detail::discrete_distribution<std::size_t>    table_index_;
+  size_vector   table_sizes_;
+  weight_vector table_weights_;
+}; // class size_distribution
+
+/// Reads the table of sizes with their weights. Each line holds size and
+/// weight separated by whitespace. Empty lines and lines starting with '#'
+/// are skipped. Returns false if the table is invalid or empty.
+bool read_size_table(std::istream& stream,
+    size_distribution::size_vector& sizes,
+    size_distribution::weight_vector& weights);
+
+} // namespace performance_test_client
+
+#endif // SIZE_DISTRIBUTION_HPP
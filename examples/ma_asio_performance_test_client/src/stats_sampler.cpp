@@ -0,0 +1,302 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <ma/config.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/detail/functional.hpp>
+#include "stats_sampler.hpp"
+
+namespace performance_test_client {
+
+namespace {
+
+double to_seconds(const boost::posix_time::time_duration& duration)
+{
+  return static_cast<double>(duration.total_microseconds()) / 1000000;
+}
+
+double calc_rate(boost::uint64_t value,
+    const boost::posix_time::time_duration& duration)
+{
+  const double seconds = to_seconds(duration);
+  return seconds > 0 ? static_cast<double>(value) / seconds : 0;
+}
+
+} // anonymous namespace
+
+stats_sampler::stats_sampler(boost::asio::io_service& io_service,
+    const live_stats& stats,
+    const boost::posix_time::time_duration& interval,
+    const boost::posix_time::time_duration& warmup, bool print_samples)
+  : live_stats_(stats)
+  , interval_(interval)
+  , warmup_(warmup)
+  , print_samples_(print_samples)
+  , io_service_(io_service)
+  , timer_(io_service)
+  , start_time_()
+  , next_sample_time_()
+  , last_sample_time_()
+  , last_values_()
+  , samples_()
+  , stopped_(false)
+{
+}
+
+void stats_sampler::async_start()
+{
+  io_service_.post(ma::make_custom_alloc_handler(timer_allocator_,
+      ma::detail::bind(&this_type::do_start, this)));
+}
+
+void stats_sampler::async_stop()
+{
+  io_service_.post(ma::make_custom_alloc_handler(stop_allocator_,
+      ma::detail::bind(&this_type::do_stop, this)));
+}
+
+const stats_sampler::sample_vector& stats_sampler::samples() const
+{
+  return samples_;
+}
+
+void stats_sampler::save(std::ostream& stream) const
+{
+  stream << samples_.size() << '\n';
+  for (sample_vector::const_iterator i = samples_.begin(),
+      end = samples_.end(); i != end; ++i)
+  {
+    stream << i->connected_sessions << ' '
+           << i->connects << ' '
+           << i->bytes_written << ' '
+           << i->bytes_read << ' '
+           << i->messages << '\n';
+  }
+}
+
+bool stats_sampler::merge(std::istream& stream)
+{
+  std::size_t count = 0;
+  if (!(stream >> count))
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    sample other = sample();
+    if (!(stream >> other.connected_sessions >> other.connects
+        >> other.bytes_written >> other.bytes_read >> other.messages))
+    {
+      return false;
+    }
+    if (samples_.empty())
+    {
+      // Nothing to attribute the amounts to
+      continue;
+    }
+    sample& s = i < samples_.size() ? samples_[i] : samples_.back();
+    // Number of connected sessions is a level, not an amount
+    if (i < samples_.size())
+    {
+      s.connected_sessions += other.connected_sessions;
+    }
+    s.connects      += other.connects;
+    s.bytes_written += other.bytes_written;
+    s.bytes_read    += other.bytes_read;
+    s.messages      += other.messages;
+  }
+  return true;
+}
+
+void stats_sampler::print() const
+{
+  for (sample_vector::const_iterator i = samples_.begin(),
+      end = samples_.end(); i != end; ++i)
+  {
+    print(*i);
+  }
+}
+
+void stats_sampler::write(std::ostream& stream,
+    sample_output_format::value_t format) const
+{
+  switch (format)
+  {
+  case sample_output_format::json:
+    write_json(stream);
+    break;
+  default:
+    write_csv(stream);
+    break;
+  }
+}
+
+void stats_sampler::do_start()
+{
+  if (stopped_)
+  {
+    return;
+  }
+
+  start_time_ = time_traits_type::now();
+  next_sample_time_ = start_time_;
+  last_sample_time_ = start_time_;
+  last_values_ = live_stats_.get();
+  if (!interval_.is_special() && (interval_.ticks() > 0))
+  {
+    start_timer();
+  }
+}
+
+void stats_sampler::do_stop()
+{
+  if (stopped_)
+  {
+    return;
+  }
+
+  stopped_ = true;
+  boost::system::error_code ignored;
+  timer_.cancel(ignored);
+
+  // Take the last (partial) sample unless it is too short to give
+  // meaningful rates
+  const time_type now = time_traits_type::now();
+  const boost::posix_time::time_duration tail_duration =
+      time_traits_type::to_posix_duration(
+          time_traits_type::subtract(now, last_sample_time_));
+  if (samples_.empty() || (tail_duration * 2 >= interval_))
+  {
+    take_sample(now);
+  }
+}
+
+void stats_sampler::start_timer()
+{
+  // Schedule by absolute time to not accumulate drift
+  next_sample_time_ = time_traits_type::add(next_sample_time_,
+      ma::to_steady_deadline_timer_duration(interval_));
+  timer_.expires_at(next_sample_time_);
+  timer_.async_wait(ma::make_custom_alloc_handler(timer_allocator_,
+      ma::detail::bind(&this_type::handle_timer, this,
+          ma::detail::placeholders::_1)));
+}
+
+void stats_sampler::handle_timer(const boost::system::error_code& error)
+{
+  if (stopped_ || (boost::asio::error::operation_aborted == error))
+  {
+    return;
+  }
+
+  take_sample(time_traits_type::now());
+  start_timer();
+}
+
+void stats_sampler::take_sample(const time_type& now)
+{
+  const live_stats::snapshot values = live_stats_.get();
+
+  sample s;
+  s.time = time_traits_type::to_posix_duration(
+      time_traits_type::subtract(now, start_time_));
+  s.duration = time_traits_type::to_posix_duration(
+      time_traits_type::subtract(now, last_sample_time_));
+  s.warmup = s.time - s.duration < warmup_;
+  s.connected_sessions = values.connected_sessions;
+  s.connects = values.connects - last_values_.connects;
+  s.bytes_written = values.bytes_written - last_values_.bytes_written;
+  s.bytes_read = values.bytes_read - last_values_.bytes_read;
+  s.messages = values.messages - last_values_.messages;
+
+  samples_.push_back(s);
+  last_sample_time_ = now;
+  last_values_ = values;
+
+  if (print_samples_)
+  {
+    print(s);
+  }
+}
+
+void stats_sampler::print(const sample& s) const
+{
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(3)
+       << "Sample " << std::setw(10) << to_seconds(s.time) << " s"
+       << (s.warmup ? " (warm-up)" : "          ")
+       << ": sessions: " << s.connected_sessions
+       << std::setprecision(0)
+       << ", connects: " << calc_rate(s.connects, s.duration) << " 1/s"
+       << ", written: "
+       << calc_rate(s.bytes_written, s.duration) << " B/s"
+       << ", read: " << calc_rate(s.bytes_read, s.duration) << " B/s"
+       << ", messages: " << calc_rate(s.messages, s.duration) << " 1/s";
+  std::cout << line.str() << std::endl;
+}
+
+void stats_sampler::write_csv(std::ostream& stream) const
+{
+  stream << "time_ms,duration_ms,warmup,connected_sessions,"
+         << "connects,bytes_written,bytes_read,messages,"
+         << "connects_per_second,write_bytes_per_second,"
+         << "read_bytes_per_second,messages_per_second\n"
+         << std::fixed << std::setprecision(1);
+  for (sample_vector::const_iterator i = samples_.begin(),
+      end = samples_.end(); i != end; ++i)
+  {
+    stream << i->time.total_milliseconds() << ','
+           << i->duration.total_milliseconds() << ','
+           << (i->warmup ? 1 : 0) << ','
+           << i->connected_sessions << ','
+           << i->connects << ','
+           << i->bytes_written << ','
+           << i->bytes_read << ','
+           << i->messages << ','
+           << calc_rate(i->connects, i->duration) << ','
+           << calc_rate(i->bytes_written, i->duration) << ','
+           << calc_rate(i->bytes_read, i->duration) << ','
+           << calc_rate(i->messages, i->duration) << '\n';
+  }
+}
+
+void stats_sampler::write_json(std::ostream& stream) const
+{
+  stream << "{\n"
+         << "  \"interval_ms\": " << interval_.total_milliseconds() << ",\n"
+         << "  \"warmup_ms\": " << warmup_.total_milliseconds() << ",\n"
+         << "  \"samples\": ["
+         << std::fixed << std::setprecision(1);
+  for (sample_vector::const_iterator i = samples_.begin(),
+      end = samples_.end(); i != end; ++i)
+  {
+    stream << (samples_.begin() == i ? "\n" : ",\n")
+           << "    {\"time_ms\": " << i->time.total_milliseconds()
+           << ", \"duration_ms\": " << i->duration.total_milliseconds()
+           << ", \"warmup\": " << (i->warmup ? "true" : "false")
+           << ", \"connected_sessions\": " << i->connected_sessions
+           << ", \"connects\": " << i->connects
+           << ", \"bytes_written\": " << i->bytes_written
+           << ", \"bytes_read\": " << i->bytes_read
+           << ", \"messages\": " << i->messages
+           << ", \"connects_per_second\": "
+           << calc_rate(i->connects, i->duration)
+           << ", \"write_bytes_per_second\": "
+           << calc_rate(i->bytes_written, i->duration)
+           << ", \"read_bytes_per_second\": "
+           << calc_rate(i->bytes_read, i->duration)
+           << ", \"messages_per_second\": "
+           << calc_rate(i->messages, i->duration) << '}';
+  }
+  stream << "\n  ]\n"
+         << "}\n";
+}
+
+} // namespace performance_test_client
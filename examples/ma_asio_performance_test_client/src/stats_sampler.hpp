@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef STATS_SAMPLER_HPP
+#define STATS_SAMPLER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/handler_allocator.hpp>
+#include "live_stats.hpp"
+
+namespace performance_test_client {
+
+struct sample_output_format
+{
+  enum value_t {csv, json};
+};
+
+/// Periodically takes samples of live_stats building the time series of
+/// test. Works within (single threaded) io_service.
+class stats_sampler : private boost::noncopyable
+{
+private:
+  typedef stats_sampler this_type;
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+
+public:
+  struct sample
+  {
+    /// Time passed since the start of sampling till the end of sample.
+    boost::posix_time::time_duration time;
+    boost::posix_time::time_duration duration;
+    /// Sample (partially) belongs to warm-up period.
+    bool warmup;
+    /// Number of connected sessions at the end of sample.
+    boost::uint64_t connected_sessions;
+    /// Amounts completed during sample.
+    boost::uint64_t connects;
+    boost::uint64_t bytes_written;
+    boost::uint64_t bytes_read;
+    boost::uint64_t messages;
+  }; // struct sample
+
+  typedef std::vector<sample> sample_vector;
+
+  /// Zero interval means no samples are taken except the final one.
+  /// Samples are printed as soon as they are taken if print_samples is true.
+  stats_sampler(boost::asio::io_service& io_service, const live_stats& stats,
+      const boost::posix_time::time_duration& interval,
+      const boost::posix_time::time_duration& warmup, bool print_samples);
+
+  void async_start();
+  void async_stop();
+
+  /// Can be used only when io_service is stopped.
+  const sample_vector& samples() const;
+
+  /// Saves samples to be loaded by other process. Can be used only when
+  /// io_service is stopped.
+  void save(std::ostream& stream) const;
+
+  /// Loads samples saved by other process and sums them with own ones
+  /// interval by interval. Samples of other process which have no pair
+  /// (f.e. the last partial one) are added to the last own sample.
+  /// Can be used only when io_service is stopped.
+  bool merge(std::istream& stream);
+
+  /// Prints all taken samples. Can be used only when io_service is stopped.
+  void print() const;
+
+  void write(std::ostream& stream, sample_output_format::value_t format) const;
+
+private:
+  void do_start();
+  void do_stop();
+  void start_timer();
+  void handle_timer(const boost::system::error_code& error);
+  void take_sample(const time_type& now);
+  void print(const sample& s) const;
+  void write_csv(std::ostream& stream) const;
+  void write_json(std::ostream& stream) const;
+
+  const live_stats& live_stats_;
+  const boost::posix_time::time_duration interval_;
+  const boost::posix_time::time_duration warmup_;
+  const bool print_samples_;
+  boost::asio::io_service& io_service_;
+  ma::steady_deadline_timer timer_;
+  time_type start_time_;
+  time_type next_sample_time_;
+  time_type last_sample_time_;
+  live_stats::snapshot last_values_;
+  sample_vector samples_;
+  bool stopped_;
+  ma::in_place_handler_allocator<256> stop_allocator_;
+  ma::in_place_handler_allocator<256> timer_allocator_;
+}; // class stats_sampler
+
+} // namespace performance_test_client
+
+#endif // STATS_SAMPLER_HPP
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef XORSHIFT_ENGINE_HPP
+#define XORSHIFT_ENGINE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+
+namespace performance_test_client {
+
+/// Small and fast pseudo-random number generator (xorshift64).
+/**
+ * Meets the requirements of uniform random bit generator, so it can be used
+ * with random number distributions. State is 8 bytes only, so each session
+ * can have its own generator.
+ */
+class xorshift_engine
+{
+public:
+  typedef boost::uint64_t result_type;
+
+  explicit xorshift_engine(result_type seed);
+
+  static BOOST_CONSTEXPR result_type (min)()
+  {
+    return 1;
+  }
+
+  static BOOST_CONSTEXPR result_type (max)()
+  {
+    return ~static_cast<result_type>(0);
+  }
+
+  result_type operator()();
+
+private:
+  result_type state_;
+}; // class xorshift_engine
+
+inline xorshift_engine::xorshift_engine(result_type seed)
+  : state_(seed)
+{
+  BOOST_ASSERT_MSG(seed, "seed must be non zero");
+}
+
+inline xorshift_engine::result_type xorshift_engine::operator()()
+{
+  state_ ^= state_ << 13;
+  state_ ^= state_ >> 7;
+  state_ ^= state_ << 17;
+  return state_;
+}
+
+} // namespace performance_test_client
+
+#endif // XORSHIFT_ENGINE_HPP
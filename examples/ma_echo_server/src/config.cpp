@@ -7,6 +7,7 @@
 
 #include <string>
 #include <limits>
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
 #include <boost/logic/tribool.hpp>
@@ -19,22 +20,61 @@ namespace echo_server {
 
 namespace {
 
+const char* asio_demultiplexer_name()
+{
+#if defined(BOOST_ASIO_HAS_IO_URING) && !defined(BOOST_ASIO_HAS_EPOLL)
+  return "io_uring";
+#elif defined(BOOST_ASIO_HAS_IOCP)
+  return "IOCP";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+  return "epoll";
+#elif defined(BOOST_ASIO_HAS_KQUEUE)
+  return "kqueue";
+#elif defined(BOOST_ASIO_HAS_DEV_POLL)
+  return "/dev/poll";
+#else
+  return "select";
+#endif
+}
+
 const char* help_option_name = "help";
 const char* port_option_name = "port";
 const char* session_manager_threads_option_name = "session-manager-threads";
 const char* session_threads_option_name         = "session-threads";
 const char* stop_timeout_option_name            = "stop-timeout";
 const char* max_sessions_option_name            = "max-sessions";
+const char* accept_resume_sessions_option_name  = "accept-resume-sessions";
 const char* recycled_sessions_option_name       = "recycled-sessions";
+const char* max_stopping_sessions_option_name   = "max-stopping-sessions";
+const char* warm_sessions_option_name           = "warm-sessions";
 const char* listen_address_option_name          = "address";
 const char* listen_backlog_option_name          = "listen-backlog";
+const char* defer_accept_option_name            = "defer-accept";
+const char* fast_open_option_name               = "fast-open";
+const char* read_at_start_option_name           = "read-at-start";
 const char* buffer_size_option_name             = "buffer";
 const char* inactivity_timeout_option_name      = "inactivity-timeout";
 const char* max_transfer_size_option_name       = "max-transfer";
 const char* socket_recv_buffer_size_option_name = "sock-recv-buffer";
 const char* socket_send_buffer_size_option_name = "sock-send-buffer";
 const char* socket_no_delay_option_name         = "sock-no-delay";
+const char* socket_busy_poll_option_name        = "sock-busy-poll";
+const char* busy_poll_option_name               = "busy-poll";
+const char* splice_option_name                  = "splice";
+const char* zerocopy_threshold_option_name      = "zerocopy-threshold";
+const char* speculative_read_option_name        = "speculative-read";
+const char* socket_profile_option_name          = "sock-profile";
+const char* socket_notsent_lowat_option_name    = "sock-notsent-lowat";
 const char* demux_option_name                   = "demux-per-work-thread";
+const char* stats_interval_option_name          = "stats-interval";
+const char* stats_format_option_name            = "stats-format";
+const char* metrics_port_option_name            = "metrics-port";
+const char* metrics_address_option_name         = "metrics-address";
+const char* text_stats_format_name              = "text";
+const char* json_stats_format_name              = "json";
+const char* none_socket_profile_name            = "none";
+const char* latency_socket_profile_name         = "latency";
+const char* throughput_socket_profile_name      = "throughput";
 const std::string default_system_value          = "system default";
 
 template <typename Value>
@@ -92,6 +132,76 @@ boost::optional<int> read_socket_buffer_size(
   return buffer_size;
 }
 
+stats_format::value_t read_stats_format(
+    const boost::program_options::variables_map& options_values)
+{
+  const std::string format_name =
+      options_values[stats_format_option_name].as<std::string>();
+  if (text_stats_format_name == format_name)
+  {
+    return stats_format::text;
+  }
+  if (json_stats_format_name == format_name)
+  {
+    return stats_format::json;
+  }
+  using boost::program_options::validation_error;
+  boost::throw_exception(validation_error(
+      validation_error::invalid_option_value, std::string(),
+      stats_format_option_name));
+}
+
+std::string to_string(stats_format::value_t value)
+{
+  switch (value)
+  {
+  case stats_format::json:
+    return json_stats_format_name;
+  default:
+    return text_stats_format_name;
+  }
+}
+
+ma::echo::server::socket_profile::value_t read_socket_profile(
+    const boost::program_options::variables_map& options_values)
+{
+  using ma::echo::server::socket_profile;
+
+  const std::string profile_name =
+      options_values[socket_profile_option_name].as<std::string>();
+  if (none_socket_profile_name == profile_name)
+  {
+    return socket_profile::none;
+  }
+  if (latency_socket_profile_name == profile_name)
+  {
+    return socket_profile::latency;
+  }
+  if (throughput_socket_profile_name == profile_name)
+  {
+    return socket_profile::throughput;
+  }
+  using boost::program_options::validation_error;
+  boost::throw_exception(validation_error(
+      validation_error::invalid_option_value, std::string(),
+      socket_profile_option_name));
+}
+
+std::string to_string(ma::echo::server::socket_profile::value_t value)
+{
+  using ma::echo::server::socket_profile;
+
+  switch (value)
+  {
+  case socket_profile::latency:
+    return latency_socket_profile_name;
+  case socket_profile::throughput:
+    return throughput_socket_profile_name;
+  default:
+    return none_socket_profile_name;
+  }
+}
+
 std::size_t calc_session_manager_thread_count(
     std::size_t /*hardware_concurrency*/)
 {
@@ -158,11 +268,31 @@ boost::program_options::options_description build_cmd_options_description(
       boost::program_options::value<std::size_t>()->default_value(10000),
       "set the maximum number of simultaneously active sessions"
     )
+    (
+      accept_resume_sessions_option_name,
+      boost::program_options::value<std::size_t>(),
+      "set the number of active sessions at which paused (due to reaching" \
+          " of the maximum number of active sessions) accept of new sessions" \
+          " is resumed (default is 90% of the maximum number of active" \
+          " sessions)"
+    )
     (
       recycled_sessions_option_name,
       boost::program_options::value<std::size_t>()->default_value(100),
       "set the maximum number of pooled inactive sessions"
     )
+    (
+      warm_sessions_option_name,
+      boost::program_options::value<std::size_t>()->default_value(0),
+      "set the number of pooled inactive sessions created at server start" \
+          " (per demultiplexer in demultiplexer-per-work-thread mode)"
+    )
+    (
+      max_stopping_sessions_option_name,
+      boost::program_options::value<std::size_t>()->default_value(100),
+      "set the maximum number of sessions whose stop is initiated at once" \
+          " during server stop"
+    )
     (
       listen_address_option_name,
       boost::program_options::value<std::string>()->default_value(
@@ -174,6 +304,26 @@ boost::program_options::options_description build_cmd_options_description(
       boost::program_options::value<int>()->default_value(6),
       "set the size of TCP listen backlog"
     )
+    (
+      defer_accept_option_name,
+      boost::program_options::value<int>(),
+      "set TCP_DEFER_ACCEPT option of listening socket (seconds): connection" \
+          " is accepted only when its first data arrives, is supported only" \
+          " on Linux"
+    )
+    (
+      fast_open_option_name,
+      boost::program_options::value<int>(),
+      "set TCP_FASTOPEN option of listening socket (max number of pending" \
+          " Fast Open requests), requires server side TCP Fast Open be" \
+          " enabled in system"
+    )
+    (
+      read_at_start_option_name,
+      boost::program_options::value<bool>()->default_value(false),
+      "set reading of the first data right at session's start, without" \
+          " waiting for demultiplexer (makes sense with deferred accept)"
+    )
     (
       buffer_size_option_name,
       boost::program_options::value<std::size_t>()->default_value(4096),
@@ -205,11 +355,83 @@ boost::program_options::options_description build_cmd_options_description(
       boost::program_options::value<bool>(),
       "set TCP_NODELAY option of session's socket"
     )
+    (
+      socket_busy_poll_option_name,
+      boost::program_options::value<int>(),
+      "set SO_BUSY_POLL option of session's socket (microseconds), is" \
+          " supported only on Linux"
+    )
+    (
+      splice_option_name,
+      boost::program_options::value<bool>()->default_value(false),
+      "set zero-copy echo mode: data is moved from socket to socket with" \
+          " splice() through per-session pipe, is supported only on Linux" \
+          " (buffered echo is used otherwise)"
+    )
+    (
+      zerocopy_threshold_option_name,
+      boost::program_options::value<std::size_t>(),
+      "set the minimal size of session's write sent with MSG_ZEROCOPY" \
+          " (bytes), is supported only on Linux (turned off if not" \
+          " specified)"
+    )
+    (
+      speculative_read_option_name,
+      boost::program_options::value<bool>()->default_value(false),
+      "set speculative (non-blocking synchronous) reads right after" \
+          " session's write completion and adaptive size of session's reads"
+    )
+    (
+      socket_profile_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          none_socket_profile_name),
+      "set the profile of session's socket: none, latency (TCP_NODELAY" \
+          " and TCP_QUICKACK) or throughput (TCP_NOTSENT_LOWAT and" \
+          " TCP_CORK around bursts of writes), TCP_QUICKACK and TCP_CORK" \
+          " are supported only on Linux"
+    )
+    (
+      socket_notsent_lowat_option_name,
+      boost::program_options::value<int>(),
+      "set TCP_NOTSENT_LOWAT option of session's socket (bytes), is" \
+          " set to 131072 by throughput profile if not specified"
+    )
+    (
+      busy_poll_option_name,
+      boost::program_options::value<long>()->default_value(0),
+      "set the time sessions' threads spin polling for ready handlers" \
+          " before blocking (microseconds), 0 means no spinning, makes" \
+          " sense only if sessions' threads have dedicated CPUs"
+    )
     (
       demux_option_name,
       boost::program_options::value<bool>()->default_value(
           default_ios_per_work_thread),
       "set demultiplexer-per-work-thread mode on"
+    )
+    (
+      stats_interval_option_name,
+      boost::program_options::value<long>(),
+      "set the interval of periodic server statistics reporting (seconds)"
+    )
+    (
+      stats_format_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          text_stats_format_name),
+      "set the format of periodic server statistics reporting (text or json)"
+    )
+    (
+      metrics_port_option_name,
+      boost::program_options::value<unsigned short>(),
+      "set the TCP port number of HTTP endpoint exposing server statistics" \
+          " in Prometheus format (turned off if not specified)"
+    )
+    (
+      metrics_address_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          boost::asio::ip::address_v4::loopback().to_string()),
+      "set the TCP address of HTTP endpoint exposing server statistics" \
+          " (IPv4 or IPv6)"
     );
 
   return description;
@@ -239,6 +461,25 @@ void print_config(std::ostream& stream, std::size_t cpu_count,
   const ma::echo::server::session_config& session_config =
       session_manager_config.managed_session_config;
 
+  boost::optional<long> stats_interval_sec = boost::none;
+  if (exec_config.stats_interval)
+  {
+    stats_interval_sec = exec_config.stats_interval->total_seconds();
+  }
+
+  boost::optional<boost::int64_t> busy_poll_usec = boost::none;
+  if (exec_config.busy_poll)
+  {
+    busy_poll_usec = exec_config.busy_poll->total_microseconds();
+  }
+
+  std::string metrics_endpoint = "none";
+  if (exec_config.metrics_endpoint)
+  {
+    metrics_endpoint =
+        boost::lexical_cast<std::string>(*exec_config.metrics_endpoint);
+  }
+
   boost::optional<long> session_inactivity_timeout_sec = boost::none;
   if (ma::echo::server::session_config::optional_time_duration timeout =
       session_config.inactivity_timeout)
@@ -262,6 +503,12 @@ void print_config(std::ostream& stream, std::size_t cpu_count,
          << "Demultiplexer-per-work-thread mode    : "
          << to_string(exec_config.ios_per_work_thread)
          << std::endl
+         << "Asio demultiplexer                    : "
+         << asio_demultiplexer_name()
+         << std::endl
+         << "Threads busy poll (microseconds)      : "
+         << to_string(busy_poll_usec, "none")
+         << std::endl
          << "Server listen address                 : "
          << session_manager_config.accepting_endpoint.address()
          << std::endl
@@ -271,15 +518,39 @@ void print_config(std::ostream& stream, std::size_t cpu_count,
          << "Server stop timeout (seconds)         : "
          << exec_config.stop_timeout.total_seconds()
          << std::endl
+         << "Statistics interval (seconds)         : "
+         << to_string(stats_interval_sec, "none")
+         << std::endl
+         << "Statistics format                     : "
+         << to_string(exec_config.stats_output_format)
+         << std::endl
+         << "Metrics (Prometheus) HTTP endpoint    : "
+         << metrics_endpoint
+         << std::endl
          << "Maximum number of active sessions     : "
          << session_manager_config.max_session_count
          << std::endl
+         << "Accept resume number of sessions      : "
+         << session_manager_config.accept_resume_session_count
+         << std::endl
          << "Maximum number of recycled sessions   : "
          << session_manager_config.recycled_session_count
          << std::endl
+         << "Number of pre-created sessions        : "
+         << session_manager_config.warm_session_count
+         << std::endl
+         << "Server stop batch size (sessions)     : "
+         << session_manager_config.max_stopping_sessions
+         << std::endl
          << "TCP listen backlog size               : "
          << session_manager_config.listen_backlog
          << std::endl
+         << "TCP deferred accept timeout (seconds) : "
+         << to_string(session_manager_config.defer_accept, "none")
+         << std::endl
+         << "TCP Fast Open queue size              : "
+         << to_string(session_manager_config.fast_open_queue_size, "none")
+         << std::endl
          << "Size of session's buffer (bytes)      : "
          << session_config.buffer_size
          << std::endl
@@ -299,6 +570,30 @@ void print_config(std::ostream& stream, std::size_t cpu_count,
          << std::endl
          << "Session's socket Nagle algorithm is            : "
          << to_string(session_config.no_delay, default_system_value)
+         << std::endl
+         << "Session's socket busy poll (microseconds)      : "
+         << to_string(session_config.socket_busy_poll, default_system_value)
+         << std::endl
+         << "Session's zero-copy (splice) echo mode         : "
+         << to_string(session_config.splice)
+         << std::endl
+         << "Session's zero-copy send threshold (bytes)     : "
+         << to_string(session_config.zerocopy_threshold, "none")
+         << std::endl
+         << "Session's speculative reads                    : "
+         << to_string(session_config.speculative_read)
+         << std::endl
+         << "Session's socket profile                       : "
+         << to_string(session_config.profile)
+         << std::endl
+         << "Session's socket not sent low watermark (bytes): "
+         << to_string(session_config.socket_notsent_lowat,
+                ma::echo::server::socket_profile::throughput
+                    == session_config.profile
+                    ? "profile default" : default_system_value)
+         << std::endl
+         << "Session's read at start                        : "
+         << to_string(session_config.read_at_start)
          << std::endl;
 }
 
@@ -335,8 +630,40 @@ execution_config build_execution_config(
   bool ios_per_work_thread =
       options_values[demux_option_name].as<bool>();
 
+  execution_config::optional_time_duration stats_interval = boost::none;
+  if (options_values.count(stats_interval_option_name))
+  {
+    long stats_interval_sec =
+        options_values[stats_interval_option_name].as<long>();
+    validate_option<long>(stats_interval_option_name, stats_interval_sec, 1);
+    stats_interval = boost::posix_time::seconds(stats_interval_sec);
+  }
+
+  stats_format::value_t stats_output_format = read_stats_format(options_values);
+
+  execution_config::optional_endpoint metrics_endpoint = boost::none;
+  if (options_values.count(metrics_port_option_name))
+  {
+    unsigned short metrics_port =
+        options_values[metrics_port_option_name].as<unsigned short>();
+    boost::asio::ip::address metrics_address =
+        boost::asio::ip::address::from_string(
+            options_values[metrics_address_option_name].as<std::string>());
+    metrics_endpoint = execution_config::endpoint_type(
+        metrics_address, metrics_port);
+  }
+
+  long busy_poll_usec = options_values[busy_poll_option_name].as<long>();
+  validate_option<long>(busy_poll_option_name, busy_poll_usec, 0);
+  execution_config::optional_time_duration busy_poll = boost::none;
+  if (busy_poll_usec)
+  {
+    busy_poll = boost::posix_time::microseconds(busy_poll_usec);
+  }
+
   return execution_config(ios_per_work_thread, session_manager_thread_count,
-      session_thread_count, boost::posix_time::seconds(stop_timeout_sec));
+      session_thread_count, boost::posix_time::seconds(stop_timeout_sec),
+      stats_interval, stats_output_format, metrics_endpoint, busy_poll);
 }
 
 ma::echo::server::session_config build_session_config(
@@ -374,9 +701,46 @@ ma::echo::server::session_config build_session_config(
   boost::optional<int> socket_send_buffer_size = read_socket_buffer_size(
       options_values, socket_send_buffer_size_option_name);
 
+  boost::optional<int> socket_busy_poll = boost::none;
+  if (options_values.count(socket_busy_poll_option_name))
+  {
+    int busy_poll = options_values[socket_busy_poll_option_name].as<int>();
+    validate_option<int>(socket_busy_poll_option_name, busy_poll, 0);
+    socket_busy_poll = busy_poll;
+  }
+
+  bool splice = options_values[splice_option_name].as<bool>();
+
+  session_config::optional_size zerocopy_threshold = boost::none;
+  if (options_values.count(zerocopy_threshold_option_name))
+  {
+    std::size_t threshold =
+        options_values[zerocopy_threshold_option_name].as<std::size_t>();
+    validate_option<std::size_t>(zerocopy_threshold_option_name, threshold, 1);
+    zerocopy_threshold = threshold;
+  }
+
+  bool speculative_read =
+      options_values[speculative_read_option_name].as<bool>();
+
+  ma::echo::server::socket_profile::value_t profile =
+      read_socket_profile(options_values);
+
+  boost::optional<int> socket_notsent_lowat = boost::none;
+  if (options_values.count(socket_notsent_lowat_option_name))
+  {
+    int notsent_lowat =
+        options_values[socket_notsent_lowat_option_name].as<int>();
+    validate_option<int>(socket_notsent_lowat_option_name, notsent_lowat, 1);
+    socket_notsent_lowat = notsent_lowat;
+  }
+
+  bool read_at_start = options_values[read_at_start_option_name].as<bool>();
+
   return session_config(buffer_size, max_transfer_size,
       socket_recv_buffer_size, socket_send_buffer_size, no_delay,
-      inactivity_timeout);
+      inactivity_timeout, socket_busy_poll, splice, zerocopy_threshold,
+      speculative_read, profile, socket_notsent_lowat, read_at_start);
 }
 
 ma::echo::server::session_manager_config build_session_manager_config(
@@ -390,22 +754,59 @@ ma::echo::server::session_manager_config build_session_manager_config(
 
   validate_option<std::size_t>(max_sessions_option_name, max_sessions, 1);
 
+  std::size_t accept_resume_sessions = max_sessions - (std::max)(
+      static_cast<std::size_t>(1), max_sessions / 10);
+  if (options_values.count(accept_resume_sessions_option_name))
+  {
+    accept_resume_sessions =
+        options_values[accept_resume_sessions_option_name].as<std::size_t>();
+    validate_option<std::size_t>(accept_resume_sessions_option_name,
+        accept_resume_sessions, 0, max_sessions - 1);
+  }
+
   std::size_t recycled_sessions =
       options_values[recycled_sessions_option_name].as<std::size_t>();
 
-  //todo: read from CMD
-  std::size_t max_stopping_sessions = 100;
+  std::size_t warm_sessions =
+      options_values[warm_sessions_option_name].as<std::size_t>();
+
+  validate_option<std::size_t>(warm_sessions_option_name, warm_sessions, 0,
+      recycled_sessions);
+
+  std::size_t max_stopping_sessions =
+      options_values[max_stopping_sessions_option_name].as<std::size_t>();
+
+  validate_option<std::size_t>(max_stopping_sessions_option_name,
+      max_stopping_sessions, 1);
 
   boost::asio::ip::address listen_address =
       boost::asio::ip::address::from_string(
           options_values[listen_address_option_name].as<std::string>());
   int listen_backlog = options_values[listen_backlog_option_name].as<int>();
 
+  boost::optional<int> defer_accept = boost::none;
+  if (options_values.count(defer_accept_option_name))
+  {
+    int defer_accept_sec = options_values[defer_accept_option_name].as<int>();
+    validate_option<int>(defer_accept_option_name, defer_accept_sec, 0);
+    defer_accept = defer_accept_sec;
+  }
+
+  boost::optional<int> fast_open_queue_size = boost::none;
+  if (options_values.count(fast_open_option_name))
+  {
+    int queue_size = options_values[fast_open_option_name].as<int>();
+    validate_option<int>(fast_open_option_name, queue_size, 1);
+    fast_open_queue_size = queue_size;
+  }
+
   using boost::asio::ip::tcp;
 
   return ma::echo::server::session_manager_config(
-      tcp::endpoint(listen_address, port), max_sessions, recycled_sessions,
-      max_stopping_sessions, listen_backlog, session_config);
+      tcp::endpoint(listen_address, port), max_sessions,
+      accept_resume_sessions, recycled_sessions, warm_sessions,
+      max_stopping_sessions, listen_backlog, session_config, defer_accept,
+      fast_open_queue_size);
 }
 
 } // namespace echo_server
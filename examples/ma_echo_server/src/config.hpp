@@ -18,7 +18,9 @@
 
 #include <cstddef>
 #include <ostream>
+#include <boost/asio.hpp>
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 #include <boost/date_time/posix_time/ptime.hpp>
 #include <ma/config.hpp>
@@ -27,21 +29,39 @@
 
 namespace echo_server {
 
+struct stats_format
+{
+  enum value_t {text, json};
+}; // struct stats_format
+
 struct execution_config
 {
 public:
   typedef boost::posix_time::time_duration time_duration_type;
+  typedef boost::optional<time_duration_type> optional_time_duration;
+  typedef boost::asio::ip::tcp::endpoint endpoint_type;
+  typedef boost::optional<endpoint_type> optional_endpoint;
 
   execution_config(
       bool ios_per_work_thread,
       std::size_t session_manager_thread_count,
       std::size_t session_thread_count,
-      const time_duration_type& stop_timeout);
+      const time_duration_type& stop_timeout,
+      const optional_time_duration& stats_interval = boost::none,
+      stats_format::value_t stats_format = stats_format::text,
+      const optional_endpoint& metrics_endpoint = boost::none,
+      const optional_time_duration& busy_poll = boost::none);
 
   bool               ios_per_work_thread;
   std::size_t        session_manager_thread_count;
   std::size_t        session_thread_count;
   time_duration_type stop_timeout;
+  optional_time_duration stats_interval;
+  stats_format::value_t  stats_output_format;
+  optional_endpoint      metrics_endpoint;
+  /// Time work threads of sessions spin polling for ready handlers before
+  /// blocking. Trades CPU for latency of wake up.
+  optional_time_duration busy_poll;
 }; // struct execution_config
 
 boost::program_options::options_description build_cmd_options_description(
@@ -85,17 +105,31 @@ inline execution_config::execution_config(
     bool the_ios_per_work_thread,
     std::size_t the_session_manager_thread_count,
     std::size_t the_session_thread_count,
-    const time_duration_type& the_stop_timeout)
+    const time_duration_type& the_stop_timeout,
+    const optional_time_duration& the_stats_interval,
+    stats_format::value_t the_stats_format,
+    const optional_endpoint& the_metrics_endpoint,
+    const optional_time_duration& the_busy_poll)
   : ios_per_work_thread(the_ios_per_work_thread)
   , session_manager_thread_count(the_session_manager_thread_count)
   , session_thread_count(the_session_thread_count)
   , stop_timeout(the_stop_timeout)
+  , stats_interval(the_stats_interval)
+  , stats_output_format(the_stats_format)
+  , metrics_endpoint(the_metrics_endpoint)
+  , busy_poll(the_busy_poll)
 {
   BOOST_ASSERT_MSG(the_session_manager_thread_count > 0,
       "session_manager_thread_count must be > 0");
 
   BOOST_ASSERT_MSG(the_session_thread_count > 0,
       "session_thread_count must be > 0");
+
+  BOOST_ASSERT_MSG(!the_stats_interval || (the_stats_interval->ticks() > 0),
+      "Defined stats_interval must be > 0");
+
+  BOOST_ASSERT_MSG(!the_busy_poll || (the_busy_poll->ticks() > 0),
+      "Defined busy_poll must be > 0");
 }
 
 } // namespace echo_server
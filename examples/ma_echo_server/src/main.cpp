@@ -13,12 +13,17 @@
 #include <cstddef>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <iomanip>
 #include <iostream>
 #include <exception>
 #include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/program_options.hpp>
+#include <boost/utility/in_place_factory.hpp>
 #include <ma/config.hpp>
 #include <ma/handler_allocator.hpp>
 #include <ma/handler_invoke_helpers.hpp>
@@ -36,6 +41,7 @@
 #include <ma/detail/thread.hpp>
 #include <ma/detail/utility.hpp>
 #include "config.hpp"
+#include "metrics_server.hpp"
 
 namespace echo_server {
 
@@ -140,7 +146,8 @@ public:
   {
     create_threads(exception_handler, execution_config.ios_per_work_thread,
         execution_config.session_manager_thread_count,
-        execution_config.session_thread_count);
+        execution_config.session_thread_count,
+        to_optional_duration(execution_config.busy_poll));
   }
 
   ~server()
@@ -183,6 +190,11 @@ public:
   }
 
 private:
+  typedef ma::steady_deadline_timer::duration_type duration_type;
+  typedef boost::optional<duration_type>           optional_duration;
+  typedef ma::steady_deadline_timer::time_type     time_type;
+  typedef ma::steady_deadline_timer::traits_type   time_traits_type;
+
   const io_service_vector session_io_services_;
   const session_factory_ptr session_factory_;
   boost::asio::io_service session_manager_io_service_;
@@ -241,13 +253,13 @@ private:
   template <typename Handler>
   void create_threads(const Handler& handler, bool ios_per_work_thread,
       std::size_t session_manager_thread_count,
-      std::size_t session_thread_count)
+      std::size_t session_thread_count, const optional_duration& busy_poll)
   {
     namespace detail = ma::detail;
 
     typedef detail::tuple<Handler> wrapped_handler_type;
     typedef void (*thread_func_type)(boost::asio::io_service&,
-        wrapped_handler_type);
+        const optional_duration&, wrapped_handler_type);
 
     wrapped_handler_type wrapped_handler = detail::make_tuple(handler);
     thread_func_type func = &this_type::thread_func<Handler>;
@@ -257,8 +269,8 @@ private:
       for (io_service_vector::const_iterator i = session_io_services_.begin(),
           end = session_io_services_.end(); i != end; ++i)
       {
-        threads_.create_thread(
-            detail::bind(func, detail::ref(**i), wrapped_handler));
+        threads_.create_thread(detail::bind(func, detail::ref(**i),
+            busy_poll, wrapped_handler));
       }
     }
     else
@@ -266,8 +278,8 @@ private:
       boost::asio::io_service& io_service = *session_io_services_.front();
       for (std::size_t i = 0; i != session_thread_count; ++i)
       {
-        threads_.create_thread(
-            detail::bind(func, detail::ref(io_service), wrapped_handler));
+        threads_.create_thread(detail::bind(func, detail::ref(io_service),
+            busy_poll, wrapped_handler));
       }
     }
 
@@ -275,17 +287,24 @@ private:
     {
       threads_.create_thread(
           detail::bind(func, detail::ref(session_manager_io_service_),
-              wrapped_handler));
+              optional_duration(), wrapped_handler));
     }
   }
 
   template <typename Handler>
   static void thread_func(boost::asio::io_service& io_service,
-      ma::detail::tuple<Handler> handler)
+      const optional_duration& busy_poll, ma::detail::tuple<Handler> handler)
   {
     try
     {
-      io_service.run();
+      if (busy_poll)
+      {
+        run_with_busy_poll(io_service, *busy_poll);
+      }
+      else
+      {
+        io_service.run();
+      }
     }
     catch (...)
     {
@@ -294,6 +313,44 @@ private:
     }
   }
 
+  /// Same as io_service::run but doesn't block until the given time passes
+  /// since the last executed handler. Readiness of sockets is polled (by
+  /// io_service::poll) meanwhile.
+  static void run_with_busy_poll(boost::asio::io_service& io_service,
+      const duration_type& busy_poll)
+  {
+    time_type last_work_time = time_traits_type::now();
+    while (!io_service.stopped())
+    {
+      if (io_service.poll())
+      {
+        last_work_time = time_traits_type::now();
+        continue;
+      }
+      if (time_traits_type::subtract(time_traits_type::now(), last_work_time)
+          < busy_poll)
+      {
+        continue;
+      }
+      // Spin budget is exhausted, so wait for the next handler
+      if (!io_service.run_one())
+      {
+        break;
+      }
+      last_work_time = time_traits_type::now();
+    }
+  }
+
+  static optional_duration to_optional_duration(
+      const echo_server::execution_config::optional_time_duration& duration)
+  {
+    if (duration)
+    {
+      return ma::to_steady_deadline_timer_duration(*duration);
+    }
+    return optional_duration();
+  }
+
   static io_service_work_vector create_works(
       const io_service_vector& io_services)
   {
@@ -323,25 +380,35 @@ struct execution_context : private boost::noncopyable
 public:
   enum state_t {starting, working, stopping, stopped};
 
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+
   execution_context(const echo_server::execution_config& the_exec_config,
       boost::asio::io_service& the_event_loop,
       ma::steady_deadline_timer& the_stop_timer,
+      ma::steady_deadline_timer& the_stats_timer,
       ma::console_close_signal& the_close_signal)
     : exec_config(the_exec_config)
     , event_loop(the_event_loop)
     , stop_timer(the_stop_timer)
+    , stats_timer(the_stats_timer)
     , close_signal(the_close_signal)
     , state(starting)
     , user_initiated_stop(false)
+    , last_stats()
+    , last_stats_time()
   {
   }
 
   const echo_server::execution_config& exec_config;
   boost::asio::io_service&   event_loop;
   ma::steady_deadline_timer& stop_timer;
+  ma::steady_deadline_timer& stats_timer;
   ma::console_close_signal&  close_signal;
   state_t state;
   bool    user_initiated_stop;
+  ma::echo::server::session_manager_stats last_stats;
+  time_type last_stats_time;
 }; // struct execution_context
 
 void stop_event_loop(execution_context& context);
@@ -365,6 +432,23 @@ void handle_server_stop_timeout(execution_context& context,
 void handle_server_stop(execution_context& context,
     const boost::system::error_code& error);
 
+boost::posix_time::time_duration stats_timer_interval(
+    const execution_context& context);
+
+void start_stats_timer(execution_context& context, server& the_server);
+
+void handle_stats_timer(execution_context& context, server& the_server,
+    const boost::system::error_code& error);
+
+void print_stats_sample(std::ostream& stream,
+    echo_server::stats_format::value_t format,
+    const ma::echo::server::session_manager_stats& prev_stats,
+    const ma::echo::server::session_manager_stats& stats,
+    const boost::posix_time::time_duration& elapsed);
+
+void print_stop_progress(std::ostream& stream,
+    const ma::echo::server::session_manager_stats& stats);
+
 void stop_event_loop(execution_context& context)
 {
   context.event_loop.stop();
@@ -394,6 +478,12 @@ void start_server_stop(execution_context& context, server& the_server,
 
   std::cout << "Server is stopping." \
       " Press Ctrl+C to terminate server." << std::endl;
+
+  // Report stop progress if periodic statistics reporting isn't turned on
+  if (!context.exec_config.stats_interval)
+  {
+    start_stats_timer(context, the_server);
+  }
 }
 
 void handle_work_thread_exception(execution_context& context)
@@ -456,6 +546,12 @@ void handle_server_start(execution_context& context, server& the_server,
       the_server.async_wait(context.event_loop.wrap(detail::bind(
           handle_server_wait, detail::ref(context), detail::ref(the_server),
           detail::placeholders::_1)));
+      if (context.exec_config.stats_interval)
+      {
+        context.last_stats = the_server.stats();
+        context.last_stats_time = execution_context::time_traits_type::now();
+        start_stats_timer(context, the_server);
+      }
     }
     break;
 
@@ -519,6 +615,68 @@ void handle_server_stop(execution_context& context,
   stop_event_loop(context);
 }
 
+boost::posix_time::time_duration stats_timer_interval(
+    const execution_context& context)
+{
+  if (context.exec_config.stats_interval)
+  {
+    return *context.exec_config.stats_interval;
+  }
+  return boost::posix_time::seconds(1);
+}
+
+void start_stats_timer(execution_context& context, server& the_server)
+{
+  namespace detail = ma::detail;
+
+  context.stats_timer.expires_from_now(ma::to_steady_deadline_timer_duration(
+      stats_timer_interval(context)));
+  context.stats_timer.async_wait(context.event_loop.wrap(detail::bind(
+      handle_stats_timer, detail::ref(context), detail::ref(the_server),
+      detail::placeholders::_1)));
+}
+
+void handle_stats_timer(execution_context& context, server& the_server,
+    const boost::system::error_code& error)
+{
+  typedef execution_context::time_traits_type time_traits_type;
+
+  if (boost::asio::error::operation_aborted == error)
+  {
+    return;
+  }
+
+  switch (context.state)
+  {
+  case execution_context::working:
+  case execution_context::stopping:
+    {
+      // Snapshot is taken at the event loop so the server work threads
+      // are affected only by the short lock inside of session_manager::stats
+      const ma::echo::server::session_manager_stats stats = the_server.stats();
+      if (context.exec_config.stats_interval)
+      {
+        const execution_context::time_type now = time_traits_type::now();
+        print_stats_sample(std::cout, context.exec_config.stats_output_format,
+            context.last_stats, stats, time_traits_type::to_posix_duration(
+                time_traits_type::subtract(now, context.last_stats_time)));
+        context.last_stats = stats;
+        context.last_stats_time = now;
+      }
+      else
+      {
+        print_stop_progress(std::cout, stats);
+      }
+      start_stats_timer(context, the_server);
+    }
+    break;
+
+  default:
+    // Nothing to report
+    break;
+  }
+}
+
 template <typename Integer>
 std::string to_string(const ma::limited_int<Integer>& limited_value)
 {
@@ -543,6 +701,9 @@ void print_stats(const ma::echo::server::session_manager_stats& stats)
             << "Recycled sessions          : "
             << boost::lexical_cast<std::string>(stats.recycled)
             << std::endl
+            << "Stopping sessions          : "
+            << boost::lexical_cast<std::string>(stats.stopping)
+            << std::endl
             << "Total accepted sessions    : "
             << to_string(stats.total_accepted)
             << std::endl
@@ -560,6 +721,109 @@ void print_stats(const ma::echo::server::session_manager_stats& stats)
             << std::endl;
 }
 
+boost::uintmax_t counter_delta(
+    const ma::echo::server::session_manager_stats::limited_counter& prev,
+    const ma::echo::server::session_manager_stats::limited_counter& current)
+{
+  if (current.value() < prev.value())
+  {
+    // Statistics was reset
+    return current.value();
+  }
+  return current.value() - prev.value();
+}
+
+double counter_rate(boost::uintmax_t delta,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::int64_t elapsed_us = elapsed.total_microseconds();
+  if (elapsed_us <= 0)
+  {
+    return 0;
+  }
+  return static_cast<double>(delta) * 1000000 / elapsed_us;
+}
+
+void print_text_counter_sample(std::ostream& stream, const char* name,
+    const ma::echo::server::session_manager_stats::limited_counter& prev,
+    const ma::echo::server::session_manager_stats::limited_counter& current,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uintmax_t delta = counter_delta(prev, current);
+  stream << ", " << name << " +" << delta
+         << " (" << counter_rate(delta, elapsed) << "/s)";
+}
+
+void print_json_counter_sample(std::ostream& stream, const char* name,
+    const ma::echo::server::session_manager_stats::limited_counter& prev,
+    const ma::echo::server::session_manager_stats::limited_counter& current,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uintmax_t delta = counter_delta(prev, current);
+  stream << ",\"" << name << "\":" << current.value()
+         << ",\"" << name << "_delta\":" << delta
+         << ",\"" << name << "_rate\":" << counter_rate(delta, elapsed);
+}
+
+void print_stats_sample(std::ostream& stream,
+    echo_server::stats_format::value_t format,
+    const ma::echo::server::session_manager_stats& prev_stats,
+    const ma::echo::server::session_manager_stats& stats,
+    const boost::posix_time::time_duration& elapsed)
+{
+  // Build the whole line at once to not mix it with output of other handlers
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1);
+
+  if (echo_server::stats_format::json == format)
+  {
+    line << "{\"interval_ms\":" << elapsed.total_milliseconds()
+         << ",\"active\":" << stats.active
+         << ",\"max_active\":" << stats.max_active
+         << ",\"recycled\":" << stats.recycled
+         << ",\"stopping\":" << stats.stopping;
+    print_json_counter_sample(line, "total_accepted",
+        prev_stats.total_accepted, stats.total_accepted, elapsed);
+    print_json_counter_sample(line, "active_shutdowned",
+        prev_stats.active_shutdowned, stats.active_shutdowned, elapsed);
+    print_json_counter_sample(line, "out_of_work",
+        prev_stats.out_of_work, stats.out_of_work, elapsed);
+    print_json_counter_sample(line, "timed_out",
+        prev_stats.timed_out, stats.timed_out, elapsed);
+    print_json_counter_sample(line, "error_stopped",
+        prev_stats.error_stopped, stats.error_stopped, elapsed);
+    line << '}';
+  }
+  else
+  {
+    line << "Stats for last " << elapsed.total_milliseconds() << " ms"
+         << ": active " << stats.active
+         << ", max active " << stats.max_active
+         << ", recycled " << stats.recycled
+         << ", stopping " << stats.stopping;
+    print_text_counter_sample(line, "accepted",
+        prev_stats.total_accepted, stats.total_accepted, elapsed);
+    print_text_counter_sample(line, "active shutdowned",
+        prev_stats.active_shutdowned, stats.active_shutdowned, elapsed);
+    print_text_counter_sample(line, "passive shutdowned",
+        prev_stats.out_of_work, stats.out_of_work, elapsed);
+    print_text_counter_sample(line, "timed out",
+        prev_stats.timed_out, stats.timed_out, elapsed);
+    print_text_counter_sample(line, "error stopped",
+        prev_stats.error_stopped, stats.error_stopped, elapsed);
+  }
+
+  stream << line.str() << std::endl;
+}
+
+void print_stop_progress(std::ostream& stream,
+    const ma::echo::server::session_manager_stats& stats)
+{
+  stream << "Server is stopping: " << stats.active
+         << " active session(s) left, " << stats.stopping
+         << " of them are being stopped." << std::endl;
+}
+
 } // anonymous namespace
 
 int echo_server::run_server(const echo_server::execution_config& exec_config,
@@ -569,12 +833,32 @@ int echo_server::run_server(const echo_server::execution_config& exec_config,
 
   boost::asio::io_service   event_loop(ma::to_io_context_concurrency_hint(1));
   ma::steady_deadline_timer stop_timer(event_loop);
+  ma::steady_deadline_timer stats_timer(event_loop);
   ma::console_close_signal  close_signal(event_loop);
-  execution_context context(exec_config, event_loop, stop_timer, close_signal);
+  execution_context context(exec_config, event_loop, stop_timer, stats_timer,
+      close_signal);
 
   server the_server(exec_config, session_manager_config, event_loop.wrap(
       detail::bind(handle_work_thread_exception, detail::ref(context))));
 
+  // Metrics are served by the event loop thread and don't touch work threads
+  boost::optional<echo_server::metrics_server> metrics;
+  if (exec_config.metrics_endpoint)
+  {
+    metrics = boost::in_place(detail::ref(event_loop),
+        *exec_config.metrics_endpoint,
+        echo_server::metrics_server::stats_provider(detail::bind(
+            &server::stats, detail::ref(the_server))));
+    if (boost::system::error_code error = metrics->start())
+    {
+      std::cout << "Metrics endpoint can't start due to error: "
+                << error.message() << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Metrics endpoint is listening at "
+              << *exec_config.metrics_endpoint << std::endl;
+  }
+
   // Wait for console close
   std::cout << "Press Ctrl+C to exit." << std::endl;
   close_signal.async_wait(event_loop.wrap(detail::bind(handle_app_exit,
@@ -590,6 +874,15 @@ int echo_server::run_server(const echo_server::execution_config& exec_config,
   event_loop.run();
   (void) event_loop_stop_guard;
 
+  if (metrics)
+  {
+    // Pending accept uses memory owned by metrics server so let it complete
+    // before metrics server is destroyed
+    metrics->stop();
+    event_loop.reset();
+    event_loop.poll();
+  }
+
   std::cout << "Waiting until work threads stop." << std::endl;
   the_server.stop_threads();
   std::cout << "Work threads have stopped." << std::endl;
@@ -0,0 +1,369 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <string>
+#include <sstream>
+#include <istream>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <ma/config.hpp>
+#include <ma/limited_int.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include "metrics_server.hpp"
+
+namespace echo_server {
+
+namespace {
+
+const std::size_t max_request_size = 4096;
+// Time given to a client to send the whole request and to read the response
+const long connection_timeout_seconds = 5;
+// Metrics are scraped rarely, so a few simultaneous connections are enough.
+// The limit keeps descriptors for the sessions of echo server.
+const std::size_t max_connection_count = 8;
+// Delay of accept after failure (f.e. because of lack of descriptors)
+const long accept_delay_milliseconds = 500;
+const char* metrics_path = "/metrics";
+const char* metrics_content_type = "text/plain; version=0.0.4";
+const char* metric_name_prefix = "ma_echo_server_";
+
+typedef ma::echo::server::session_manager_stats::limited_counter
+    limited_counter;
+
+void write_metric_header(std::ostream& stream, const std::string& name,
+    const char* type, const char* help)
+{
+  stream << "# HELP " << metric_name_prefix << name << ' ' << help << '\n'
+         << "# TYPE " << metric_name_prefix << name << ' ' << type << '\n';
+}
+
+void write_gauge(std::ostream& stream, const std::string& name,
+    const char* help, std::size_t value)
+{
+  write_metric_header(stream, name, "gauge", help);
+  stream << metric_name_prefix << name << ' ' << value << '\n';
+}
+
+void write_counter(std::ostream& stream, const std::string& name,
+    const char* help, const limited_counter& value)
+{
+  write_metric_header(stream, name, "counter", help);
+  stream << metric_name_prefix << name << ' ' << value.value() << '\n';
+}
+
+void write_labeled_counter(std::ostream& stream, const std::string& name,
+    const char* label, const char* label_value, const limited_counter& value)
+{
+  stream << metric_name_prefix << name
+         << '{' << label << "=\"" << label_value << "\"} "
+         << value.value() << '\n';
+}
+
+std::string build_response(const std::string& status,
+    const std::string& content_type, const std::string& body)
+{
+  std::ostringstream response;
+  response << "HTTP/1.0 " << status << "\r\n"
+           << "Content-Type: " << content_type << "\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: close\r\n"
+           << "\r\n"
+           << body;
+  return response.str();
+}
+
+} // anonymous namespace
+
+class metrics_server::connection
+  : private boost::noncopyable
+  , public ma::detail::enable_shared_from_this<connection>
+{
+private:
+  typedef connection this_type;
+
+public:
+  connection(boost::asio::io_service& io_service, metrics_server& server,
+      const stats_provider& provider)
+    : server_(server)
+    , stats_provider_(provider)
+    , socket_(io_service)
+    , timer_(io_service)
+    , request_buffer_(max_request_size)
+  {
+  }
+
+  protocol_type::socket& socket()
+  {
+    return socket_;
+  }
+
+  void start()
+  {
+    // Limit the whole connection lifetime so that idle and slow clients
+    // can't hold it forever
+    boost::system::error_code error;
+    timer_.expires_from_now(ma::to_steady_deadline_timer_duration(
+        boost::posix_time::seconds(connection_timeout_seconds)), error);
+    if (error)
+    {
+      close();
+      return;
+    }
+    timer_.async_wait(ma::make_custom_alloc_handler(timer_allocator_,
+        ma::detail::bind(&this_type::handle_timeout, shared_from_this(),
+            ma::detail::placeholders::_1)));
+
+    boost::asio::async_read_until(socket_, request_buffer_, "\r\n\r\n",
+        ma::make_custom_alloc_handler(allocator_, ma::detail::bind(
+            &this_type::handle_read, shared_from_this(),
+            ma::detail::placeholders::_1)));
+  }
+
+private:
+  void handle_read(const boost::system::error_code& error)
+  {
+    if (error)
+    {
+      // Includes the case of too long request
+      close();
+      return;
+    }
+
+    std::istream request_stream(&request_buffer_);
+    std::string method;
+    std::string path;
+    request_stream >> method >> path;
+
+    const std::string::size_type query_pos = path.find('?');
+    if (std::string::npos != query_pos)
+    {
+      path.erase(query_pos);
+    }
+
+    if ("GET" != method)
+    {
+      response_ = build_response("405 Method Not Allowed", "text/plain",
+          "Method Not Allowed\n");
+    }
+    else if (metrics_path != path)
+    {
+      response_ = build_response("404 Not Found", "text/plain",
+          "Not Found\n");
+    }
+    else
+    {
+      response_ = build_response("200 OK", metrics_content_type,
+          format_prometheus_metrics(stats_provider_()));
+    }
+
+    boost::asio::async_write(socket_, boost::asio::buffer(response_),
+        ma::make_custom_alloc_handler(allocator_, ma::detail::bind(
+            &this_type::handle_write, shared_from_this(),
+            ma::detail::placeholders::_1)));
+  }
+
+  void handle_write(const boost::system::error_code& error)
+  {
+    if (!error)
+    {
+      boost::system::error_code ignored;
+      socket_.shutdown(protocol_type::socket::shutdown_both, ignored);
+    }
+    close();
+  }
+
+  void handle_timeout(const boost::system::error_code& error)
+  {
+    if (boost::asio::error::operation_aborted != error)
+    {
+      // Pending read or write completes with error and finishes connection
+      boost::system::error_code ignored;
+      socket_.close(ignored);
+    }
+  }
+
+  // Called exactly once per started connection
+  void close()
+  {
+    boost::system::error_code ignored;
+    timer_.cancel(ignored);
+    socket_.close(ignored);
+    server_.handle_connection_close();
+  }
+
+  metrics_server&            server_;
+  const stats_provider       stats_provider_;
+  protocol_type::socket      socket_;
+  ma::steady_deadline_timer  timer_;
+  boost::asio::streambuf     request_buffer_;
+  std::string                response_;
+  ma::in_place_handler_allocator<256> allocator_;
+  ma::in_place_handler_allocator<256> timer_allocator_;
+}; // class metrics_server::connection
+
+metrics_server::metrics_server(boost::asio::io_service& io_service,
+    const protocol_type::endpoint& endpoint, const stats_provider& provider)
+  : endpoint_(endpoint)
+  , stats_provider_(provider)
+  , io_service_(io_service)
+  , acceptor_(io_service)
+  , accept_delay_timer_(io_service)
+  , stopped_(false)
+  , accept_in_progress_(false)
+  , connection_count_(0)
+{
+}
+
+boost::system::error_code metrics_server::start()
+{
+  boost::system::error_code error;
+  acceptor_.open(endpoint_.protocol(), error);
+  if (error)
+  {
+    return error;
+  }
+
+  acceptor_.set_option(protocol_type::acceptor::reuse_address(true), error);
+  if (!error)
+  {
+    acceptor_.bind(endpoint_, error);
+  }
+  if (!error)
+  {
+    acceptor_.listen(boost::asio::socket_base::max_connections, error);
+  }
+  if (error)
+  {
+    boost::system::error_code ignored;
+    acceptor_.close(ignored);
+    return error;
+  }
+
+  start_accept();
+  return boost::system::error_code();
+}
+
+void metrics_server::stop()
+{
+  stopped_ = true;
+  boost::system::error_code ignored;
+  acceptor_.close(ignored);
+  accept_delay_timer_.cancel(ignored);
+}
+
+void metrics_server::continue_accept()
+{
+  // New connections wait in the listen backlog while there are too many
+  // active ones
+  if (stopped_ || accept_in_progress_
+      || (connection_count_ >= max_connection_count))
+  {
+    return;
+  }
+  start_accept();
+}
+
+void metrics_server::start_accept()
+{
+  const connection_ptr new_connection =
+      ma::detail::make_shared<connection>(ma::detail::ref(io_service_),
+          ma::detail::ref(*this), stats_provider_);
+  acceptor_.async_accept(new_connection->socket(),
+      ma::make_custom_alloc_handler(accept_allocator_, ma::detail::bind(
+          &this_type::handle_accept, this, new_connection,
+          ma::detail::placeholders::_1)));
+  accept_in_progress_ = true;
+}
+
+void metrics_server::handle_accept(const connection_ptr& accepted_connection,
+    const boost::system::error_code& error)
+{
+  accept_in_progress_ = false;
+
+  if (stopped_ || (boost::asio::error::operation_aborted == error))
+  {
+    return;
+  }
+
+  if (error)
+  {
+    // Don't let the event loop spin on persistent errors
+    start_accept_delay();
+    return;
+  }
+
+  ++connection_count_;
+  accepted_connection->start();
+  continue_accept();
+}
+
+void metrics_server::start_accept_delay()
+{
+  boost::system::error_code error;
+  accept_delay_timer_.expires_from_now(ma::to_steady_deadline_timer_duration(
+      boost::posix_time::milliseconds(accept_delay_milliseconds)), error);
+  if (error)
+  {
+    return;
+  }
+  accept_delay_timer_.async_wait(ma::make_custom_alloc_handler(
+      accept_allocator_, ma::detail::bind(&this_type::handle_accept_delay,
+          this, ma::detail::placeholders::_1)));
+  accept_in_progress_ = true;
+}
+
+void metrics_server::handle_accept_delay(
+    const boost::system::error_code& error)
+{
+  accept_in_progress_ = false;
+
+  if (stopped_ || (boost::asio::error::operation_aborted == error))
+  {
+    return;
+  }
+  continue_accept();
+}
+
+void metrics_server::handle_connection_close()
+{
+  --connection_count_;
+  continue_accept();
+}
+
+std::string format_prometheus_metrics(
+    const ma::echo::server::session_manager_stats& stats)
+{
+  std::ostringstream body;
+
+  write_gauge(body, "active_sessions",
+      "Number of active sessions.", stats.active);
+  write_gauge(body, "max_active_sessions",
+      "Maximum number of simultaneously active sessions.", stats.max_active);
+  write_gauge(body, "recycled_sessions",
+      "Number of pooled inactive sessions.", stats.recycled);
+  write_gauge(body, "stopping_sessions",
+      "Number of sessions being stopped.", stats.stopping);
+  write_counter(body, "accepted_sessions_total",
+      "Total number of accepted sessions.", stats.total_accepted);
+
+  write_metric_header(body, "stopped_sessions_total", "counter",
+      "Total number of stopped sessions by reason.");
+  write_labeled_counter(body, "stopped_sessions_total", "reason",
+      "active_shutdown", stats.active_shutdowned);
+  write_labeled_counter(body, "stopped_sessions_total", "reason",
+      "out_of_work", stats.out_of_work);
+  write_labeled_counter(body, "stopped_sessions_total", "reason",
+      "inactivity_timeout", stats.timed_out);
+  write_labeled_counter(body, "stopped_sessions_total", "reason",
+      "error", stats.error_stopped);
+
+  return body.str();
+}
+
+} // namespace echo_server
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <ma/config.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/echo/server/session_manager_stats.hpp>
+#include <ma/detail/memory.hpp>
+#include <ma/detail/functional.hpp>
+
+namespace echo_server {
+
+/// Minimal HTTP listener exposing server statistics in Prometheus text
+/// exposition format (GET /metrics).
+/**
+ * All the work is done by the thread(s) running the given io_service,
+ * statistics is read by means of the given provider only when the metrics
+ * are requested, so the session hot path is not affected at all.
+ */
+class metrics_server : private boost::noncopyable
+{
+private:
+  typedef metrics_server this_type;
+
+public:
+  typedef boost::asio::ip::tcp protocol_type;
+  typedef ma::detail::function<ma::echo::server::session_manager_stats ()>
+      stats_provider;
+
+  metrics_server(boost::asio::io_service& io_service,
+      const protocol_type::endpoint& endpoint,
+      const stats_provider& provider);
+
+  boost::system::error_code start();
+  void stop();
+
+private:
+  class connection;
+  typedef ma::detail::shared_ptr<connection> connection_ptr;
+
+  void continue_accept();
+  void start_accept();
+  void handle_accept(const connection_ptr&, const boost::system::error_code&);
+  void start_accept_delay();
+  void handle_accept_delay(const boost::system::error_code&);
+  void handle_connection_close();
+
+  const protocol_type::endpoint endpoint_;
+  const stats_provider          stats_provider_;
+  boost::asio::io_service&      io_service_;
+  protocol_type::acceptor       acceptor_;
+  ma::steady_deadline_timer     accept_delay_timer_;
+  bool                          stopped_;
+  bool                          accept_in_progress_;
+  std::size_t                   connection_count_;
+  // Accept and delay of accept never run at the same time
+  ma::in_place_handler_allocator<256> accept_allocator_;
+}; // class metrics_server
+
+std::string format_prometheus_metrics(
+    const ma::echo::server::session_manager_stats& stats);
+
+} // namespace echo_server
+
+#endif // METRICS_SERVER_HPP
@@ -46,6 +46,8 @@ public:
   session_ptr create(const session_config& config,
       boost::system::error_code& error);
   void release(const session_ptr& session);
+  void warm_up(const session_config& config, std::size_t count,
+      boost::system::error_code& error);
 
 private:
   class session_wrapper_base
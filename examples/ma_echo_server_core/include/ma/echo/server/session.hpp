@@ -13,6 +13,8 @@
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
 #include <cstddef>
+#include <deque>
+#include <boost/cstdint.hpp>
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
 #include <boost/noncopyable.hpp>
@@ -26,6 +28,7 @@
 #include <ma/context_alloc_handler.hpp>
 #include <ma/echo/server/session_config.hpp>
 #include <ma/echo/server/session_fwd.hpp>
+#include <ma/echo/server/splice_pipe.hpp>
 #include <ma/strand.hpp>
 #include <ma/steady_deadline_timer.hpp>
 #include <ma/detail/memory.hpp>
@@ -53,6 +56,10 @@ public:
 
   void reset();
 
+  // Touches memory of internal buffer so it becomes resident before
+  // the first read. Must not be called while session is working.
+  void warm_up();
+
   template <typename Handler>
   void async_start(MA_FWD_REF(Handler) handler);
 
@@ -101,6 +108,15 @@ private:
     enum value_t {ready, in_progress, stopped};
   };
 
+  // Data sent with MSG_ZEROCOPY and not released by kernel yet
+  struct zerocopy_send
+  {
+    std::size_t size;
+    bool        done;
+  }; // struct zerocopy_send
+
+  typedef std::deque<zerocopy_send> zerocopy_send_queue;
+
   typedef boost::optional<boost::system::error_code> optional_error_code;
   typedef steady_deadline_timer          deadline_timer;
   typedef deadline_timer::duration_type  duration_type;
@@ -118,6 +134,9 @@ private:
   void handle_read(const boost::system::error_code&, std::size_t);
   void handle_write(const boost::system::error_code&, std::size_t);
   void handle_timer(const boost::system::error_code&);
+  void handle_splice_read(const boost::system::error_code&, std::size_t);
+  void handle_splice_write(const boost::system::error_code&, std::size_t);
+  void handle_zerocopy_wait(const boost::system::error_code&);
 
   boost::system::error_code do_start_extern_start();
   optional_error_code do_start_extern_stop();
@@ -136,6 +155,16 @@ private:
   void handle_timer_at_work(const boost::system::error_code&);
   void handle_timer_at_stop(const boost::system::error_code&);
 
+  void handle_written_data(std::size_t);
+  bool continue_speculative_read();
+  void adapt_read_size(std::size_t read_size, std::size_t requested_size);
+  boost::system::error_code continue_zerocopy_wait();
+  boost::system::error_code read_zerocopy_notifications();
+  void release_zerocopy_sends(boost::uint32_t first, boost::uint32_t last);
+  void continue_zerocopy_linger();
+  void continue_write_burst(bool has_data);
+  void rearm_quick_ack();
+
   void continue_work();
   void continue_timer_wait();
   void continue_shutdown(bool need_timer_restart);
@@ -150,10 +179,17 @@ private:
 
   void start_socket_read(const cyclic_buffer::mutable_buffers_type&);
   void start_socket_write(const cyclic_buffer::const_buffers_type&);
+  void start_socket_splice_read();
+  void start_socket_splice_write();
+  void start_socket_read_wait();
+  void start_socket_write_wait();
+  void start_socket_zerocopy_write(const cyclic_buffer::const_buffers_type&);
+  void start_zerocopy_wait();
   void start_timer_wait();
   boost::system::error_code cancel_timer_wait();
   boost::system::error_code shutdown_socket();
   boost::system::error_code close_socket();
+  boost::system::error_code cancel_socket();
   boost::system::error_code apply_socket_options();
 
   static optional_duration to_optional_duration(
@@ -163,6 +199,13 @@ private:
   const session_config::optional_int  socket_recv_buffer_size_;
   const session_config::optional_int  socket_send_buffer_size_;
   const session_config::tribool       no_delay_;
+  const session_config::optional_int  socket_busy_poll_;
+  const bool                          splice_;
+  const session_config::optional_size zerocopy_threshold_;
+  const bool                          speculative_read_;
+  const socket_profile::value_t       profile_;
+  const session_config::optional_int  socket_notsent_lowat_;
+  const bool                          read_at_start_;
   const optional_duration             inactivity_timeout_;
 
   extern_state::value_t extern_state_;
@@ -173,12 +216,29 @@ private:
   bool                  timer_wait_cancelled_;
   bool                  timer_turned_;
   std::size_t           pending_operations_;
+  std::size_t           read_size_;
+  std::size_t           requested_read_size_;
+  // SO_ZEROCOPY is turned on for the socket
+  bool                  zerocopy_;
+  bool                  zerocopy_write_;
+  bool                  zerocopy_wait_;
+  std::size_t           zerocopy_pinned_size_;
+  boost::uint32_t       zerocopy_first_id_;
+  zerocopy_send_queue   zerocopy_sends_;
+  // Stopped session waits (limited time) for release of data sent with
+  // MSG_ZEROCOPY
+  bool                  zerocopy_linger_;
+  // TCP_CORK is turned on for the socket
+  bool                  corked_;
+  // Write has completed and next write wasn't considered yet
+  bool                  write_completed_;
 
   boost::asio::io_service&  io_service_;
   ma::strand                strand_;
   protocol_type::socket     socket_;
   deadline_timer            timer_;
   cyclic_buffer             buffer_;
+  splice_pipe               pipe_;
   boost::system::error_code extern_wait_error_;
 
   handler_storage<boost::system::error_code> extern_wait_handler_;
@@ -187,6 +247,7 @@ private:
   in_place_handler_allocator<640> write_allocator_;
   in_place_handler_allocator<256> read_allocator_;
   in_place_handler_allocator<256> timer_allocator_;
+  in_place_handler_allocator<256> zerocopy_allocator_;
 }; // class session
 
 inline session::protocol_type::socket& session::socket()
@@ -23,10 +23,27 @@ namespace ma {
 namespace echo {
 namespace server {
 
+/// Set of socket options and write batching tuned for the given goal.
+struct socket_profile
+{
+  enum value_t
+  {
+    /// Only explicitly configured socket options are applied.
+    none,
+    /// TCP_NODELAY and TCP_QUICKACK: segments are sent and acknowledged
+    /// without delay.
+    latency,
+    /// TCP_NOTSENT_LOWAT and TCP_CORK around bursts of writes: fewer but
+    /// full segments, less unsent data queued in the kernel.
+    throughput
+  };
+}; // struct socket_profile
+
 struct session_config
 {
 public:
   typedef boost::optional<int>             optional_int;
+  typedef boost::optional<std::size_t>     optional_size;
   typedef boost::logic::tribool            tribool;
   typedef boost::posix_time::time_duration time_duration;
   typedef boost::optional<time_duration>   optional_time_duration;
@@ -37,7 +54,14 @@ public:
       const optional_int& socket_recv_buffer_size = boost::none,
       const optional_int& socket_send_buffer_size = boost::none,
       const tribool& no_delay = boost::logic::indeterminate,
-      const optional_time_duration& inactivity_timeout = boost::none);
+      const optional_time_duration& inactivity_timeout = boost::none,
+      const optional_int& socket_busy_poll = boost::none,
+      bool splice = false,
+      const optional_size& zerocopy_threshold = boost::none,
+      bool speculative_read = false,
+      socket_profile::value_t profile = socket_profile::none,
+      const optional_int& socket_notsent_lowat = boost::none,
+      bool read_at_start = false);
 
   tribool       no_delay;
   optional_int  socket_recv_buffer_size;
@@ -45,6 +69,32 @@ public:
   std::size_t   buffer_size;
   std::size_t   max_transfer_size;
   optional_time_duration inactivity_timeout;
+  /// SO_BUSY_POLL (microseconds), is supported only on Linux.
+  optional_int  socket_busy_poll;
+  /// Echo data with splice() through per-session pipe so it never gets
+  /// copied into user space. Is supported only on Linux, session falls back
+  /// to the buffered echo if pipe can't be created.
+  bool          splice;
+  /// Writes of at least this size are sent with MSG_ZEROCOPY. Is supported
+  /// only on Linux, session falls back to the copying send if socket doesn't
+  /// support it.
+  optional_size zerocopy_threshold;
+  /// Try to read synchronously (without demultiplexer) right after write
+  /// completion or read which filled the requested buffer. Size of reads
+  /// adapts to the size of recently read data.
+  bool          speculative_read;
+  /// Socket options and write batching applied at start of session.
+  /// TCP_QUICKACK and TCP_CORK are supported only on Linux and are not
+  /// used on other platforms.
+  socket_profile::value_t profile;
+  /// TCP_NOTSENT_LOWAT (bytes). Throughput profile uses default value if
+  /// not specified.
+  optional_int  socket_notsent_lowat;
+  /// Try to read synchronously (without demultiplexer) right at start of
+  /// session. Makes sense with deferred accept
+  /// (session_manager_config::defer_accept) because accepted connection has
+  /// the first data already.
+  bool          read_at_start;
 }; // struct session_config
 
 inline session_config::session_config(
@@ -53,13 +103,27 @@ inline session_config::session_config(
     const optional_int& the_socket_recv_buffer_size,
     const optional_int& the_socket_send_buffer_size,
     const tribool& the_no_delay,
-    const optional_time_duration& the_inactivity_timeout)
+    const optional_time_duration& the_inactivity_timeout,
+    const optional_int& the_socket_busy_poll,
+    bool the_splice,
+    const optional_size& the_zerocopy_threshold,
+    bool the_speculative_read,
+    socket_profile::value_t the_profile,
+    const optional_int& the_socket_notsent_lowat,
+    bool the_read_at_start)
   : no_delay(the_no_delay)
   , socket_recv_buffer_size(the_socket_recv_buffer_size)
   , socket_send_buffer_size(the_socket_send_buffer_size)
   , buffer_size(the_buffer_size)
   , max_transfer_size(the_max_transfer_size)
   , inactivity_timeout(the_inactivity_timeout)
+  , socket_busy_poll(the_socket_busy_poll)
+  , splice(the_splice)
+  , zerocopy_threshold(the_zerocopy_threshold)
+  , speculative_read(the_speculative_read)
+  , profile(the_profile)
+  , socket_notsent_lowat(the_socket_notsent_lowat)
+  , read_at_start(the_read_at_start)
 {
   BOOST_ASSERT_MSG(the_buffer_size > 0, "buffer_size must be > 0");
 
@@ -70,6 +134,14 @@ inline session_config::session_config(
   BOOST_ASSERT_MSG(
       !the_socket_send_buffer_size || (*the_socket_send_buffer_size) >= 0,
       "Defined socket_send_buffer_size must be >= 0");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_busy_poll || (*the_socket_busy_poll) >= 0,
+      "Defined socket_busy_poll must be >= 0");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_notsent_lowat || (*the_socket_notsent_lowat) > 0,
+      "Defined socket_notsent_lowat must be > 0");
 }
 
 } // namespace server
@@ -12,6 +12,7 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstddef>
 #include <boost/system/error_code.hpp>
 #include <ma/echo/server/session_fwd.hpp>
 #include <ma/echo/server/session_config_fwd.hpp>
@@ -30,6 +31,9 @@ public:
   virtual session_ptr create(const session_config& config,
       boost::system::error_code& error) = 0;
   virtual void release(const session_ptr& session) = 0;
+  // Pre-creates (up to count) recycled sessions to be used by create
+  virtual void warm_up(const session_config& config, std::size_t count,
+      boost::system::error_code& error) = 0;
 
 protected:
   session_factory()
@@ -87,6 +87,7 @@ private:
     session_manager_stats stats();
     void set_active_session_count(std::size_t);
     void set_recycled_session_count(std::size_t);
+    void set_stopping_session_count(std::size_t);
     void session_accepted(const boost::system::error_code&);
     void session_stopped(const boost::system::error_code&);
     void reset();
@@ -129,7 +130,7 @@ private:
 
   struct accept_state
   {
-    enum value_t {ready, in_progress, stopped};
+    enum value_t {ready, in_progress, paused, stopped};
   };
 
   typedef boost::optional<boost::system::error_code> optional_error_code;
@@ -213,8 +214,12 @@ private:
 
   const protocol_type::endpoint accepting_endpoint_;
   const int                     listen_backlog_;
+  const session_manager_config::optional_int defer_accept_;
+  const session_manager_config::optional_int fast_open_queue_size_;
   const std::size_t             max_session_count_;
+  const std::size_t             accept_resume_session_count_;
   const std::size_t             recycled_session_count_;
+  const std::size_t             warm_session_count_;
   const std::size_t             max_stopping_sessions_;
   const session_config          managed_session_config_;
 
@@ -222,6 +227,7 @@ private:
   intern_state::value_t intern_state_;
   accept_state::value_t accept_state_;
   std::size_t           pending_operations_;
+  std::size_t           stopping_session_count_;
 
   boost::asio::io_service&  io_service_;
   session_factory&          session_factory_;
@@ -15,6 +15,7 @@
 #include <cstddef>
 #include <boost/asio.hpp>
 #include <boost/assert.hpp>
+#include <boost/optional.hpp>
 #include <ma/echo/server/session_config.hpp>
 #include <ma/echo/server/session_manager_config_fwd.hpp>
 
@@ -26,18 +27,38 @@ struct session_manager_config
 {
 public:
   typedef boost::asio::ip::tcp::endpoint endpoint_type;
+  typedef boost::optional<int>           optional_int;
 
   session_manager_config(
       const endpoint_type& accepting_endpoint,
       std::size_t max_session_count,
+      std::size_t accept_resume_session_count,
       std::size_t recycled_session_count,
+      std::size_t warm_session_count,
       std::size_t max_stopping_sessions,
       int listen_backlog,
-      const session_config& managed_session_config);
+      const session_config& managed_session_config,
+      const optional_int& defer_accept = boost::none,
+      const optional_int& fast_open_queue_size = boost::none);
 
   int            listen_backlog;
+  // TCP_DEFER_ACCEPT (seconds): connection is accepted only when its first
+  // data arrives, so sessions aren't created for connections which send
+  // nothing. Is supported only on Linux.
+  optional_int   defer_accept;
+  // TCP_FASTOPEN: max number of pending Fast Open requests, so client's data
+  // can be delivered with SYN. Requires server side Fast Open be enabled in
+  // system (net.ipv4.tcp_fastopen on Linux).
+  optional_int   fast_open_queue_size;
   std::size_t    max_session_count;
+  // Accept of new sessions is paused (listening socket stays open) when
+  // max_session_count is reached and is resumed only when number of active
+  // sessions falls down to accept_resume_session_count
+  std::size_t    accept_resume_session_count;
   std::size_t    recycled_session_count;
+  // Number of sessions pre-created by session factory at start
+  // (per io_service if session factory uses multiple io_services)
+  std::size_t    warm_session_count;
   std::size_t    max_stopping_sessions;
   endpoint_type  accepting_endpoint;
   session_config managed_session_config;
@@ -46,19 +67,38 @@ public:
 inline session_manager_config::session_manager_config(
     const endpoint_type& the_accepting_endpoint,
     std::size_t the_max_session_count,
+    std::size_t the_accept_resume_session_count,
     std::size_t the_recycled_session_count,
+    std::size_t the_warm_session_count,
     std::size_t the_max_stopping_sessions,
     int the_listen_backlog,
-    const session_config& the_managed_session_config)
+    const session_config& the_managed_session_config,
+    const optional_int& the_defer_accept,
+    const optional_int& the_fast_open_queue_size)
   : listen_backlog(the_listen_backlog)
+  , defer_accept(the_defer_accept)
+  , fast_open_queue_size(the_fast_open_queue_size)
   , max_session_count(the_max_session_count)
+  , accept_resume_session_count(the_accept_resume_session_count)
   , recycled_session_count(the_recycled_session_count)
+  , warm_session_count(the_warm_session_count)
   , max_stopping_sessions(the_max_stopping_sessions)
   , accepting_endpoint(the_accepting_endpoint)
   , managed_session_config(the_managed_session_config)
 {
   BOOST_ASSERT_MSG(the_max_session_count > 0,
       "max_session_count must be > 0");
+  BOOST_ASSERT_MSG(the_accept_resume_session_count < the_max_session_count,
+      "accept_resume_session_count must be < max_session_count");
+  BOOST_ASSERT_MSG(the_warm_session_count <= the_recycled_session_count,
+      "warm_session_count must be <= recycled_session_count");
+  BOOST_ASSERT_MSG(the_max_stopping_sessions > 0,
+      "max_stopping_sessions must be > 0");
+  BOOST_ASSERT_MSG(!the_defer_accept || (*the_defer_accept) >= 0,
+      "Defined defer_accept must be >= 0");
+  BOOST_ASSERT_MSG(
+      !the_fast_open_queue_size || (*the_fast_open_queue_size) > 0,
+      "Defined fast_open_queue_size must be > 0");
 }
 
 } // namespace server
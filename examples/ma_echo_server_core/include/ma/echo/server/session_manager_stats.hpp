@@ -32,6 +32,7 @@ public:
       std::size_t active,
       std::size_t max_active,
       std::size_t recycled,
+      std::size_t stopping,
       const limited_counter& total_accepted,
       const limited_counter& active_shutdowned,
       const limited_counter& out_of_work,
@@ -41,6 +42,7 @@ public:
   std::size_t     active;
   std::size_t     max_active;
   std::size_t     recycled;
+  std::size_t     stopping;
   limited_counter total_accepted;
   limited_counter active_shutdowned;
   limited_counter out_of_work;
@@ -52,6 +54,7 @@ inline session_manager_stats::session_manager_stats()
   : active(0)
   , max_active(0)
   , recycled(0)
+  , stopping(0)
   , total_accepted()
   , active_shutdowned()
   , out_of_work()
@@ -64,6 +67,7 @@ inline session_manager_stats::session_manager_stats(
     std::size_t the_active,
     std::size_t the_max_active,
     std::size_t the_recycled,
+    std::size_t the_stopping,
     const limited_counter& the_total_accepted,
     const limited_counter& the_active_shutdowned,
     const limited_counter& the_out_of_work,
@@ -72,6 +76,7 @@ inline session_manager_stats::session_manager_stats(
   : active(the_active)
   , max_active(the_max_active)
   , recycled(the_recycled)
+  , stopping(the_stopping)
   , total_accepted(the_total_accepted)
   , active_shutdowned(the_active_shutdowned)
   , out_of_work(the_out_of_work)
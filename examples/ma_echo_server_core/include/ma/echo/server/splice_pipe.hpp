@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_ECHO_SERVER_SPLICE_PIPE_HPP
+#define MA_ECHO_SERVER_SPLICE_PIPE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace ma {
+namespace echo {
+namespace server {
+
+/// Pipe used to move data from one socket to another one inside the kernel.
+/**
+ * Data is moved with splice() so it never gets copied into user space.
+ * Keeps track of the amount of data held by the pipe, so it can be used
+ * like cyclic_buffer. Is supported only on Linux - on other platforms
+ * open() fails with operation_not_supported error.
+ *
+ * Non-blocking: read_some and write_some return would_block error instead
+ * of waiting.
+ */
+class splice_pipe : private boost::noncopyable
+{
+public:
+  typedef boost::asio::ip::tcp::socket::native_handle_type
+      native_handle_type;
+
+  splice_pipe();
+  ~splice_pipe();
+
+  /// Opens pipe trying to make its capacity equal to the given one.
+  boost::system::error_code open(std::size_t capacity);
+  void close();
+  bool is_open() const;
+
+  /// Drops held data. Pipe is closed if it holds any data.
+  void reset();
+
+  /// Size of data held by the pipe.
+  std::size_t size() const;
+
+  /// Size of free space of the pipe.
+  std::size_t free_size() const;
+
+  /// Moves data from the given descriptor into the pipe.
+  /**
+   * Returns 0 and eof error if the peer closed the connection.
+   */
+  std::size_t read_some(native_handle_type source, std::size_t max_size,
+      boost::system::error_code& error);
+
+  /// Moves data from the pipe into the given descriptor.
+  std::size_t write_some(native_handle_type target, std::size_t max_size,
+      boost::system::error_code& error);
+
+private:
+  int         read_end_;
+  int         write_end_;
+  std::size_t capacity_;
+  std::size_t size_;
+  // Pipe capacity is accounted in pages, so the pipe can be full before
+  // capacity_ bytes are written into it.
+  bool        full_;
+}; // class splice_pipe
+
+inline splice_pipe::splice_pipe()
+  : read_end_(-1)
+  , write_end_(-1)
+  , capacity_(0)
+  , size_(0)
+  , full_(false)
+{
+}
+
+inline splice_pipe::~splice_pipe()
+{
+  close();
+}
+
+inline bool splice_pipe::is_open() const
+{
+  return -1 != read_end_;
+}
+
+inline std::size_t splice_pipe::size() const
+{
+  return size_;
+}
+
+inline std::size_t splice_pipe::free_size() const
+{
+  return full_ ? 0 : capacity_ - size_;
+}
+
+} // namespace server
+} // namespace echo
+} // namespace ma
+
+#endif // MA_ECHO_SERVER_SPLICE_PIPE_HPP
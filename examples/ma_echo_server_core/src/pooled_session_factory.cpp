@@ -93,6 +93,28 @@ public:
     }
   }
 
+  void warm_up(const pool_link& back_link, const session_config& config,
+      std::size_t count, boost::system::error_code& error)
+  {
+    const std::size_t max_count = (std::min)(count, max_recycled_);
+    try
+    {
+      while (recycled_.size() < max_count)
+      {
+        session_wrapper_ptr session = session_wrapper::create(
+            io_service_, config, back_link);
+        session->warm_up();
+        recycled_.push_front(session);
+      }
+      error = boost::system::error_code();
+    }
+    catch (const std::bad_alloc&)
+    {
+      error = boost::system::errc::make_error_code(
+          boost::system::errc::not_enough_memory);
+    }
+  }
+
   void release(const session_wrapper_ptr& session)
   {
     --size_;
@@ -142,6 +164,20 @@ void pooled_session_factory::release(const session_ptr& session)
   session_pool_item.release(wrapped_session);
 }
 
+void pooled_session_factory::warm_up(const session_config& config,
+    std::size_t count, boost::system::error_code& error)
+{
+  // Pre-create sessions for each io_service
+  for (pool::const_iterator i = pool_.begin(), end = pool_.end(); i != end; ++i)
+  {
+    (*i)->warm_up(i, config, count, error);
+    if (error)
+    {
+      return;
+    }
+  }
+}
+
 pooled_session_factory::pool pooled_session_factory::create_pool(
     const io_service_vector& io_services, std::size_t max_recycled)
 {
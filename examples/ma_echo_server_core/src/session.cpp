@@ -5,16 +5,37 @@
 // file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
+#include <cstring>
+#include <algorithm>
 #include <boost/assert.hpp>
+#include <boost/version.hpp>
 #include <boost/logic/tribool.hpp>
 #include <ma/config.hpp>
 #include <ma/shared_ptr_factory.hpp>
 #include <ma/custom_alloc_handler.hpp>
+#include <ma/bind_handler.hpp>
 #include <ma/echo/server/error.hpp>
 #include <ma/echo/server/session.hpp>
 #include <ma/detail/memory.hpp>
 #include <ma/detail/functional.hpp>
 
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#endif
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) \
+    && (BOOST_VERSION >= 106600)
+#define MA_ECHO_SERVER_HAS_ZEROCOPY
+#endif
+
+#if defined(__linux__) && defined(TCP_CORK) && defined(TCP_QUICKACK)
+#define MA_ECHO_SERVER_HAS_TCP_CORK
+#endif
+
 namespace ma {
 namespace echo {
 namespace server {
@@ -115,6 +136,22 @@ private:
 #endif // defined(MA_HAS_RVALUE_REFS)
        //     && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
 
+#if defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+const int zerocopy_message_flags = MSG_ZEROCOPY;
+#else
+const int zerocopy_message_flags = 0;
+#endif
+
+// Adaptive size of read doesn't go below this one
+const std::size_t min_adaptive_read_size = 4096;
+
+// Max time stopped session waits for kernel to release data sent with
+// MSG_ZEROCOPY before the socket is closed
+const long zerocopy_linger_timeout_ms = 1000;
+
+// TCP_NOTSENT_LOWAT of throughput profile if it isn't configured explicitly
+const int default_notsent_lowat = 131072;
+
 } // anonymous namespace
 
 session_ptr session::create(boost::asio::io_service& io_service,
@@ -130,6 +167,13 @@ session::session(boost::asio::io_service& io_service,
   , socket_recv_buffer_size_(config.socket_recv_buffer_size)
   , socket_send_buffer_size_(config.socket_send_buffer_size)
   , no_delay_(config.no_delay)
+  , socket_busy_poll_(config.socket_busy_poll)
+  , splice_(config.splice)
+  , zerocopy_threshold_(config.zerocopy_threshold)
+  , speculative_read_(config.speculative_read)
+  , profile_(config.profile)
+  , socket_notsent_lowat_(config.socket_notsent_lowat)
+  , read_at_start_(config.read_at_start)
   , inactivity_timeout_(to_optional_duration(config.inactivity_timeout))
   , extern_state_(extern_state::ready)
   , intern_state_(intern_state::work)
@@ -139,6 +183,16 @@ session::session(boost::asio::io_service& io_service,
   , timer_wait_cancelled_(false)
   , timer_turned_(false)
   , pending_operations_(0)
+  , read_size_(config.max_transfer_size)
+  , requested_read_size_(0)
+  , zerocopy_(false)
+  , zerocopy_write_(false)
+  , zerocopy_wait_(false)
+  , zerocopy_pinned_size_(0)
+  , zerocopy_first_id_(0)
+  , zerocopy_linger_(false)
+  , corked_(false)
+  , write_completed_(false)
   , io_service_(io_service)
   , strand_(io_service)
   , socket_(io_service)
@@ -161,16 +215,53 @@ void session::reset()
   timer_wait_cancelled_ = false;
   timer_turned_         = false;
   pending_operations_   = 0;
+  read_size_            = max_transfer_size_;
+  requested_read_size_  = 0;
+
+  zerocopy_             = false;
+  zerocopy_write_       = false;
+  zerocopy_wait_        = false;
+  zerocopy_pinned_size_ = 0;
+  zerocopy_first_id_    = 0;
+  zerocopy_linger_      = false;
+  corked_               = false;
+  write_completed_      = false;
 
   // reset() might be called right after connection was established
   // so we need to be sure that the socket will be closed.
   close_socket();
 
-  // Post condition: filled sequence is empty, unfilled sequence is empty.
-  buffer_.reset();
+  if (zerocopy_sends_.empty())
+  {
+    // Post condition: filled sequence is empty, unfilled sequence is empty.
+    buffer_.reset();
+  }
+  else
+  {
+    // Socket was closed before kernel released data sent with MSG_ZEROCOPY,
+    // so memory of buffer_ can still be in use by kernel and must not be
+    // filled with data of the next connection
+    cyclic_buffer(buffer_.size()).swap(buffer_);
+    zerocopy_sends_.clear();
+  }
+  pipe_.reset();
   extern_wait_error_.clear();
 }
 
+void session::warm_up()
+{
+  BOOST_ASSERT_MSG(extern_state::ready == extern_state_,
+      "Invalid external state");
+
+  const cyclic_buffer::mutable_buffers_type buffers = buffer_.prepared();
+  for (cyclic_buffer::mutable_buffers_type::const_iterator
+      i = buffers.begin(), end = buffers.end(); i != end; ++i)
+  {
+    std::memset(boost::asio::buffer_cast<void*>(*i), 0,
+        boost::asio::buffer_size(*i));
+  }
+}
+
 boost::system::error_code session::do_start_extern_start()
 {
   // Check external state consistency
@@ -179,6 +270,13 @@ boost::system::error_code session::do_start_extern_start()
     return server::error::invalid_state;
   }
 
+  // Open pipe if splice mode is configured. Session falls back to buffered
+  // echo (cyclic_buffer) if the pipe can't be opened.
+  if (splice_ && !pipe_.is_open())
+  {
+    pipe_.open(buffer_.size());
+  }
+
   // Set up configured socket options
   if (boost::system::error_code error = apply_socket_options())
   {
@@ -195,6 +293,15 @@ boost::system::error_code session::do_start_extern_start()
 
   // Internal states have right values already
   extern_state_ = extern_state::work;
+
+  // Connection accepted with deferred accept has data already, so it can be
+  // read without waiting for demultiplexer. If the read stops session then
+  // it's reported the same way as for any other read.
+  if (read_at_start_ && !continue_speculative_read())
+  {
+    return boost::system::error_code();
+  }
+
   continue_work();
 
   // Notify start handler about success
@@ -350,6 +457,97 @@ void session::handle_timer(const boost::system::error_code& error)
   }
 }
 
+void session::handle_splice_read(const boost::system::error_code& error,
+    std::size_t /*bytes_transferred*/)
+{
+  BOOST_ASSERT_MSG(read_state::in_progress == read_state_,
+      "Invalid read state");
+
+  if (error || (intern_state::stop == intern_state_))
+  {
+    handle_read(error, 0);
+    return;
+  }
+
+  boost::system::error_code splice_error;
+  pipe_.read_some(socket_.native_handle(), max_transfer_size_, splice_error);
+  if (boost::asio::error::would_block == splice_error)
+  {
+    if (pipe_.free_size())
+    {
+      // Socket has no data, so wait for it
+      start_socket_read_wait();
+      return;
+    }
+    // Pipe is full - complete read with nothing read
+    splice_error = boost::system::error_code();
+  }
+
+  // Read data is accounted by pipe_ so there is nothing to consume in buffer_
+  handle_read(splice_error, 0);
+}
+
+void session::handle_splice_write(const boost::system::error_code& error,
+    std::size_t /*bytes_transferred*/)
+{
+  BOOST_ASSERT_MSG(write_state::in_progress == write_state_,
+      "Invalid write state");
+
+  if (error || (intern_state::stop == intern_state_))
+  {
+    handle_write(error, 0);
+    return;
+  }
+
+  boost::system::error_code splice_error;
+  pipe_.write_some(socket_.native_handle(), max_transfer_size_, splice_error);
+  if (boost::asio::error::would_block == splice_error)
+  {
+    // Socket send buffer is full, so wait for free space
+    start_socket_write_wait();
+    return;
+  }
+
+  // Written data is accounted by pipe_ so there is nothing to commit in buffer_
+  handle_write(splice_error, 0);
+}
+
+void session::handle_zerocopy_wait(const boost::system::error_code& error)
+{
+  BOOST_ASSERT_MSG(zerocopy_wait_, "Invalid zero-copy wait state");
+
+  --pending_operations_;
+  zerocopy_wait_ = false;
+
+  if (intern_state::stop == intern_state_)
+  {
+    continue_stop();
+    return;
+  }
+
+  if (error && (boost::asio::error::operation_aborted != error))
+  {
+    start_stop(error);
+    return;
+  }
+
+  if (boost::system::error_code zerocopy_error = continue_zerocopy_wait())
+  {
+    start_stop(zerocopy_error);
+    return;
+  }
+
+  // Released buffer_ space can be used to continue
+  if (intern_state::work == intern_state_)
+  {
+    continue_work();
+  }
+  else
+  {
+    continue_shutdown(false);
+  }
+}
+
 void session::handle_read_at_work(const boost::system::error_code& error,
     std::size_t bytes_transferred)
 {
@@ -392,6 +590,22 @@ void session::handle_read_at_work(const boost::system::error_code& error,
     return;
   }
 
+  if (socket_profile::latency == profile_)
+  {
+    rearm_quick_ack();
+  }
+
+  if (speculative_read_)
+  {
+    const bool buffer_filled = bytes_transferred == requested_read_size_;
+    adapt_read_size(bytes_transferred, requested_read_size_);
+    // Socket probably has more data if read filled the whole buffer
+    if (buffer_filled && !continue_speculative_read())
+    {
+      return;
+    }
+  }
+
   continue_work();
 }
 
@@ -478,7 +692,21 @@ void session::handle_write_at_work(const boost::system::error_code& error,
   }
 
   // Handle written data
-  buffer_.commit(bytes_transferred);
+  handle_written_data(bytes_transferred);
+  write_completed_ = true;
+  if (boost::system::error_code zerocopy_error = continue_zerocopy_wait())
+  {
+    start_stop(zerocopy_error);
+    return;
+  }
+
+  // Peer probably has sent more data while waiting for write completion
+  if (speculative_read_ && (read_state::wait == read_state_)
+      && !continue_speculative_read())
+  {
+    return;
+  }
+
   continue_work();
 }
 
@@ -511,7 +739,13 @@ void session::handle_write_at_shutdown(const boost::system::error_code& error,
   }
 
   // Handle written data
-  buffer_.commit(bytes_transferred);
+  handle_written_data(bytes_transferred);
+  if (boost::system::error_code zerocopy_error = continue_zerocopy_wait())
+  {
+    start_stop(zerocopy_error);
+    return;
+  }
+
   continue_shutdown(true);
 }
 
@@ -564,7 +798,7 @@ void session::handle_timer_at_work(const boost::system::error_code& error)
   start_stop(server::error::inactivity_timeout);
 }
 
-void session::handle_timer_at_stop(const boost::system::error_code& /*error*/)
+void session::handle_timer_at_stop(const boost::system::error_code& error)
 {
   BOOST_ASSERT_MSG(intern_state::stop == intern_state_,
       "Invalid internal state");
@@ -574,9 +808,311 @@ void session::handle_timer_at_stop(const boost::system::error_code& /*error*/)
 
   --pending_operations_;
   timer_state_ = timer_state::stopped;
+
+  if (zerocopy_linger_ && (boost::asio::error::operation_aborted != error))
+  {
+    // Kernel didn't release data sent with MSG_ZEROCOPY in time. Closing of
+    // socket aborts wait for notifications and buffer_ isn't reused
+    // (see reset).
+    close_socket();
+  }
+
   continue_stop();
 }
 
+void session::handle_written_data(std::size_t size)
+{
+  if (zerocopy_write_)
+  {
+    // Data has to stay in buffer_ until kernel releases it
+    zerocopy_write_ = false;
+    if (size)
+    {
+      const zerocopy_send send = {size, false};
+      zerocopy_sends_.push_back(send);
+      zerocopy_pinned_size_ += size;
+    }
+    return;
+  }
+
+  if (zerocopy_sends_.empty())
+  {
+    buffer_.commit(size);
+    return;
+  }
+
+  // buffer_ is committed in order, so data can be committed only
+  // together with previously sent with MSG_ZEROCOPY
+  zerocopy_sends_.back().size += size;
+  zerocopy_pinned_size_ += size;
+}
+
+bool session::continue_speculative_read()
+{
+  BOOST_ASSERT_MSG(intern_state::work == intern_state_,
+      "Invalid internal state");
+
+  BOOST_ASSERT_MSG(read_state::wait == read_state_,
+      "Invalid read state");
+
+  if (pipe_.is_open())
+  {
+    return true;
+  }
+
+  const cyclic_buffer::mutable_buffers_type buffers(
+      buffer_.prepared(read_size_));
+  if (buffers.empty())
+  {
+    return true;
+  }
+
+  // Socket is non-blocking, so read doesn't wait for data
+  boost::system::error_code error;
+  const std::size_t bytes_transferred = socket_.read_some(buffers, error);
+  if (boost::asio::error::would_block == error)
+  {
+    // No data - continue with asynchronous read
+    return true;
+  }
+
+  if (error && (boost::asio::error::eof != error))
+  {
+    read_state_ = read_state::stopped;
+    start_stop(error);
+    return false;
+  }
+
+  buffer_.consume(bytes_transferred);
+  if (speculative_read_)
+  {
+    adapt_read_size(bytes_transferred, boost::asio::buffer_size(buffers));
+  }
+
+  if (boost::asio::error::eof == error)
+  {
+    read_state_ = read_state::stopped;
+    start_shutdown(error, true);
+    return false;
+  }
+
+  return true;
+}
+
+void session::adapt_read_size(std::size_t read_size,
+    std::size_t requested_size)
+{
+  const std::size_t min_read_size =
+      (std::min)(min_adaptive_read_size, max_transfer_size_);
+  if (read_size == requested_size)
+  {
+    // Grow up to read more data at once
+    read_size_ = (std::min)(read_size_ * 2, max_transfer_size_);
+  }
+  else if (read_size < read_size_ / 4)
+  {
+    // Reads are small, so don't reserve buffer space for nothing
+    read_size_ = (std::max)(read_size_ / 2, min_read_size);
+  }
+}
+
+boost::system::error_code session::continue_zerocopy_wait()
+{
+  if (zerocopy_sends_.empty())
+  {
+    return boost::system::error_code();
+  }
+
+  if (!zerocopy_wait_)
+  {
+    start_zerocopy_wait();
+  }
+
+  // Wait is started before reading because notifications queued before
+  // wait start can be not notified (edge-triggered demultiplexer)
+  return read_zerocopy_notifications();
+}
+
+#if defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+
+boost::system::error_code session::read_zerocopy_notifications()
+{
+  for (;;)
+  {
+    char control[128];
+    ::msghdr message = ::msghdr();
+    message.msg_control    = control;
+    message.msg_controllen = sizeof(control);
+
+    if (-1 == ::recvmsg(socket_.native_handle(), &message, MSG_ERRQUEUE))
+    {
+      const int error = errno;
+      if ((EAGAIN == error) || (EWOULDBLOCK == error))
+      {
+        // No more notifications
+        return boost::system::error_code();
+      }
+      return boost::system::error_code(error,
+          boost::system::system_category());
+    }
+
+    for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg;
+        cmsg = CMSG_NXTHDR(&message, cmsg))
+    {
+      const bool is_error = ((SOL_IP == cmsg->cmsg_level)
+          && (IP_RECVERR == cmsg->cmsg_type))
+          || ((SOL_IPV6 == cmsg->cmsg_level)
+          && (IPV6_RECVERR == cmsg->cmsg_type));
+      if (!is_error)
+      {
+        continue;
+      }
+      ::sock_extended_err extended_error;
+      std::memcpy(&extended_error, CMSG_DATA(cmsg), sizeof(extended_error));
+      if ((SO_EE_ORIGIN_ZEROCOPY == extended_error.ee_origin)
+          && !extended_error.ee_errno)
+      {
+        release_zerocopy_sends(extended_error.ee_info,
+            extended_error.ee_data);
+      }
+    }
+  }
+}
+
+#else // defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+
+boost::system::error_code session::read_zerocopy_notifications()
+{
+  return boost::system::error_code();
+}
+
+#endif // defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+
+void session::release_zerocopy_sends(boost::uint32_t first,
+    boost::uint32_t last)
+{
+  // Kernel identifies sends with 32-bit counter which can wrap around
+  boost::uint32_t begin = first - zerocopy_first_id_;
+  const boost::uint32_t end = last - zerocopy_first_id_;
+  if (begin > end)
+  {
+    // Range starts with already released sends
+    begin = 0;
+  }
+  for (std::size_t i = begin; (i <= end) && (i < zerocopy_sends_.size()); ++i)
+  {
+    zerocopy_sends_[i].done = true;
+  }
+
+  while (!zerocopy_sends_.empty() && zerocopy_sends_.front().done)
+  {
+    const std::size_t size = zerocopy_sends_.front().size;
+    buffer_.commit(size);
+    zerocopy_pinned_size_ -= size;
+    zerocopy_sends_.pop_front();
+    ++zerocopy_first_id_;
+  }
+}
+
+void session::continue_zerocopy_linger()
+{
+  BOOST_ASSERT_MSG(intern_state::stop == intern_state_,
+      "Invalid internal state");
+
+  if (!zerocopy_sends_.empty() && socket_.is_open() && !zerocopy_wait_)
+  {
+    if (read_zerocopy_notifications())
+    {
+      // Notifications can't be received, so there is nothing to wait for
+      close_socket();
+    }
+    else if (!zerocopy_sends_.empty())
+    {
+      start_zerocopy_wait();
+    }
+  }
+
+  if (zerocopy_sends_.empty() || !socket_.is_open())
+  {
+    // Nothing to wait for - stop waiting
+    if (zerocopy_linger_ && (timer_state::in_progress == timer_state_)
+        && !timer_wait_cancelled_)
+    {
+      boost::system::error_code ignored;
+      timer_.cancel(ignored);
+      timer_wait_cancelled_ = true;
+    }
+    return;
+  }
+
+  // Limit the time of wait because peer can stop reading at all
+  if (!zerocopy_linger_ && (timer_state::stopped == timer_state_))
+  {
+    boost::system::error_code error;
+    timer_.expires_from_now(*to_optional_duration(
+        boost::posix_time::milliseconds(zerocopy_linger_timeout_ms)), error);
+    if (error)
+    {
+      close_socket();
+      return;
+    }
+    zerocopy_linger_ = true;
+    timer_state_     = timer_state::ready;
+    start_timer_wait();
+  }
+}
+
+#if defined(MA_ECHO_SERVER_HAS_TCP_CORK)
+
+void session::continue_write_burst(bool has_data)
+{
+  const bool write_completed = write_completed_;
+  write_completed_ = false;
+
+  // Burst of writes exists only if there is data to write right after
+  // completion of previous write. Single write started from idle state
+  // (f.e. request / response exchange) isn't corked.
+  const bool cork = has_data && (corked_ || write_completed);
+  if ((socket_profile::throughput != profile_) || (cork == corked_))
+  {
+    return;
+  }
+
+  // Socket is corked while writes follow each other, so partial segments
+  // are held until the burst of writes ends. Corking is an optimization
+  // only, so errors are ignored (next socket operation reports them).
+  typedef boost::asio::detail::socket_option::boolean<
+      IPPROTO_TCP, TCP_CORK> cork_option;
+  boost::system::error_code error;
+  socket_.set_option(cork_option(cork), error);
+  if (!error)
+  {
+    corked_ = cork;
+  }
+}
+
+void session::rearm_quick_ack()
+{
+  // Kernel leaves quick ACK mode by itself, so the option has to be set
+  // again after reads. Errors are ignored like for TCP_CORK.
+  typedef boost::asio::detail::socket_option::boolean<
+      IPPROTO_TCP, TCP_QUICKACK> quick_ack_option;
+  boost::system::error_code error;
+  socket_.set_option(quick_ack_option(true), error);
+}
+
+#else // defined(MA_ECHO_SERVER_HAS_TCP_CORK)
+
+void session::continue_write_burst(bool /*has_data*/)
+{
+}
+
+void session::rearm_quick_ack()
+{
+}
+
+#endif // defined(MA_ECHO_SERVER_HAS_TCP_CORK)
+
 void session::continue_work()
 {
   BOOST_ASSERT_MSG(intern_state::work == intern_state_,
@@ -590,23 +1126,46 @@ void session::continue_work()
 
   if (read_state::wait == read_state_)
   {
-    cyclic_buffer::mutable_buffers_type read_buffers(
-        buffer_.prepared(max_transfer_size_));
-    if (!read_buffers.empty())
+    if (pipe_.is_open())
     {
-      // We have enough resources to begin socket read
-      start_socket_read(read_buffers);
+      if (pipe_.free_size())
+      {
+        start_socket_splice_read();
+      }
+    }
+    else
+    {
+      cyclic_buffer::mutable_buffers_type read_buffers(
+          buffer_.prepared(read_size_));
+      if (!read_buffers.empty())
+      {
+        // We have enough resources to begin socket read
+        start_socket_read(read_buffers);
+      }
     }
   }
 
   if (write_state::wait == write_state_)
   {
-    cyclic_buffer::const_buffers_type write_buffers(
-        buffer_.data(max_transfer_size_));
-    if (!write_buffers.empty())
+    if (pipe_.is_open())
     {
-      // We have enough resources to begin socket write
-      start_socket_write(write_buffers);
+      const bool has_data = 0 != pipe_.size();
+      continue_write_burst(has_data);
+      if (has_data)
+      {
+        start_socket_splice_write();
+      }
+    }
+    else
+    {
+      cyclic_buffer::const_buffers_type write_buffers(
+          buffer_.data(zerocopy_pinned_size_, max_transfer_size_));
+      continue_write_burst(!write_buffers.empty());
+      if (!write_buffers.empty())
+      {
+        // We have enough resources to begin socket write
+        start_socket_write(write_buffers);
+      }
     }
   }
 
@@ -624,8 +1183,10 @@ void session::continue_timer_wait()
     return;
   }
 
+  // Data sent with MSG_ZEROCOPY and not released by kernel is like a write
+  // in progress - peer which doesn't read it is inactive
   bool has_io_activity = (read_state::in_progress == read_state_)
-      || (write_state::in_progress == write_state_);
+      || (write_state::in_progress == write_state_) || zerocopy_wait_;
   if (has_io_activity && !timer_turned_)
   {
     // Update timer expiry
@@ -695,9 +1256,10 @@ void session::continue_shutdown_at_read_wait(bool need_timer_restart)
     write_state_ = write_state::stopped;
   }
 
-  if (write_state::stopped == write_state_)
+  if ((write_state::stopped == write_state_) && zerocopy_sends_.empty())
   {
-    // We won't make any income data handling more
+    // We won't make any income data handling more, so there is no need in
+    // pipe (if any) and income data is just read into (reset) buffer_
     buffer_.reset();
     cyclic_buffer::mutable_buffers_type read_buffers(buffer_.prepared());
     BOOST_ASSERT_MSG(!read_buffers.empty(), "buffer_ must be unfilled");
@@ -705,9 +1267,18 @@ void session::continue_shutdown_at_read_wait(bool need_timer_restart)
     // We have enough resources to begin socket read
     start_socket_read(read_buffers);
   }
-  else
+  else if (pipe_.is_open())
   {
     // write_state::in_progress == write_state_
+    if (pipe_.free_size())
+    {
+      start_socket_splice_read();
+    }
+  }
+  else
+  {
+    // write_state::in_progress == write_state_ or buffer_ holds data which
+    // was sent with MSG_ZEROCOPY and is not released by kernel yet
     cyclic_buffer::mutable_buffers_type read_buffers(buffer_.prepared());
     if (!read_buffers.empty())
     {
@@ -762,22 +1333,29 @@ void session::continue_shutdown_at_read_stopped(bool need_timer_restart)
   {
     // Write last read data
     cyclic_buffer::const_buffers_type write_buffers(
-        buffer_.data(max_transfer_size_));
-    if (!write_buffers.empty())
+        buffer_.data(zerocopy_pinned_size_, max_transfer_size_));
+    if (pipe_.size())
+    {
+      start_socket_splice_write();
+    }
+    else if (!write_buffers.empty())
     {
       // We have enough resources to begin socket write
       start_socket_write(write_buffers);
     }
-    else
+    else if (zerocopy_sends_.empty())
     {
       // We can shutdown outgoing part of TCP stream
       shutdown_socket();
       // Shutdown error has be ignored because read activity is already stopped
       write_state_ = write_state::stopped;
     }
+    // Otherwise buffer_ holds data sent with MSG_ZEROCOPY which is not
+    // released by kernel yet. Shutdown continues when the data is released
+    // (see handle_zerocopy_wait).
   }
 
-  if (write_state::stopped == write_state_)
+  if ((write_state::stopped == write_state_) && zerocopy_sends_.empty())
   {
     // Read and write activities are stopped,
     // so we can begin normal (unrelated to any error) internal general stop
@@ -797,6 +1375,8 @@ void session::continue_stop()
   BOOST_ASSERT_MSG(intern_state::stop == intern_state_,
       "Invalid internal state");
 
+  continue_zerocopy_linger();
+
   if (!pending_operations_)
   {
     BOOST_ASSERT_MSG(read_state::stopped  == read_state_,
@@ -808,6 +1388,10 @@ void session::continue_stop()
     BOOST_ASSERT_MSG(timer_state::stopped == timer_state_,
         "Invalid timer state");
 
+    // Socket can be kept open by start_stop till release of data sent with
+    // MSG_ZEROCOPY
+    close_socket();
+
     // Internal general stop completed
     intern_state_ = intern_state::stopped;
 
@@ -846,8 +1430,12 @@ void session::start_stop(boost::system::error_code error)
   // Switch general internal SM
   intern_state_ = intern_state::stop;
 
-  // Close the socket and register error if there was no stop error before
-  if (boost::system::error_code close_error = close_socket())
+  // Close the socket and register error if there was no stop error before.
+  // If kernel still holds data sent with MSG_ZEROCOPY then socket is only
+  // shut down and is closed after the data is released (see continue_stop),
+  // because notifications about release come through the socket.
+  if (boost::system::error_code close_error =
+      zerocopy_sends_.empty() ? close_socket() : cancel_socket())
   {
     if (!error)
     {
@@ -890,6 +1478,8 @@ void session::start_stop(boost::system::error_code error)
 void session::start_socket_read(
     const cyclic_buffer::mutable_buffers_type& buffers)
 {
+  requested_read_size_ = boost::asio::buffer_size(buffers);
+
 #if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
 
   socket_.async_read_some(buffers, strand_.wrap(make_custom_alloc_handler(
@@ -911,6 +1501,13 @@ void session::start_socket_read(
 void session::start_socket_write(
     const cyclic_buffer::const_buffers_type& buffers)
 {
+  if (zerocopy_
+      && (boost::asio::buffer_size(buffers) >= *zerocopy_threshold_))
+  {
+    start_socket_zerocopy_write(buffers);
+    return;
+  }
+
 #if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
 
   socket_.async_write_some(buffers, strand_.wrap(make_custom_alloc_handler(
@@ -930,6 +1527,141 @@ void session::start_socket_write(
   write_state_ = write_state::in_progress;
 }
 
+void session::start_socket_splice_read()
+{
+  // Try to splice right now because socket can already have data
+  // which wouldn't be notified about (edge-triggered demultiplexer)
+
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  strand_.post(make_custom_alloc_handler(read_allocator_, bind_handler(
+      io_handler_binder(&this_type::handle_splice_read, shared_from_this()),
+      boost::system::error_code(), static_cast<std::size_t>(0))));
+
+#else
+
+  strand_.post(make_custom_alloc_handler(read_allocator_, detail::bind(
+      &this_type::handle_splice_read, shared_from_this(),
+      boost::system::error_code(), static_cast<std::size_t>(0))));
+
+#endif
+
+  ++pending_operations_;
+  read_state_ = read_state::in_progress;
+}
+
+void session::start_socket_splice_write()
+{
+  // Try to splice right now because socket send buffer usually has space
+
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  strand_.post(make_custom_alloc_handler(write_allocator_, bind_handler(
+      io_handler_binder(&this_type::handle_splice_write, shared_from_this()),
+      boost::system::error_code(), static_cast<std::size_t>(0))));
+
+#else
+
+  strand_.post(make_custom_alloc_handler(write_allocator_, detail::bind(
+      &this_type::handle_splice_write, shared_from_this(),
+      boost::system::error_code(), static_cast<std::size_t>(0))));
+
+#endif
+
+  ++pending_operations_;
+  write_state_ = write_state::in_progress;
+}
+
+void session::start_socket_read_wait()
+{
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  socket_.async_read_some(boost::asio::null_buffers(), strand_.wrap(
+      make_custom_alloc_handler(read_allocator_, io_handler_binder(
+          &this_type::handle_splice_read, shared_from_this()))));
+
+#else
+
+  socket_.async_read_some(boost::asio::null_buffers(), strand_.wrap(
+      make_custom_alloc_handler(read_allocator_, detail::bind(
+          &this_type::handle_splice_read, shared_from_this(),
+          detail::placeholders::_1, detail::placeholders::_2))));
+
+#endif
+}
+
+void session::start_socket_write_wait()
+{
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  socket_.async_write_some(boost::asio::null_buffers(), strand_.wrap(
+      make_custom_alloc_handler(write_allocator_, io_handler_binder(
+          &this_type::handle_splice_write, shared_from_this()))));
+
+#else
+
+  socket_.async_write_some(boost::asio::null_buffers(), strand_.wrap(
+      make_custom_alloc_handler(write_allocator_, detail::bind(
+          &this_type::handle_splice_write, shared_from_this(),
+          detail::placeholders::_1, detail::placeholders::_2))));
+
+#endif
+}
+
+void session::start_socket_zerocopy_write(
+    const cyclic_buffer::const_buffers_type& buffers)
+{
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  socket_.async_send(buffers, zerocopy_message_flags, strand_.wrap(
+      make_custom_alloc_handler(write_allocator_, io_handler_binder(
+          &this_type::handle_write, shared_from_this()))));
+
+#else
+
+  socket_.async_send(buffers, zerocopy_message_flags, strand_.wrap(
+      make_custom_alloc_handler(write_allocator_, detail::bind(
+          &this_type::handle_write, shared_from_this(),
+          detail::placeholders::_1, detail::placeholders::_2))));
+
+#endif
+
+  ++pending_operations_;
+  write_state_    = write_state::in_progress;
+  zerocopy_write_ = true;
+}
+
+void session::start_zerocopy_wait()
+{
+#if defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+
+  // Kernel notifies about released data through socket error queue
+
+#if defined(MA_HAS_RVALUE_REFS) && defined(MA_BIND_HAS_NO_MOVE_CONSTRUCTOR)
+
+  socket_.async_wait(protocol_type::socket::wait_error, strand_.wrap(
+      make_custom_alloc_handler(zerocopy_allocator_, timer_handler_binder(
+          &this_type::handle_zerocopy_wait, shared_from_this()))));
+
+#else
+
+  socket_.async_wait(protocol_type::socket::wait_error, strand_.wrap(
+      make_custom_alloc_handler(zerocopy_allocator_, detail::bind(
+          &this_type::handle_zerocopy_wait, shared_from_this(),
+          detail::placeholders::_1))));
+
+#endif
+
+  ++pending_operations_;
+  zerocopy_wait_ = true;
+
+#else // defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+
+  BOOST_ASSERT_MSG(false, "MSG_ZEROCOPY is not supported");
+
+#endif // defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+}
+
 void session::start_timer_wait()
 {
   BOOST_ASSERT_MSG(timer_state::ready == timer_state_,
@@ -983,6 +1715,17 @@ boost::system::error_code session::close_socket()
   return error;
 }
 
+boost::system::error_code session::cancel_socket()
+{
+  // Peer sees the end of stream like if socket was closed. Shutdown error is
+  // ignored because connection can be already broken.
+  boost::system::error_code error;
+  socket_.shutdown(protocol_type::socket::shutdown_both, error);
+  error = boost::system::error_code();
+  socket_.cancel(error);
+  return error;
+}
+
 boost::system::error_code session::apply_socket_options()
 {
   typedef protocol_type::socket socket_type;
@@ -1032,6 +1775,85 @@ boost::system::error_code session::apply_socket_options()
     }
   }
 
+  if (socket_profile::latency == profile_)
+  {
+    boost::system::error_code error;
+    protocol_type::no_delay opt(true);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+    rearm_quick_ack();
+  }
+
+  session_config::optional_int notsent_lowat = socket_notsent_lowat_;
+  if (!notsent_lowat && (socket_profile::throughput == profile_))
+  {
+    notsent_lowat = default_notsent_lowat;
+  }
+
+  if (notsent_lowat)
+  {
+#if defined(TCP_NOTSENT_LOWAT)
+    typedef boost::asio::detail::socket_option::integer<
+        IPPROTO_TCP, TCP_NOTSENT_LOWAT> notsent_lowat_option;
+    boost::system::error_code error;
+    notsent_lowat_option opt(*notsent_lowat);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+#else
+    if (socket_notsent_lowat_)
+    {
+      return boost::asio::error::operation_not_supported;
+    }
+#endif
+  }
+
+  if (pipe_.is_open() || speculative_read_ || read_at_start_)
+  {
+    // splice(), speculative read and read at start have to fail instead
+    // of blocking on socket
+    boost::system::error_code error;
+    socket_.non_blocking(true, error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (zerocopy_threshold_ && !pipe_.is_open())
+  {
+#if defined(MA_ECHO_SERVER_HAS_ZEROCOPY)
+    typedef boost::asio::detail::socket_option::boolean<
+        SOL_SOCKET, SO_ZEROCOPY> zerocopy_option;
+    // If kernel doesn't support MSG_ZEROCOPY then writes are just copied
+    boost::system::error_code error;
+    socket_.set_option(zerocopy_option(true), error);
+    zerocopy_ = !error;
+#endif
+  }
+
+  if (socket_busy_poll_)
+  {
+#if defined(SO_BUSY_POLL)
+    typedef boost::asio::detail::socket_option::integer<
+        SOL_SOCKET, SO_BUSY_POLL> busy_poll_option;
+    boost::system::error_code error;
+    busy_poll_option opt(*socket_busy_poll_);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+#else
+    return boost::asio::error::operation_not_supported;
+#endif
+  }
+
   return boost::system::error_code();
 }
 
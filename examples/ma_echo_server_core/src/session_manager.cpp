@@ -59,7 +59,9 @@ private:
 
 template <typename Acceptor>
 void open(Acceptor& acceptor, const typename Acceptor::endpoint_type& endpoint,
-    int backlog, boost::system::error_code& error)
+    int backlog, const session_manager_config::optional_int& defer_accept,
+    const session_manager_config::optional_int& fast_open_queue_size,
+    boost::system::error_code& error)
 {
   acceptor.open(endpoint.protocol(), error);
   if (error)
@@ -76,6 +78,38 @@ void open(Acceptor& acceptor, const typename Acceptor::endpoint_type& endpoint,
     return;
   }
 
+  if (defer_accept)
+  {
+#if defined(TCP_DEFER_ACCEPT)
+    typedef boost::asio::detail::socket_option::integer<
+        IPPROTO_TCP, TCP_DEFER_ACCEPT> defer_accept_option;
+    acceptor.set_option(defer_accept_option(*defer_accept), error);
+    if (error)
+    {
+      return;
+    }
+#else
+    error = boost::asio::error::operation_not_supported;
+    return;
+#endif
+  }
+
+  if (fast_open_queue_size)
+  {
+#if defined(TCP_FASTOPEN)
+    typedef boost::asio::detail::socket_option::integer<
+        IPPROTO_TCP, TCP_FASTOPEN> fast_open_option;
+    acceptor.set_option(fast_open_option(*fast_open_queue_size), error);
+    if (error)
+    {
+      return;
+    }
+#else
+    error = boost::asio::error::operation_not_supported;
+    return;
+#endif
+  }
+
   acceptor.bind(endpoint, error);
   if (error)
   {
@@ -316,6 +350,13 @@ void session_manager::stats_collector::set_recycled_session_count(
   stats_.recycled = count;
 }
 
+void session_manager::stats_collector::set_stopping_session_count(
+    std::size_t count)
+{
+  lock_guard_type lock_guard(mutex_);
+  stats_.stopping = count;
+}
+
 void session_manager::stats_collector::session_accepted(
     const boost::system::error_code& error)
 {
@@ -357,7 +398,7 @@ void session_manager::stats_collector::session_stopped(
 void session_manager::stats_collector::reset()
 {
   lock_guard_type lock_guard(mutex_);
-  stats_.active = stats_.max_active = stats_.recycled = 0;
+  stats_.active = stats_.max_active = stats_.recycled = stats_.stopping = 0;
   stats_.total_accepted    = 0;
   stats_.active_shutdowned = 0;
   stats_.out_of_work       = 0;
@@ -546,14 +587,19 @@ session_manager::session_manager(boost::asio::io_service& io_service,
     const session_manager_config& config)
   : accepting_endpoint_(config.accepting_endpoint)
   , listen_backlog_(config.listen_backlog)
+  , defer_accept_(config.defer_accept)
+  , fast_open_queue_size_(config.fast_open_queue_size)
   , max_session_count_(config.max_session_count)
+  , accept_resume_session_count_(config.accept_resume_session_count)
   , recycled_session_count_(config.recycled_session_count)
+  , warm_session_count_(config.warm_session_count)
   , max_stopping_sessions_(config.max_stopping_sessions)
   , managed_session_config_(config.managed_session_config)
   , extern_state_(extern_state::ready)
   , intern_state_(intern_state::work)
   , accept_state_(accept_state::ready)
   , pending_operations_(0)
+  , stopping_session_count_(0)
   , io_service_(io_service)
   , session_factory_(managed_session_factory)
   , strand_(io_service)
@@ -569,6 +615,7 @@ void session_manager::reset(bool free_recycled_sessions)
   intern_state_ = intern_state::work;
   accept_state_ = accept_state::ready;
   pending_operations_ = 0;
+  stopping_session_count_ = 0;
 
   close_acceptor();
 
@@ -595,6 +642,18 @@ boost::system::error_code session_manager::do_start_extern_start()
     return server::error::invalid_state;
   }
 
+  // Pre-create sessions to not pay for their construction on accept
+  if (warm_session_count_)
+  {
+    boost::system::error_code error;
+    session_factory_.warm_up(managed_session_config_, warm_session_count_,
+        error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
   // Internal states have right values already
   extern_state_ = extern_state::work;
   continue_work();
@@ -691,6 +750,16 @@ void session_manager::continue_work()
     return;
   }
 
+  if (accept_state::paused == accept_state_)
+  {
+    if (active_sessions_.size() > accept_resume_session_count_)
+    {
+      // Wait for enough space to not pause accept again right after resume
+      return;
+    }
+    accept_state_ = accept_state::ready;
+  }
+
   if (accept_state::ready != accept_state_)
   {
     // Can't start more accept operations - no ready acceptors
@@ -699,11 +768,10 @@ void session_manager::continue_work()
 
   if (active_sessions_.size() >= max_session_count_)
   {
-    // Can't start more accept operations - no space
-    if (acceptor_.is_open())
-    {
-      close_acceptor();
-    }
+    // Can't start more accept operations - no space.
+    // Acceptor is kept open so new connections wait in the listen backlog
+    // instead of being refused.
+    accept_state_ = accept_state::paused;
     return;
   }
 
@@ -811,6 +879,10 @@ void session_manager::handle_session_wait(const session_wrapper_ptr& session,
 void session_manager::handle_session_stop(const session_wrapper_ptr& session,
     const boost::system::error_code& error)
 {
+  // Collect statistics (stop progress)
+  --stopping_session_count_;
+  stats_collector_.set_stopping_session_count(stopping_session_count_);
+
   // Split handler based on current internal state
   // that might change during session stop
   switch (intern_state_)
@@ -1101,7 +1173,8 @@ void session_manager::start_stop(const boost::system::error_code& error)
   }
 
   // Switch all internal SMs to the right states
-  if (accept_state::ready == accept_state_)
+  if ((accept_state::ready == accept_state_)
+      || (accept_state::paused == accept_state_))
   {
     accept_state_ = accept_state::stopped;
   }
@@ -1248,6 +1321,9 @@ void session_manager::start_session_stop(const session_wrapper_ptr& session)
 #endif
 
   ++pending_operations_;
+  // Collect statistics (stop progress)
+  ++stopping_session_count_;
+  stats_collector_.set_stopping_session_count(stopping_session_count_);
 }
 
 void session_manager::start_session_wait(const session_wrapper_ptr& session)
@@ -1371,7 +1447,8 @@ void session_manager::remove_from_recycled(const session_wrapper_ptr& session)
 boost::system::error_code session_manager::open_acceptor()
 {
   boost::system::error_code error;
-  open(acceptor_, accepting_endpoint_, listen_backlog_, error);
+  open(acceptor_, accepting_endpoint_, listen_backlog_, defer_accept_,
+      fast_open_queue_size_, error);
   return error;
 }
 
@@ -6,6 +6,7 @@
 //
 
 #include <new>
+#include <algorithm>
 #include <ma/shared_ptr_factory.hpp>
 #include <ma/echo/server/error.hpp>
 #include <ma/echo/server/simple_session_factory.hpp>
@@ -77,6 +78,28 @@ void simple_session_factory::release(const session_ptr& session)
   }
 }
 
+void simple_session_factory::warm_up(const session_config& config,
+    std::size_t count, boost::system::error_code& error)
+{
+  const std::size_t max_count = (std::min)(count, max_recycled_);
+  try
+  {
+    while (recycled_.size() < max_count)
+    {
+      session_wrapper_ptr session = session_wrapper::create(
+          io_service_, config);
+      session->warm_up();
+      recycled_.push_front(session);
+    }
+    error = boost::system::error_code();
+  }
+  catch (const std::bad_alloc&)
+  {
+    error = boost::system::errc::make_error_code(
+        boost::system::errc::not_enough_memory);
+  }
+}
+
 } // namespace server
 } // namespace echo
 } // namespace ma
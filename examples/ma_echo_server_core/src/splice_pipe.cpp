@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <ma/echo/server/splice_pipe.hpp>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ma {
+namespace echo {
+namespace server {
+
+#if defined(__linux__)
+
+namespace {
+
+boost::system::error_code last_system_error()
+{
+  const int error = errno;
+  if ((EAGAIN == error) || (EWOULDBLOCK == error))
+  {
+    return boost::asio::error::would_block;
+  }
+  return boost::system::error_code(error, boost::system::system_category());
+}
+
+} // anonymous namespace
+
+boost::system::error_code splice_pipe::open(std::size_t capacity)
+{
+  if (is_open())
+  {
+    return boost::asio::error::already_open;
+  }
+
+  int ends[2];
+  if (-1 == ::pipe2(ends, O_NONBLOCK | O_CLOEXEC))
+  {
+    return last_system_error();
+  }
+  read_end_  = ends[0];
+  write_end_ = ends[1];
+
+  // Kernel rounds capacity up and can refuse too large one,
+  // so failure is ignored and actual capacity is asked
+  ::fcntl(write_end_, F_SETPIPE_SZ, static_cast<int>(
+      (std::min)(capacity, static_cast<std::size_t>(1024 * 1024))));
+  const int actual_capacity = ::fcntl(write_end_, F_GETPIPE_SZ);
+  if (actual_capacity <= 0)
+  {
+    boost::system::error_code error = last_system_error();
+    close();
+    return error;
+  }
+
+  capacity_ = static_cast<std::size_t>(actual_capacity);
+  size_     = 0;
+  full_     = false;
+  return boost::system::error_code();
+}
+
+void splice_pipe::close()
+{
+  if (is_open())
+  {
+    ::close(read_end_);
+    ::close(write_end_);
+    read_end_  = -1;
+    write_end_ = -1;
+  }
+  capacity_ = 0;
+  size_     = 0;
+  full_     = false;
+}
+
+std::size_t splice_pipe::read_some(native_handle_type source,
+    std::size_t max_size, boost::system::error_code& error)
+{
+  BOOST_ASSERT_MSG(max_size && free_size(), "Pipe must have free space");
+
+  const ssize_t result = ::splice(source, 0, write_end_, 0,
+      (std::min)(max_size, free_size()), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (result < 0)
+  {
+    error = last_system_error();
+    if ((boost::asio::error::would_block == error) && size_)
+    {
+      // Either source has no data or pipe has no free pages.
+      // Consider the latter to not spin until pipe is drained.
+      full_ = true;
+    }
+    return 0;
+  }
+  if (!result)
+  {
+    error = boost::asio::error::eof;
+    return 0;
+  }
+  error = boost::system::error_code();
+  size_ += static_cast<std::size_t>(result);
+  return static_cast<std::size_t>(result);
+}
+
+std::size_t splice_pipe::write_some(native_handle_type target,
+    std::size_t max_size, boost::system::error_code& error)
+{
+  BOOST_ASSERT_MSG(max_size && size_, "Pipe must have data");
+
+  const ssize_t result = ::splice(read_end_, 0, target, 0,
+      (std::min)(max_size, size_), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (result < 0)
+  {
+    error = last_system_error();
+    return 0;
+  }
+  error = boost::system::error_code();
+  size_ -= static_cast<std::size_t>(result);
+  if (result)
+  {
+    full_ = false;
+  }
+  return static_cast<std::size_t>(result);
+}
+
+#else // defined(__linux__)
+
+boost::system::error_code splice_pipe::open(std::size_t /*capacity*/)
+{
+  return boost::asio::error::operation_not_supported;
+}
+
+void splice_pipe::close()
+{
+}
+
+std::size_t splice_pipe::read_some(native_handle_type /*source*/,
+    std::size_t /*max_size*/, boost::system::error_code& error)
+{
+  error = boost::asio::error::operation_not_supported;
+  return 0;
+}
+
+std::size_t splice_pipe::write_some(native_handle_type /*target*/,
+    std::size_t /*max_size*/, boost::system::error_code& error)
+{
+  error = boost::asio::error::operation_not_supported;
+  return 0;
+}
+
+#endif // defined(__linux__)
+
+void splice_pipe::reset()
+{
+  // Data held by the pipe can't be dropped without reading it
+  if (size_)
+  {
+    close();
+  }
+  full_ = false;
+}
+
+} // namespace server
+} // namespace echo
+} // namespace ma
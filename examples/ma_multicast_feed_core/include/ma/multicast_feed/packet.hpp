@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_MULTICAST_FEED_PACKET_HPP
+#define MA_MULTICAST_FEED_PACKET_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <time.h>
+#include <boost/cstdint.hpp>
+
+namespace ma {
+namespace multicast_feed {
+
+/// Header each datagram of the feed starts with.
+/**
+ * Sequence numbers are counted per multicast group. Send time is the number
+ * of nanoseconds since the Epoch (CLOCK_REALTIME) so it can be compared
+ * with kernel receive timestamps. On the wire fields are big-endian.
+ */
+struct packet_header
+{
+  packet_header();
+  packet_header(boost::uint64_t sequence, boost::uint64_t send_time);
+
+  boost::uint64_t sequence;
+  boost::uint64_t send_time;
+}; // struct packet_header
+
+/// Size of packet_header on the wire.
+const std::size_t packet_header_size = 16;
+
+/// Writes header into the given buffer of at least packet_header_size bytes.
+void write_packet_header(const packet_header& header, char* data);
+
+/// Reads header from the given buffer of at least packet_header_size bytes.
+packet_header read_packet_header(const char* data);
+
+/// Nanoseconds since the Epoch.
+boost::uint64_t to_nanoseconds(const ::timespec& time);
+
+/// Current time in the units of packet_header::send_time.
+boost::uint64_t current_time();
+
+inline packet_header::packet_header()
+  : sequence(0)
+  , send_time(0)
+{
+}
+
+inline packet_header::packet_header(boost::uint64_t the_sequence,
+    boost::uint64_t the_send_time)
+  : sequence(the_sequence)
+  , send_time(the_send_time)
+{
+}
+
+namespace detail {
+
+inline void write_uint64(boost::uint64_t value, char* data)
+{
+  for (std::size_t i = 8; i != 0; --i)
+  {
+    data[i - 1] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+inline boost::uint64_t read_uint64(const char* data)
+{
+  boost::uint64_t value = 0;
+  for (std::size_t i = 0; i != 8; ++i)
+  {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+} // namespace detail
+
+inline void write_packet_header(const packet_header& header, char* data)
+{
+  detail::write_uint64(header.sequence, data);
+  detail::write_uint64(header.send_time, data + 8);
+}
+
+inline packet_header read_packet_header(const char* data)
+{
+  return packet_header(detail::read_uint64(data),
+      detail::read_uint64(data + 8));
+}
+
+inline boost::uint64_t to_nanoseconds(const ::timespec& time)
+{
+  return static_cast<boost::uint64_t>(time.tv_sec) * 1000000000
+      + static_cast<boost::uint64_t>(time.tv_nsec);
+}
+
+inline boost::uint64_t current_time()
+{
+  ::timespec time;
+  ::clock_gettime(CLOCK_REALTIME, &time);
+  return to_nanoseconds(time);
+}
+
+} // namespace multicast_feed
+} // namespace ma
+
+#endif // MA_MULTICAST_FEED_PACKET_HPP
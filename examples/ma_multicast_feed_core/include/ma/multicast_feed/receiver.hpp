@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_MULTICAST_FEED_RECEIVER_HPP
+#define MA_MULTICAST_FEED_RECEIVER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/spsc_queue.hpp>
+#include <ma/detail/atomic.hpp>
+
+namespace ma {
+namespace multicast_feed {
+
+/// Datagram handed off by receiver to consumer.
+struct received_packet
+{
+  /// Value of group for datagrams not addressed to any of joined groups.
+  static const std::size_t unknown_group = static_cast<std::size_t>(-1);
+
+  received_packet();
+
+  /// Index of multicast group in receiver_config::groups.
+  std::size_t     group;
+  boost::uint64_t sequence;
+  boost::uint64_t send_time;
+  /// Kernel receive timestamp (SO_TIMESTAMPNS) in the units of send_time.
+  boost::uint64_t receive_time;
+  boost::asio::ip::udp::endpoint sender;
+  /// Whole datagram including packet_header. Memory is owned by receiver.
+  char*           data;
+  std::size_t     size;
+}; // struct received_packet
+
+typedef ma::spsc_queue<received_packet> packet_queue;
+
+struct receiver_config
+{
+public:
+  typedef boost::optional<int> optional_int;
+  typedef std::vector<boost::asio::ip::address> address_vector;
+  typedef boost::optional<boost::asio::ip::address_v4> optional_address_v4;
+
+  receiver_config(const boost::asio::ip::udp::endpoint& endpoint,
+      const address_vector& groups,
+      const optional_address_v4& interface_address,
+      std::size_t batch_size,
+      std::size_t datagram_size,
+      const optional_int& socket_recv_buffer_size);
+
+  boost::asio::ip::udp::endpoint endpoint;
+  address_vector      groups;
+  /// Local interface used to join IPv4 groups, chosen by the system if empty.
+  optional_address_v4 interface_address;
+  /// Max number of datagrams received by single system call.
+  std::size_t         batch_size;
+  /// Max size of received datagram.
+  std::size_t         datagram_size;
+  optional_int        socket_recv_buffer_size;
+}; // struct receiver_config
+
+struct receiver_stats
+{
+  receiver_stats();
+
+  boost::uint64_t received_packets;
+  boost::uint64_t received_bytes;
+  boost::uint64_t receive_calls;
+  /// Datagrams dropped because the queue was full.
+  boost::uint64_t queue_overflows;
+  /// Datagrams without packet_header or truncated ones.
+  boost::uint64_t malformed_packets;
+  /// Sequence numbers skipped by received datagrams (lost datagrams).
+  boost::uint64_t sequence_gaps;
+  /// Datagrams with sequence number less than expected one.
+  boost::uint64_t reordered_packets;
+  /// Datagrams dropped by the kernel because of full socket receive buffer
+  /// (SO_RXQ_OVFL).
+  boost::uint64_t kernel_drops;
+}; // struct receiver_stats
+
+/// Receiver of multicast feed which hands off datagrams through lock-free
+/// queue.
+/**
+ * Receiver joins multicast groups on single socket and receives datagrams
+ * with recvmmsg directly into the free slots of the queue. Slots point to
+ * memory preallocated by receiver, so nothing is allocated or copied per
+ * datagram. If the queue is full then datagrams are still received (to not
+ * make kernel drop fresh ones) but are dropped and counted as queue
+ * overflows.
+ *
+ * Receiver is the producer of the queue and the consumer can run in another
+ * thread. Handlers of receiver are not synchronized, so io_service of
+ * receiver has to be run by a single thread. Linux only.
+ */
+class receiver : private boost::noncopyable
+{
+private:
+  typedef receiver this_type;
+
+public:
+  /// Queue has to be empty and its slots are reserved for this receiver.
+  receiver(boost::asio::io_service& io_service, const receiver_config& config,
+      packet_queue& queue);
+
+  /// Opens socket, joins groups and starts receiving.
+  boost::system::error_code start();
+
+  /// Closes socket. Thread-safe.
+  void stop();
+
+  /// Thread-safe.
+  receiver_stats stats() const;
+
+private:
+  typedef ma::detail::atomic<boost::uint64_t> atomic_counter;
+  typedef boost::optional<boost::uint64_t> optional_sequence;
+
+  void handle_wait(const boost::system::error_code&);
+  void handle_continue();
+  void handle_stop();
+
+  void continue_work();
+  bool receive_batch();
+  bool parse_packet(::mmsghdr& message, received_packet& packet);
+  void track_sequence(const received_packet& packet, boost::uint64_t& gaps,
+      boost::uint64_t& reordered);
+  void start_wait();
+  void start_continue();
+  boost::system::error_code apply_socket_options();
+  boost::system::error_code join_groups();
+
+  const receiver_config config_;
+  const std::size_t     control_size_;
+
+  boost::asio::io_service&     io_service_;
+  boost::asio::ip::udp::socket socket_;
+  packet_queue&                queue_;
+  bool                         stopped_;
+
+  // Memory of queue slots and of datagrams dropped due to full queue
+  std::vector<char>             data_;
+  std::vector<char>             overflow_data_;
+  std::vector<received_packet>  overflow_packets_;
+  // Preallocated batch
+  std::vector<char>             control_;
+  std::vector< ::mmsghdr>       messages_;
+  std::vector< ::iovec>         iovecs_;
+  std::vector<received_packet*> packets_;
+  // Next expected sequence number per group
+  std::vector<optional_sequence> next_sequences_;
+
+  atomic_counter received_packets_;
+  atomic_counter received_bytes_;
+  atomic_counter receive_calls_;
+  atomic_counter queue_overflows_;
+  atomic_counter malformed_packets_;
+  atomic_counter sequence_gaps_;
+  atomic_counter reordered_packets_;
+  atomic_counter kernel_drops_;
+
+  ma::in_place_handler_allocator<128> allocator_;
+}; // class receiver
+
+} // namespace multicast_feed
+} // namespace ma
+
+#endif // MA_MULTICAST_FEED_RECEIVER_HPP
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_MULTICAST_FEED_SENDER_HPP
+#define MA_MULTICAST_FEED_SENDER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/detail/atomic.hpp>
+#include <ma/detail/functional.hpp>
+#include <ma/detail/random.hpp>
+
+namespace ma {
+namespace multicast_feed {
+
+struct sender_config
+{
+public:
+  typedef boost::optional<int> optional_int;
+  typedef boost::optional<boost::uint64_t> optional_count;
+  typedef std::vector<boost::asio::ip::udp::endpoint> endpoint_vector;
+  typedef boost::optional<boost::asio::ip::address_v4> optional_address_v4;
+
+  sender_config(const endpoint_vector& destinations,
+      const optional_address_v4& interface_address,
+      int hops,
+      bool loopback,
+      boost::uint64_t rate,
+      std::size_t batch_size,
+      std::size_t min_payload_size,
+      std::size_t max_payload_size,
+      const optional_count& packet_count,
+      const optional_int& socket_send_buffer_size);
+
+  /// Multicast groups. Datagrams are sent to them in turn.
+  endpoint_vector     destinations;
+  /// Local interface used to send IPv4 datagrams, chosen by the system if
+  /// empty.
+  optional_address_v4 interface_address;
+  /// TTL (IPv4) or hop limit (IPv6) of datagrams.
+  int                 hops;
+  /// Deliver datagrams to the receivers on the same host.
+  bool                loopback;
+  /// Target number of datagrams per second (for all groups together).
+  boost::uint64_t     rate;
+  /// Max number of datagrams sent by single system call (burst).
+  std::size_t         batch_size;
+  /// Size of datagram following packet_header is chosen uniformly
+  /// from [min_payload_size, max_payload_size].
+  std::size_t         min_payload_size;
+  std::size_t         max_payload_size;
+  /// Number of datagrams to send. Unlimited if empty.
+  optional_count      packet_count;
+  optional_int        socket_send_buffer_size;
+}; // struct sender_config
+
+struct sender_stats
+{
+  sender_stats();
+
+  boost::uint64_t sent_packets;
+  boost::uint64_t sent_bytes;
+  boost::uint64_t send_calls;
+  /// Datagrams which failed to be sent and were skipped.
+  boost::uint64_t send_errors;
+  /// Number of times the socket send buffer was full.
+  boost::uint64_t blocked_sends;
+  /// Number of datagrams which are due by schedule but are not sent yet.
+  boost::uint64_t lag;
+}; // struct sender_stats
+
+/// Load generator of multicast feed.
+/**
+ * Sender paces datagrams to keep the target rate. Schedule is counted from
+ * the start, so sender catches up after it was delayed. Datagrams which are
+ * due are sent in bursts with sendmmsg. Each datagram starts with
+ * packet_header which holds per group sequence number and the time of
+ * sending.
+ *
+ * Handlers of sender are not synchronized, so io_service of sender has to
+ * be run by a single thread. Linux only.
+ */
+class sender : private boost::noncopyable
+{
+private:
+  typedef sender this_type;
+
+public:
+  /// Called when all datagrams are sent or when sending fails. Isn't called
+  /// if sender is stopped by stop().
+  typedef ma::detail::function<void (const boost::system::error_code&)>
+      completion_handler;
+
+  sender(boost::asio::io_service& io_service, const sender_config& config);
+
+  /// Opens socket and starts sending.
+  boost::system::error_code start(const completion_handler& handler);
+
+  /// Stops sending and closes socket. Thread-safe.
+  void stop();
+
+  /// Thread-safe.
+  sender_stats stats() const;
+
+private:
+  typedef ma::detail::atomic<boost::uint64_t> atomic_counter;
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+  typedef ma::detail::uniform_int_distribution<std::size_t>
+      payload_size_distribution;
+
+  void handle_timer(const boost::system::error_code&);
+  void handle_write_wait(const boost::system::error_code&);
+  void handle_continue();
+  void handle_stop();
+
+  void continue_work();
+  boost::uint64_t due_packets(const time_type& time) const;
+  boost::uint64_t remaining_packets() const;
+  void prepare_batch(std::size_t count);
+  bool send_batch(std::size_t count);
+  void start_timer(boost::uint64_t due_packets);
+  void start_write_wait();
+  void start_continue();
+  void complete(const boost::system::error_code&);
+  boost::system::error_code apply_socket_options();
+
+  const sender_config config_;
+
+  boost::asio::io_service&     io_service_;
+  boost::asio::ip::udp::socket socket_;
+  ma::steady_deadline_timer    timer_;
+  completion_handler           handler_;
+  bool                         stopped_;
+  time_type                    start_time_;
+  // Index of the next datagram to send (over all groups)
+  boost::uint64_t              next_packet_;
+
+  ma::detail::mt19937          random_;
+  payload_size_distribution    payload_size_;
+
+  // Preallocated batch
+  std::vector<char>     data_;
+  std::vector< ::mmsghdr> messages_;
+  std::vector< ::iovec> iovecs_;
+
+  atomic_counter sent_packets_;
+  atomic_counter sent_bytes_;
+  atomic_counter send_calls_;
+  atomic_counter send_errors_;
+  atomic_counter blocked_sends_;
+  atomic_counter lag_;
+
+  ma::in_place_handler_allocator<128> write_allocator_;
+  ma::in_place_handler_allocator<128> timer_allocator_;
+}; // class sender
+
+} // namespace multicast_feed
+} // namespace ma
+
+#endif // MA_MULTICAST_FEED_SENDER_HPP
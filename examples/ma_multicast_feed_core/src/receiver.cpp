@@ -0,0 +1,525 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <netinet/in.h>
+#include <boost/assert.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/multicast_feed/packet.hpp>
+#include <ma/multicast_feed/receiver.hpp>
+#include <ma/detail/functional.hpp>
+
+namespace ma {
+namespace multicast_feed {
+
+namespace {
+
+// Number of batches handled before letting other handlers run
+const std::size_t max_batches_per_run = 16;
+
+typedef boost::asio::detail::socket_option::boolean<
+    SOL_SOCKET, SO_TIMESTAMPNS> timestamp_option;
+typedef boost::asio::detail::socket_option::boolean<
+    SOL_SOCKET, SO_RXQ_OVFL> drop_counter_option;
+typedef boost::asio::detail::socket_option::boolean<
+    IPPROTO_IP, IP_PKTINFO> v4_destination_option;
+typedef boost::asio::detail::socket_option::boolean<
+    IPPROTO_IPV6, IPV6_RECVPKTINFO> v6_destination_option;
+
+std::size_t control_size()
+{
+  return CMSG_SPACE(sizeof(::timespec))
+      + CMSG_SPACE(sizeof(boost::uint32_t))
+      + CMSG_SPACE((std::max)(sizeof(::in_pktinfo), sizeof(::in6_pktinfo)));
+}
+
+bool would_block(int error)
+{
+  return (EAGAIN == error) || (EWOULDBLOCK == error);
+}
+
+} // anonymous namespace
+
+const std::size_t received_packet::unknown_group;
+
+received_packet::received_packet()
+  : group(unknown_group)
+  , sequence(0)
+  , send_time(0)
+  , receive_time(0)
+  , sender()
+  , data(0)
+  , size(0)
+{
+}
+
+receiver_config::receiver_config(
+    const boost::asio::ip::udp::endpoint& the_endpoint,
+    const address_vector& the_groups,
+    const optional_address_v4& the_interface_address,
+    std::size_t the_batch_size,
+    std::size_t the_datagram_size,
+    const optional_int& the_socket_recv_buffer_size)
+  : endpoint(the_endpoint)
+  , groups(the_groups)
+  , interface_address(the_interface_address)
+  , batch_size(the_batch_size)
+  , datagram_size(the_datagram_size)
+  , socket_recv_buffer_size(the_socket_recv_buffer_size)
+{
+  BOOST_ASSERT_MSG(!the_groups.empty(), "groups must not be empty");
+
+  BOOST_ASSERT_MSG(the_batch_size > 0, "batch_size must be > 0");
+
+  BOOST_ASSERT_MSG(the_datagram_size >= packet_header_size,
+      "datagram_size must be >= packet_header_size");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_recv_buffer_size || (*the_socket_recv_buffer_size) >= 0,
+      "Defined socket_recv_buffer_size must be >= 0");
+}
+
+receiver_stats::receiver_stats()
+  : received_packets(0)
+  , received_bytes(0)
+  , receive_calls(0)
+  , queue_overflows(0)
+  , malformed_packets(0)
+  , sequence_gaps(0)
+  , reordered_packets(0)
+  , kernel_drops(0)
+{
+}
+
+receiver::receiver(boost::asio::io_service& io_service,
+    const receiver_config& config, packet_queue& queue)
+  : config_(config)
+  , control_size_(control_size())
+  , io_service_(io_service)
+  , socket_(io_service)
+  , queue_(queue)
+  , stopped_(false)
+  , data_(queue.capacity() * config.datagram_size)
+  , overflow_data_(config.batch_size * config.datagram_size)
+  , overflow_packets_(config.batch_size)
+  , control_(config.batch_size * control_size_)
+  , messages_(config.batch_size)
+  , iovecs_(config.batch_size)
+  , packets_(config.batch_size)
+  , next_sequences_(config.groups.size())
+  , received_packets_(0)
+  , received_bytes_(0)
+  , receive_calls_(0)
+  , queue_overflows_(0)
+  , malformed_packets_(0)
+  , sequence_gaps_(0)
+  , reordered_packets_(0)
+  , kernel_drops_(0)
+{
+  const std::size_t capacity = queue.prepared_size();
+  BOOST_ASSERT_MSG(capacity == queue.capacity(), "Queue has to be empty");
+
+  // Slots keep pointers to the memory when they are consumed and reused
+  for (std::size_t i = 0; i != capacity; ++i)
+  {
+    queue.prepared(i).data = &data_[i * config.datagram_size];
+  }
+  for (std::size_t i = 0; i != config.batch_size; ++i)
+  {
+    overflow_packets_[i].data = &overflow_data_[i * config.datagram_size];
+  }
+}
+
+boost::system::error_code receiver::start()
+{
+  boost::system::error_code error;
+  socket_.open(config_.endpoint.protocol(), error);
+  if (error)
+  {
+    return error;
+  }
+
+  error = apply_socket_options();
+  if (!error)
+  {
+    socket_.bind(config_.endpoint, error);
+  }
+  if (!error)
+  {
+    error = join_groups();
+  }
+  if (!error)
+  {
+    // System calls are made directly and they must not block
+    socket_.non_blocking(true, error);
+  }
+  if (error)
+  {
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    return error;
+  }
+
+  start_wait();
+  return boost::system::error_code();
+}
+
+void receiver::stop()
+{
+  io_service_.post(ma::detail::bind(&this_type::handle_stop, this));
+}
+
+receiver_stats receiver::stats() const
+{
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  receiver_stats stats;
+  stats.received_packets  = received_packets_.load(order);
+  stats.received_bytes    = received_bytes_.load(order);
+  stats.receive_calls     = receive_calls_.load(order);
+  stats.queue_overflows   = queue_overflows_.load(order);
+  stats.malformed_packets = malformed_packets_.load(order);
+  stats.sequence_gaps     = sequence_gaps_.load(order);
+  stats.reordered_packets = reordered_packets_.load(order);
+  stats.kernel_drops      = kernel_drops_.load(order);
+  return stats;
+}
+
+void receiver::handle_wait(const boost::system::error_code& error)
+{
+  if (stopped_)
+  {
+    return;
+  }
+  if (error)
+  {
+    // Readiness of socket can't be waited anymore
+    handle_stop();
+    return;
+  }
+  continue_work();
+}
+
+void receiver::handle_continue()
+{
+  if (stopped_)
+  {
+    return;
+  }
+  continue_work();
+}
+
+void receiver::handle_stop()
+{
+  stopped_ = true;
+  boost::system::error_code ignored;
+  socket_.close(ignored);
+}
+
+void receiver::continue_work()
+{
+  for (std::size_t i = 0; i != max_batches_per_run; ++i)
+  {
+    if (!receive_batch())
+    {
+      if (!stopped_)
+      {
+        start_wait();
+      }
+      return;
+    }
+  }
+  // Socket can still have datagrams which won't be notified about
+  // (edge-triggered demultiplexer), so continue after other handlers
+  start_continue();
+}
+
+bool receiver::receive_batch()
+{
+  // Datagrams are received even if the queue is full to not let
+  // the kernel drop the fresh ones
+  const std::size_t free_slots = queue_.prepared_size();
+  const bool overflow = !free_slots;
+  const std::size_t count = overflow
+      ? config_.batch_size : (std::min)(free_slots, config_.batch_size);
+
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    received_packet* packet =
+        overflow ? &overflow_packets_[i] : &queue_.prepared(i);
+    packets_[i] = packet;
+    iovecs_[i].iov_base = packet->data;
+    iovecs_[i].iov_len  = config_.datagram_size;
+    ::msghdr& header = messages_[i].msg_hdr;
+    header.msg_name       = packet->sender.data();
+    header.msg_namelen    = static_cast< ::socklen_t>(
+        packet->sender.capacity());
+    header.msg_iov        = &iovecs_[i];
+    header.msg_iovlen     = 1;
+    header.msg_control    = &control_[i * control_size_];
+    header.msg_controllen = control_size_;
+    header.msg_flags      = 0;
+  }
+
+  int received;
+  for (;;)
+  {
+    received = ::recvmmsg(socket_.native_handle(), &messages_[0],
+        static_cast<unsigned int>(count), MSG_DONTWAIT, 0);
+    if (received > 0)
+    {
+      break;
+    }
+    const int error = received ? errno : EAGAIN;
+    if (would_block(error))
+    {
+      return false;
+    }
+    if (EINTR == error)
+    {
+      continue;
+    }
+    // Datagrams can't be received anymore
+    handle_stop();
+    return false;
+  }
+
+  std::size_t delivered = 0;
+  boost::uint64_t bytes = 0;
+  boost::uint64_t malformed = 0;
+  boost::uint64_t gaps = 0;
+  boost::uint64_t reordered = 0;
+  for (std::size_t i = 0, size = static_cast<std::size_t>(received);
+      i != size; ++i)
+  {
+    received_packet& packet = *packets_[i];
+    if (!parse_packet(messages_[i], packet))
+    {
+      ++malformed;
+      continue;
+    }
+    bytes += packet.size;
+    track_sequence(packet, gaps, reordered);
+    // Keep delivered packets contiguous. Slots exchange their memory too.
+    if (delivered != i)
+    {
+      std::swap(*packets_[delivered], packet);
+    }
+    ++delivered;
+  }
+
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  if (overflow)
+  {
+    queue_overflows_.fetch_add(delivered, order);
+  }
+  else
+  {
+    queue_.commit(delivered);
+  }
+  receive_calls_.fetch_add(1, order);
+  received_packets_.fetch_add(delivered, order);
+  received_bytes_.fetch_add(bytes, order);
+  if (malformed)
+  {
+    malformed_packets_.fetch_add(malformed, order);
+  }
+  if (gaps)
+  {
+    sequence_gaps_.fetch_add(gaps, order);
+  }
+  if (reordered)
+  {
+    reordered_packets_.fetch_add(reordered, order);
+  }
+  return true;
+}
+
+bool receiver::parse_packet(::mmsghdr& message, received_packet& packet)
+{
+  ::msghdr& header = message.msg_hdr;
+  packet.size = message.msg_len;
+  packet.sender.resize(header.msg_namelen);
+  packet.group = received_packet::unknown_group;
+  packet.receive_time = 0;
+
+  boost::asio::ip::address destination;
+  for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg;
+      cmsg = CMSG_NXTHDR(&header, cmsg))
+  {
+    if ((SOL_SOCKET == cmsg->cmsg_level)
+        && (SCM_TIMESTAMPNS == cmsg->cmsg_type))
+    {
+      ::timespec time;
+      std::memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+      packet.receive_time = to_nanoseconds(time);
+    }
+    else if ((SOL_SOCKET == cmsg->cmsg_level)
+        && (SO_RXQ_OVFL == cmsg->cmsg_type))
+    {
+      // Counter of the socket is attached to each datagram
+      boost::uint32_t drops;
+      std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+      kernel_drops_.store(drops, ma::detail::memory_order_relaxed);
+    }
+    else if ((IPPROTO_IP == cmsg->cmsg_level)
+        && (IP_PKTINFO == cmsg->cmsg_type))
+    {
+      ::in_pktinfo info;
+      std::memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+      destination = boost::asio::ip::address_v4(ntohl(info.ipi_addr.s_addr));
+    }
+    else if ((IPPROTO_IPV6 == cmsg->cmsg_level)
+        && (IPV6_PKTINFO == cmsg->cmsg_type))
+    {
+      ::in6_pktinfo info;
+      std::memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+      boost::asio::ip::address_v6::bytes_type bytes;
+      std::memcpy(bytes.data(), &info.ipi6_addr, bytes.size());
+      destination = boost::asio::ip::address_v6(bytes);
+    }
+  }
+
+  if (!packet.receive_time)
+  {
+    packet.receive_time = current_time();
+  }
+
+  const receiver_config::address_vector::const_iterator group = std::find(
+      config_.groups.begin(), config_.groups.end(), destination);
+  if (group != config_.groups.end())
+  {
+    packet.group = static_cast<std::size_t>(group - config_.groups.begin());
+  }
+
+  if ((header.msg_flags & MSG_TRUNC) || (packet.size < packet_header_size))
+  {
+    return false;
+  }
+
+  const packet_header packet_header = read_packet_header(packet.data);
+  packet.sequence  = packet_header.sequence;
+  packet.send_time = packet_header.send_time;
+  return true;
+}
+
+void receiver::track_sequence(const received_packet& packet,
+    boost::uint64_t& gaps, boost::uint64_t& reordered)
+{
+  if (received_packet::unknown_group == packet.group)
+  {
+    return;
+  }
+  optional_sequence& next_sequence = next_sequences_[packet.group];
+  if (next_sequence)
+  {
+    if (packet.sequence < *next_sequence)
+    {
+      // Duplicated or late datagram, which could be counted as a gap before
+      ++reordered;
+      return;
+    }
+    gaps += packet.sequence - *next_sequence;
+  }
+  next_sequence = packet.sequence + 1;
+}
+
+void receiver::start_wait()
+{
+  socket_.async_receive(boost::asio::null_buffers(),
+      ma::make_custom_alloc_handler(allocator_, ma::detail::bind(
+          &this_type::handle_wait, this, ma::detail::placeholders::_1)));
+}
+
+void receiver::start_continue()
+{
+  io_service_.post(ma::make_custom_alloc_handler(allocator_,
+      ma::detail::bind(&this_type::handle_continue, this)));
+}
+
+boost::system::error_code receiver::apply_socket_options()
+{
+  typedef boost::asio::ip::udp::socket socket_type;
+
+  // Let multiple receivers of the same feed run on the same host
+  {
+    boost::system::error_code error;
+    socket_.set_option(socket_type::reuse_address(true), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (config_.socket_recv_buffer_size)
+  {
+    boost::system::error_code error;
+    socket_type::receive_buffer_size opt(*config_.socket_recv_buffer_size);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  {
+    boost::system::error_code error;
+    socket_.set_option(timestamp_option(true), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  {
+    boost::system::error_code error;
+    socket_.set_option(drop_counter_option(true), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  // Destination address is needed to find out the group of datagram
+  boost::system::error_code error;
+  if (config_.endpoint.address().is_v4())
+  {
+    socket_.set_option(v4_destination_option(true), error);
+  }
+  else
+  {
+    socket_.set_option(v6_destination_option(true), error);
+  }
+  return error;
+}
+
+boost::system::error_code receiver::join_groups()
+{
+  for (receiver_config::address_vector::const_iterator
+      i = config_.groups.begin(), end = config_.groups.end(); i != end; ++i)
+  {
+    boost::system::error_code error;
+    if (i->is_v4() && config_.interface_address)
+    {
+      socket_.set_option(boost::asio::ip::multicast::join_group(
+          i->to_v4(), *config_.interface_address), error);
+    }
+    else
+    {
+      socket_.set_option(boost::asio::ip::multicast::join_group(*i), error);
+    }
+    if (error)
+    {
+      return error;
+    }
+  }
+  return boost::system::error_code();
+}
+
+} // namespace multicast_feed
+} // namespace ma
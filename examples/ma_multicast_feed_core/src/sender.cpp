@@ -0,0 +1,421 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cerrno>
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/multicast_feed/packet.hpp>
+#include <ma/multicast_feed/sender.hpp>
+
+namespace ma {
+namespace multicast_feed {
+
+namespace {
+
+// Number of bursts sent before letting other handlers run
+const std::size_t max_batches_per_run = 16;
+
+bool would_block(int error)
+{
+  return (EAGAIN == error) || (EWOULDBLOCK == error);
+}
+
+} // anonymous namespace
+
+sender_config::sender_config(
+    const endpoint_vector& the_destinations,
+    const optional_address_v4& the_interface_address,
+    int the_hops,
+    bool the_loopback,
+    boost::uint64_t the_rate,
+    std::size_t the_batch_size,
+    std::size_t the_min_payload_size,
+    std::size_t the_max_payload_size,
+    const optional_count& the_packet_count,
+    const optional_int& the_socket_send_buffer_size)
+  : destinations(the_destinations)
+  , interface_address(the_interface_address)
+  , hops(the_hops)
+  , loopback(the_loopback)
+  , rate(the_rate)
+  , batch_size(the_batch_size)
+  , min_payload_size(the_min_payload_size)
+  , max_payload_size(the_max_payload_size)
+  , packet_count(the_packet_count)
+  , socket_send_buffer_size(the_socket_send_buffer_size)
+{
+  BOOST_ASSERT_MSG(!the_destinations.empty(),
+      "destinations must not be empty");
+
+  BOOST_ASSERT_MSG(the_rate > 0, "rate must be > 0");
+
+  BOOST_ASSERT_MSG(the_batch_size > 0, "batch_size must be > 0");
+
+  BOOST_ASSERT_MSG(the_min_payload_size <= the_max_payload_size,
+      "min_payload_size must be <= max_payload_size");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_send_buffer_size || (*the_socket_send_buffer_size) >= 0,
+      "Defined socket_send_buffer_size must be >= 0");
+}
+
+sender_stats::sender_stats()
+  : sent_packets(0)
+  , sent_bytes(0)
+  , send_calls(0)
+  , send_errors(0)
+  , blocked_sends(0)
+  , lag(0)
+{
+}
+
+sender::sender(boost::asio::io_service& io_service,
+    const sender_config& config)
+  : config_(config)
+  , io_service_(io_service)
+  , socket_(io_service)
+  , timer_(io_service)
+  , handler_()
+  , stopped_(false)
+  , start_time_()
+  , next_packet_(0)
+  , random_()
+  , payload_size_(config.min_payload_size, config.max_payload_size)
+  , data_(config.batch_size * (packet_header_size + config.max_payload_size))
+  , messages_(config.batch_size)
+  , iovecs_(config.batch_size)
+  , sent_packets_(0)
+  , sent_bytes_(0)
+  , send_calls_(0)
+  , send_errors_(0)
+  , blocked_sends_(0)
+  , lag_(0)
+{
+  // Payload is the same for all datagrams
+  for (std::size_t i = 0, size = data_.size(); i != size; ++i)
+  {
+    data_[i] = static_cast<char>(i & 0xff);
+  }
+}
+
+boost::system::error_code sender::start(const completion_handler& handler)
+{
+  boost::system::error_code error;
+  socket_.open(config_.destinations.front().protocol(), error);
+  if (error)
+  {
+    return error;
+  }
+
+  error = apply_socket_options();
+  if (!error)
+  {
+    // System calls are made directly and they must not block
+    socket_.non_blocking(true, error);
+  }
+  if (error)
+  {
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    return error;
+  }
+
+  handler_ = handler;
+  start_time_ = time_traits_type::now();
+  start_continue();
+  return boost::system::error_code();
+}
+
+void sender::stop()
+{
+  io_service_.post(ma::detail::bind(&this_type::handle_stop, this));
+}
+
+sender_stats sender::stats() const
+{
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  sender_stats stats;
+  stats.sent_packets  = sent_packets_.load(order);
+  stats.sent_bytes    = sent_bytes_.load(order);
+  stats.send_calls    = send_calls_.load(order);
+  stats.send_errors   = send_errors_.load(order);
+  stats.blocked_sends = blocked_sends_.load(order);
+  stats.lag           = lag_.load(order);
+  return stats;
+}
+
+void sender::handle_timer(const boost::system::error_code& error)
+{
+  if (stopped_ || (boost::asio::error::operation_aborted == error))
+  {
+    return;
+  }
+  continue_work();
+}
+
+void sender::handle_write_wait(const boost::system::error_code& error)
+{
+  if (stopped_)
+  {
+    return;
+  }
+  if (error)
+  {
+    complete(error);
+    return;
+  }
+  continue_work();
+}
+
+void sender::handle_continue()
+{
+  if (stopped_)
+  {
+    return;
+  }
+  continue_work();
+}
+
+void sender::handle_stop()
+{
+  stopped_ = true;
+  boost::system::error_code ignored;
+  socket_.close(ignored);
+  timer_.cancel(ignored);
+}
+
+void sender::continue_work()
+{
+  for (std::size_t i = 0; i != max_batches_per_run; ++i)
+  {
+    const boost::uint64_t remaining = remaining_packets();
+    if (!remaining)
+    {
+      complete(boost::system::error_code());
+      return;
+    }
+
+    // Send full bursts only (except the last one)
+    const std::size_t burst = static_cast<std::size_t>(
+        (std::min)(static_cast<boost::uint64_t>(config_.batch_size),
+            remaining));
+    const boost::uint64_t due = due_packets(time_traits_type::now());
+    if (due < next_packet_ + burst)
+    {
+      lag_.store(0, ma::detail::memory_order_relaxed);
+      start_timer(next_packet_ + burst);
+      return;
+    }
+
+    prepare_batch(burst);
+    if (!send_batch(burst))
+    {
+      start_write_wait();
+      return;
+    }
+    lag_.store(due - next_packet_, ma::detail::memory_order_relaxed);
+  }
+  // Sender is behind the schedule, so continue after other handlers
+  start_continue();
+}
+
+boost::uint64_t sender::due_packets(const time_type& time) const
+{
+  const boost::int64_t elapsed = time_traits_type::to_posix_duration(
+      time_traits_type::subtract(time, start_time_)).total_microseconds();
+  if (elapsed <= 0)
+  {
+    return 0;
+  }
+  return static_cast<boost::uint64_t>(
+      static_cast<double>(elapsed) * config_.rate / 1000000);
+}
+
+boost::uint64_t sender::remaining_packets() const
+{
+  if (!config_.packet_count)
+  {
+    return config_.batch_size;
+  }
+  return *config_.packet_count - next_packet_;
+}
+
+void sender::prepare_batch(std::size_t count)
+{
+  const std::size_t slot_size = packet_header_size + config_.max_payload_size;
+  const std::size_t group_count = config_.destinations.size();
+  const boost::uint64_t send_time = current_time();
+  for (std::size_t i = 0; i != count; ++i)
+  {
+    // Datagrams are sent to the groups in turn
+    const boost::uint64_t packet = next_packet_ + i;
+    const boost::asio::ip::udp::endpoint& destination =
+        config_.destinations[static_cast<std::size_t>(packet % group_count)];
+    char* data = &data_[i * slot_size];
+    write_packet_header(packet_header(packet / group_count, send_time), data);
+
+    iovecs_[i].iov_base = data;
+    iovecs_[i].iov_len  = packet_header_size + payload_size_(random_);
+    ::msghdr& header = messages_[i].msg_hdr;
+    header.msg_name       = const_cast< ::sockaddr*>(destination.data());
+    header.msg_namelen    = static_cast< ::socklen_t>(destination.size());
+    header.msg_iov        = &iovecs_[i];
+    header.msg_iovlen     = 1;
+    header.msg_control    = 0;
+    header.msg_controllen = 0;
+    header.msg_flags      = 0;
+  }
+}
+
+bool sender::send_batch(std::size_t count)
+{
+  std::size_t begin = 0;
+  boost::uint64_t calls = 0;
+  boost::uint64_t bytes = 0;
+  boost::uint64_t errors = 0;
+  bool completed = true;
+  while (begin != count)
+  {
+    const int result = ::sendmmsg(socket_.native_handle(), &messages_[begin],
+        static_cast<unsigned int>(count - begin), MSG_DONTWAIT);
+    if (result > 0)
+    {
+      ++calls;
+      for (std::size_t end = begin + static_cast<std::size_t>(result);
+          begin != end; ++begin)
+      {
+        bytes += iovecs_[begin].iov_len;
+      }
+      continue;
+    }
+    const int error = result ? errno : EAGAIN;
+    if (would_block(error))
+    {
+      completed = false;
+      break;
+    }
+    if (EINTR == error)
+    {
+      continue;
+    }
+    // Datagram can't be sent (f.e. ENOBUFS), so skip it. Receivers will see
+    // the gap in sequence numbers.
+    ++errors;
+    ++begin;
+  }
+
+  // Datagrams which weren't sent are prepared again with the same sequence
+  // numbers but with a fresh send time
+  next_packet_ += begin;
+
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  if (calls)
+  {
+    send_calls_.fetch_add(calls, order);
+    sent_packets_.fetch_add(begin - errors, order);
+    sent_bytes_.fetch_add(bytes, order);
+  }
+  if (errors)
+  {
+    send_errors_.fetch_add(errors, order);
+  }
+  if (!completed)
+  {
+    blocked_sends_.fetch_add(1, order);
+  }
+  return completed;
+}
+
+void sender::start_timer(boost::uint64_t due_packets)
+{
+  // Time when the given number of datagrams becomes due
+  const boost::uint64_t delay = static_cast<boost::uint64_t>(
+      static_cast<double>(due_packets) * 1000000 / config_.rate) + 1;
+  timer_.expires_at(time_traits_type::add(start_time_,
+      ma::to_steady_deadline_timer_duration(boost::posix_time::microseconds(
+          static_cast<boost::int64_t>(delay)))));
+  timer_.async_wait(ma::make_custom_alloc_handler(timer_allocator_,
+      ma::detail::bind(&this_type::handle_timer, this,
+          ma::detail::placeholders::_1)));
+}
+
+void sender::start_write_wait()
+{
+  socket_.async_send(boost::asio::null_buffers(),
+      ma::make_custom_alloc_handler(write_allocator_, ma::detail::bind(
+          &this_type::handle_write_wait, this, ma::detail::placeholders::_1)));
+}
+
+void sender::start_continue()
+{
+  io_service_.post(ma::make_custom_alloc_handler(write_allocator_,
+      ma::detail::bind(&this_type::handle_continue, this)));
+}
+
+void sender::complete(const boost::system::error_code& error)
+{
+  handle_stop();
+  if (handler_)
+  {
+    const completion_handler handler = handler_;
+    handler_ = completion_handler();
+    handler(error);
+  }
+}
+
+boost::system::error_code sender::apply_socket_options()
+{
+  typedef boost::asio::ip::udp::socket socket_type;
+
+  if (config_.socket_send_buffer_size)
+  {
+    boost::system::error_code error;
+    socket_type::send_buffer_size opt(*config_.socket_send_buffer_size);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  {
+    boost::system::error_code error;
+    socket_.set_option(boost::asio::ip::multicast::hops(config_.hops), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  {
+    boost::system::error_code error;
+    socket_.set_option(
+        boost::asio::ip::multicast::enable_loopback(config_.loopback), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (config_.interface_address)
+  {
+    boost::system::error_code error;
+    socket_.set_option(boost::asio::ip::multicast::outbound_interface(
+        *config_.interface_address), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  return boost::system::error_code();
+}
+
+} // namespace multicast_feed
+} // namespace ma
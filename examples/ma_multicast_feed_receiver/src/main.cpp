@@ -0,0 +1,602 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <exception>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <ma/config.hpp>
+#include <ma/io_context_helpers.hpp>
+#include <ma/console_close_signal.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/thread_group.hpp>
+#include <ma/multicast_feed/packet.hpp>
+#include <ma/multicast_feed/receiver.hpp>
+#include <ma/detail/atomic.hpp>
+#include <ma/detail/functional.hpp>
+#include <ma/detail/thread.hpp>
+
+namespace {
+
+typedef ma::detail::atomic<boost::uint64_t> atomic_counter;
+
+const char* help_option_name             = "help";
+const char* port_option_name             = "port";
+const char* group_option_name            = "group";
+const char* listen_address_option_name   = "listen-address";
+const char* interface_option_name        = "interface";
+const char* batch_option_name            = "batch";
+const char* datagram_size_option_name    = "datagram-size";
+const char* queue_option_name            = "queue";
+const char* sock_recv_buffer_option_name = "sock-recv-buffer";
+const char* stats_interval_option_name   = "stats-interval";
+const std::string default_system_value   = "system default";
+
+// Number of checks of empty queue before consumer yields
+const std::size_t consumer_spin_count = 1000;
+
+template <typename Value>
+void validate_option(const std::string& option_name, const Value& option_value,
+    const Value& min, const Value& max = (std::numeric_limits<Value>::max)())
+{
+  if ((option_value < min) || (option_value > max))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(), option_name));
+  }
+}
+
+template <typename Value>
+std::string to_string(const boost::optional<Value>& value,
+    const std::string& default_text)
+{
+  if (value)
+  {
+    return boost::lexical_cast<std::string>(*value);
+  }
+  return default_text;
+}
+
+boost::program_options::options_description build_cmd_options_description()
+{
+  boost::program_options::options_description description("Allowed options");
+  description.add_options()
+    (
+      help_option_name,
+      "produce help message"
+    )
+    (
+      port_option_name,
+      boost::program_options::value<unsigned short>(),
+      "set the UDP port number of the feed"
+    )
+    (
+      group_option_name,
+      boost::program_options::value<std::vector<std::string> >(),
+      "add multicast group to join (IPv4 or IPv6), can be repeated"
+    )
+    (
+      listen_address_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          boost::asio::ip::address_v4::any().to_string()),
+      "set the UDP address to bind to (IPv4 or IPv6)"
+    )
+    (
+      interface_option_name,
+      boost::program_options::value<std::string>(),
+      "set the IPv4 address of local interface to join groups on" \
+          " (f.e. 127.0.0.1 for loopback)"
+    )
+    (
+      batch_option_name,
+      boost::program_options::value<std::size_t>()->default_value(64),
+      "set the maximum number of datagrams received by single system call"
+    )
+    (
+      datagram_size_option_name,
+      boost::program_options::value<std::size_t>()->default_value(2048),
+      "set the maximum size of received datagram"
+    )
+    (
+      queue_option_name,
+      boost::program_options::value<std::size_t>()->default_value(65536),
+      "set the number of slots of the queue between receiver and consumer"
+    )
+    (
+      sock_recv_buffer_option_name,
+      boost::program_options::value<int>(),
+      "set the size of socket receive buffer"
+    )
+    (
+      stats_interval_option_name,
+      boost::program_options::value<long>()->default_value(1000),
+      "set the interval (milliseconds) of printing statistics"
+    );
+  return description;
+}
+
+ma::multicast_feed::receiver_config build_receiver_config(
+    const boost::program_options::variables_map& options_values)
+{
+  typedef ma::multicast_feed::receiver_config config_type;
+
+  const unsigned short port =
+      options_values[port_option_name].as<unsigned short>();
+  const boost::asio::ip::address listen_address =
+      boost::asio::ip::address::from_string(
+          options_values[listen_address_option_name].as<std::string>());
+
+  config_type::address_vector groups;
+  const std::vector<std::string>& group_strs =
+      options_values[group_option_name].as<std::vector<std::string> >();
+  for (std::vector<std::string>::const_iterator i = group_strs.begin(),
+      end = group_strs.end(); i != end; ++i)
+  {
+    const boost::asio::ip::address group =
+        boost::asio::ip::address::from_string(*i);
+    if (!group.is_multicast()
+        || (group.is_v4() != listen_address.is_v4()))
+    {
+      using boost::program_options::validation_error;
+      boost::throw_exception(validation_error(
+          validation_error::invalid_option_value, std::string(),
+          group_option_name));
+    }
+    groups.push_back(group);
+  }
+
+  config_type::optional_address_v4 interface_address;
+  if (options_values.count(interface_option_name))
+  {
+    interface_address = boost::asio::ip::address_v4::from_string(
+        options_values[interface_option_name].as<std::string>());
+  }
+
+  const std::size_t batch_size =
+      options_values[batch_option_name].as<std::size_t>();
+  // UIO_MAXIOV is the limit of recvmmsg
+  validate_option<std::size_t>(batch_option_name, batch_size, 1, 1024);
+
+  const std::size_t datagram_size =
+      options_values[datagram_size_option_name].as<std::size_t>();
+  validate_option<std::size_t>(datagram_size_option_name, datagram_size,
+      ma::multicast_feed::packet_header_size, 65535);
+
+  config_type::optional_int socket_recv_buffer_size;
+  if (options_values.count(sock_recv_buffer_option_name))
+  {
+    const int buffer_size =
+        options_values[sock_recv_buffer_option_name].as<int>();
+    validate_option<int>(sock_recv_buffer_option_name, buffer_size, 0);
+    socket_recv_buffer_size = buffer_size;
+  }
+
+  return config_type(boost::asio::ip::udp::endpoint(listen_address, port),
+      groups, interface_address, batch_size, datagram_size,
+      socket_recv_buffer_size);
+}
+
+std::size_t read_queue_capacity(
+    const boost::program_options::variables_map& options_values)
+{
+  const std::size_t capacity =
+      options_values[queue_option_name].as<std::size_t>();
+  validate_option<std::size_t>(queue_option_name, capacity, 1, 1 << 24);
+  return capacity;
+}
+
+boost::posix_time::time_duration read_stats_interval(
+    const boost::program_options::variables_map& options_values)
+{
+  const long interval = options_values[stats_interval_option_name].as<long>();
+  validate_option<long>(stats_interval_option_name, interval, 1);
+  return boost::posix_time::milliseconds(interval);
+}
+
+void print_config(std::ostream& stream, std::size_t queue_capacity,
+    const boost::posix_time::time_duration& stats_interval,
+    const ma::multicast_feed::receiver_config& config)
+{
+  stream << "Endpoint              : " << config.endpoint
+         << std::endl
+         << "Groups                : ";
+  for (ma::multicast_feed::receiver_config::address_vector::const_iterator
+      i = config.groups.begin(), end = config.groups.end(); i != end; ++i)
+  {
+    stream << (i == config.groups.begin() ? "" : ", ") << *i;
+  }
+  stream << std::endl
+         << "Interface             : "
+         << to_string(config.interface_address, default_system_value)
+         << std::endl
+         << "Batch size            : " << config.batch_size
+         << std::endl
+         << "Max datagram size     : " << config.datagram_size
+         << std::endl
+         << "Queue capacity        : " << queue_capacity
+         << std::endl
+         << "Socket receive buffer : "
+         << to_string(config.socket_recv_buffer_size, default_system_value)
+         << std::endl
+         << "Statistics interval   : " << stats_interval
+         << std::endl;
+}
+
+struct consumer_stats
+{
+  consumer_stats()
+    : consumed_packets(0)
+    , wire_latency(0)
+    , queue_latency(0)
+  {
+  }
+
+  boost::uint64_t consumed_packets;
+  /// Sum of (receive_time - send_time) in nanoseconds.
+  boost::uint64_t wire_latency;
+  /// Sum of (consume time - receive_time) in nanoseconds.
+  boost::uint64_t queue_latency;
+}; // struct consumer_stats
+
+/// Consumer of the queue which just accounts latencies of datagrams.
+class packet_consumer : private boost::noncopyable
+{
+public:
+  explicit packet_consumer(ma::multicast_feed::packet_queue& queue)
+    : queue_(queue)
+    , stopped_(false)
+    , consumed_packets_(0)
+    , wire_latency_(0)
+    , queue_latency_(0)
+  {
+  }
+
+  void run()
+  {
+    const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+    std::size_t idle_count = 0;
+    while (!stopped_.load(order))
+    {
+      const std::size_t size = queue_.size();
+      if (!size)
+      {
+        if (++idle_count > consumer_spin_count)
+        {
+          ma::detail::this_thread::yield();
+        }
+        continue;
+      }
+      idle_count = 0;
+
+      const boost::uint64_t now = ma::multicast_feed::current_time();
+      boost::uint64_t wire_latency = 0;
+      boost::uint64_t queue_latency = 0;
+      for (std::size_t i = 0; i != size; ++i)
+      {
+        const ma::multicast_feed::received_packet& packet = queue_.front(i);
+        wire_latency  += latency(packet.send_time, packet.receive_time);
+        queue_latency += latency(packet.receive_time, now);
+      }
+      queue_.consume(size);
+
+      consumed_packets_.fetch_add(size, order);
+      wire_latency_.fetch_add(wire_latency, order);
+      queue_latency_.fetch_add(queue_latency, order);
+    }
+  }
+
+  /// Thread-safe.
+  void stop()
+  {
+    stopped_.store(true, ma::detail::memory_order_relaxed);
+  }
+
+  /// Thread-safe.
+  consumer_stats stats() const
+  {
+    const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+    consumer_stats stats;
+    stats.consumed_packets = consumed_packets_.load(order);
+    stats.wire_latency     = wire_latency_.load(order);
+    stats.queue_latency    = queue_latency_.load(order);
+    return stats;
+  }
+
+private:
+  static boost::uint64_t latency(boost::uint64_t from, boost::uint64_t to)
+  {
+    // Clocks of sender and receiver may differ
+    return to > from ? to - from : 0;
+  }
+
+  ma::multicast_feed::packet_queue& queue_;
+  ma::detail::atomic<bool> stopped_;
+  atomic_counter consumed_packets_;
+  atomic_counter wire_latency_;
+  atomic_counter queue_latency_;
+}; // class packet_consumer
+
+double counter_rate(boost::uint64_t delta,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::int64_t elapsed_us = elapsed.total_microseconds();
+  if (elapsed_us <= 0)
+  {
+    return 0;
+  }
+  return static_cast<double>(delta) * 1000000 / elapsed_us;
+}
+
+double average_us(boost::uint64_t sum_ns, boost::uint64_t count)
+{
+  if (!count)
+  {
+    return 0;
+  }
+  return static_cast<double>(sum_ns) / count / 1000;
+}
+
+void print_counter_sample(std::ostream& stream, const char* name,
+    boost::uint64_t prev, boost::uint64_t current,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uint64_t delta = current - prev;
+  stream << ", " << name << " +" << delta
+         << " (" << counter_rate(delta, elapsed) << "/s)";
+}
+
+void print_stats_sample(std::ostream& stream,
+    const ma::multicast_feed::receiver_stats& prev_stats,
+    const ma::multicast_feed::receiver_stats& stats,
+    const consumer_stats& prev_consumer_stats,
+    const consumer_stats& consumer_stats,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uint64_t consumed =
+      consumer_stats.consumed_packets - prev_consumer_stats.consumed_packets;
+
+  // Build the whole line at once to not mix it with output of other handlers
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1)
+       << "Stats for last " << elapsed.total_milliseconds() << " ms";
+  print_counter_sample(line, "received",
+      prev_stats.received_packets, stats.received_packets, elapsed);
+  print_counter_sample(line, "consumed",
+      prev_consumer_stats.consumed_packets, consumer_stats.consumed_packets,
+      elapsed);
+  line << ", gaps +" << stats.sequence_gaps - prev_stats.sequence_gaps
+       << ", reordered +"
+       << stats.reordered_packets - prev_stats.reordered_packets
+       << ", queue overflows +"
+       << stats.queue_overflows - prev_stats.queue_overflows
+       << ", kernel drops +" << stats.kernel_drops - prev_stats.kernel_drops
+       << ", malformed +"
+       << stats.malformed_packets - prev_stats.malformed_packets
+       << ", avg wire latency " << average_us(
+           consumer_stats.wire_latency - prev_consumer_stats.wire_latency,
+           consumed) << " us"
+       << ", avg queue latency " << average_us(
+           consumer_stats.queue_latency - prev_consumer_stats.queue_latency,
+           consumed) << " us";
+  stream << line.str() << std::endl;
+}
+
+void print_stats(const ma::multicast_feed::receiver_stats& stats,
+    const consumer_stats& consumer_stats)
+{
+  std::cout << "Received datagrams  : " << stats.received_packets
+            << std::endl
+            << "Received bytes      : " << stats.received_bytes
+            << std::endl
+            << "recvmmsg calls      : " << stats.receive_calls
+            << std::endl
+            << "Consumed datagrams  : " << consumer_stats.consumed_packets
+            << std::endl
+            << "Sequence gaps       : " << stats.sequence_gaps
+            << std::endl
+            << "Reordered datagrams : " << stats.reordered_packets
+            << std::endl
+            << "Queue overflows     : " << stats.queue_overflows
+            << std::endl
+            << "Kernel drops        : " << stats.kernel_drops
+            << std::endl
+            << "Malformed datagrams : " << stats.malformed_packets
+            << std::endl;
+}
+
+struct execution_context : private boost::noncopyable
+{
+public:
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+
+  execution_context(ma::multicast_feed::receiver& the_receiver,
+      packet_consumer& the_consumer,
+      const boost::posix_time::time_duration& the_stats_interval,
+      ma::steady_deadline_timer& the_stats_timer)
+    : receiver(the_receiver)
+    , consumer(the_consumer)
+    , stats_interval(the_stats_interval)
+    , stats_timer(the_stats_timer)
+    , stopped(false)
+    , last_stats()
+    , last_consumer_stats()
+    , last_stats_time(time_traits_type::now())
+  {
+  }
+
+  ma::multicast_feed::receiver& receiver;
+  packet_consumer&              consumer;
+  const boost::posix_time::time_duration stats_interval;
+  ma::steady_deadline_timer&    stats_timer;
+  bool stopped;
+  ma::multicast_feed::receiver_stats last_stats;
+  consumer_stats last_consumer_stats;
+  time_type last_stats_time;
+}; // struct execution_context
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error);
+
+void start_stats_timer(execution_context& context)
+{
+  namespace detail = ma::detail;
+
+  context.stats_timer.expires_from_now(
+      ma::to_steady_deadline_timer_duration(context.stats_interval));
+  context.stats_timer.async_wait(detail::bind(handle_stats_timer,
+      detail::ref(context), detail::placeholders::_1));
+}
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error)
+{
+  typedef execution_context::time_traits_type time_traits_type;
+
+  if ((boost::asio::error::operation_aborted == error) || context.stopped)
+  {
+    return;
+  }
+
+  const ma::multicast_feed::receiver_stats stats = context.receiver.stats();
+  const consumer_stats the_consumer_stats = context.consumer.stats();
+  const execution_context::time_type now = time_traits_type::now();
+  print_stats_sample(std::cout, context.last_stats, stats,
+      context.last_consumer_stats, the_consumer_stats,
+      time_traits_type::to_posix_duration(
+          time_traits_type::subtract(now, context.last_stats_time)));
+  context.last_stats = stats;
+  context.last_consumer_stats = the_consumer_stats;
+  context.last_stats_time = now;
+  start_stats_timer(context);
+}
+
+void handle_app_exit(execution_context& context)
+{
+  std::cout << "Application exit request detected." << std::endl;
+  context.stopped = true;
+  boost::system::error_code ignored;
+  context.stats_timer.cancel(ignored);
+  context.receiver.stop();
+  context.consumer.stop();
+}
+
+int run_receiver(std::size_t queue_capacity,
+    const boost::posix_time::time_duration& stats_interval,
+    const ma::multicast_feed::receiver_config& config)
+{
+  namespace detail = ma::detail;
+
+  ma::multicast_feed::packet_queue queue(queue_capacity);
+  boost::asio::io_service receiver_io_service(
+      ma::to_io_context_concurrency_hint(1));
+  ma::multicast_feed::receiver receiver(receiver_io_service, config, queue);
+  packet_consumer the_consumer(queue);
+
+  if (boost::system::error_code error = receiver.start())
+  {
+    std::cout << "Receiver can't start due to error: "
+              << error.message() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  boost::asio::io_service   event_loop(ma::to_io_context_concurrency_hint(1));
+  ma::steady_deadline_timer stats_timer(event_loop);
+  ma::console_close_signal  close_signal(event_loop);
+  execution_context context(receiver, the_consumer, stats_interval,
+      stats_timer);
+
+  // Wait for console close
+  std::cout << "Press Ctrl+C to exit." << std::endl;
+  close_signal.async_wait(detail::bind(handle_app_exit, detail::ref(context)));
+  start_stats_timer(context);
+
+  // Receiver (producer) and consumer of the queue run in their own threads
+  ma::thread_group work_threads;
+  typedef std::size_t (boost::asio::io_service::*run_func)();
+  work_threads.create_thread(detail::bind(
+      static_cast<run_func>(&boost::asio::io_service::run),
+      &receiver_io_service));
+  work_threads.create_thread(detail::bind(&packet_consumer::run, &the_consumer));
+  std::cout << "Receiver has started." << std::endl;
+
+  event_loop.run();
+
+  std::cout << "Waiting until work threads stop." << std::endl;
+  work_threads.join_all();
+  std::cout << "Work threads have stopped." << std::endl;
+
+  print_stats(receiver.stats(), the_consumer.stats());
+  return EXIT_SUCCESS;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    const boost::program_options::options_description
+        cmd_options_description = build_cmd_options_description();
+
+    boost::program_options::variables_map cmd_options;
+    boost::program_options::store(boost::program_options::parse_command_line(
+        argc, argv, cmd_options_description), cmd_options);
+    boost::program_options::notify(cmd_options);
+
+    if (cmd_options.count(help_option_name))
+    {
+      std::cout << cmd_options_description;
+      return EXIT_SUCCESS;
+    }
+
+    if (!cmd_options.count(port_option_name)
+        || !cmd_options.count(group_option_name))
+    {
+      std::cout << "Required options not specified" << std::endl
+                << cmd_options_description;
+      return EXIT_FAILURE;
+    }
+
+    const std::size_t queue_capacity = read_queue_capacity(cmd_options);
+    const boost::posix_time::time_duration stats_interval =
+        read_stats_interval(cmd_options);
+    const ma::multicast_feed::receiver_config config =
+        build_receiver_config(cmd_options);
+
+    print_config(std::cout, queue_capacity, stats_interval, config);
+
+    return run_receiver(queue_capacity, stats_interval, config);
+  }
+  catch (const boost::program_options::error& e)
+  {
+    std::cerr << "Error reading options: " << e.what() << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Unexpected error: " << e.what() << std::endl;
+  }
+  catch (...)
+  {
+    std::cerr << "Unknown error" << std::endl;
+  }
+  return EXIT_FAILURE;
+}
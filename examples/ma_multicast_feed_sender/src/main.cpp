@@ -0,0 +1,539 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <exception>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <ma/config.hpp>
+#include <ma/io_context_helpers.hpp>
+#include <ma/console_close_signal.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/multicast_feed/packet.hpp>
+#include <ma/multicast_feed/sender.hpp>
+#include <ma/detail/functional.hpp>
+
+namespace {
+
+const char* help_option_name             = "help";
+const char* port_option_name             = "port";
+const char* group_option_name            = "group";
+const char* interface_option_name        = "interface";
+const char* ttl_option_name              = "ttl";
+const char* loopback_option_name         = "loopback";
+const char* rate_option_name             = "rate";
+const char* batch_option_name            = "batch";
+const char* payload_size_option_name     = "payload-size";
+const char* max_payload_size_option_name = "max-payload-size";
+const char* count_option_name            = "count";
+const char* sock_send_buffer_option_name = "sock-send-buffer";
+const char* stats_interval_option_name   = "stats-interval";
+const std::string default_system_value   = "system default";
+
+// Max size of UDP payload (IPv4)
+const std::size_t max_datagram_size = 65507;
+
+template <typename Value>
+void validate_option(const std::string& option_name, const Value& option_value,
+    const Value& min, const Value& max = (std::numeric_limits<Value>::max)())
+{
+  if ((option_value < min) || (option_value > max))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(), option_name));
+  }
+}
+
+template <typename Value>
+std::string to_string(const boost::optional<Value>& value,
+    const std::string& default_text)
+{
+  if (value)
+  {
+    return boost::lexical_cast<std::string>(*value);
+  }
+  return default_text;
+}
+
+std::string to_string(bool value)
+{
+  if (value)
+  {
+    return "on";
+  }
+  return "off";
+}
+
+boost::program_options::options_description build_cmd_options_description()
+{
+  boost::program_options::options_description description("Allowed options");
+  description.add_options()
+    (
+      help_option_name,
+      "produce help message"
+    )
+    (
+      port_option_name,
+      boost::program_options::value<unsigned short>(),
+      "set the UDP port number of the feed"
+    )
+    (
+      group_option_name,
+      boost::program_options::value<std::vector<std::string> >(),
+      "add multicast group to send to (IPv4 or IPv6), can be repeated." \
+          " Datagrams are sent to the groups in turn"
+    )
+    (
+      interface_option_name,
+      boost::program_options::value<std::string>(),
+      "set the IPv4 address of local interface to send from" \
+          " (f.e. 127.0.0.1 for loopback)"
+    )
+    (
+      ttl_option_name,
+      boost::program_options::value<int>()->default_value(1),
+      "set the TTL (hop limit) of datagrams"
+    )
+    (
+      loopback_option_name,
+      boost::program_options::value<bool>()->default_value(true),
+      "deliver datagrams to the receivers on the same host"
+    )
+    (
+      rate_option_name,
+      boost::program_options::value<boost::uint64_t>()->default_value(100000),
+      "set the target number of datagrams per second (for all groups)"
+    )
+    (
+      batch_option_name,
+      boost::program_options::value<std::size_t>()->default_value(64),
+      "set the number of datagrams sent by single system call (burst)"
+    )
+    (
+      payload_size_option_name,
+      boost::program_options::value<std::size_t>()->default_value(64),
+      "set the size of datagram payload following the header" \
+          " (the minimum one if max-payload-size is specified)"
+    )
+    (
+      max_payload_size_option_name,
+      boost::program_options::value<std::size_t>(),
+      "set the maximum size of datagram payload, sizes are chosen uniformly" \
+          " between payload-size and this one"
+    )
+    (
+      count_option_name,
+      boost::program_options::value<boost::uint64_t>(),
+      "set the number of datagrams to send, unlimited if not specified"
+    )
+    (
+      sock_send_buffer_option_name,
+      boost::program_options::value<int>(),
+      "set the size of socket send buffer"
+    )
+    (
+      stats_interval_option_name,
+      boost::program_options::value<long>()->default_value(1000),
+      "set the interval (milliseconds) of printing statistics"
+    );
+  return description;
+}
+
+ma::multicast_feed::sender_config build_sender_config(
+    const boost::program_options::variables_map& options_values)
+{
+  typedef ma::multicast_feed::sender_config config_type;
+  using boost::program_options::validation_error;
+
+  const unsigned short port =
+      options_values[port_option_name].as<unsigned short>();
+
+  config_type::endpoint_vector destinations;
+  const std::vector<std::string>& group_strs =
+      options_values[group_option_name].as<std::vector<std::string> >();
+  for (std::vector<std::string>::const_iterator i = group_strs.begin(),
+      end = group_strs.end(); i != end; ++i)
+  {
+    const boost::asio::ip::address group =
+        boost::asio::ip::address::from_string(*i);
+    if (!group.is_multicast() || (!destinations.empty()
+        && (group.is_v4() != destinations.front().address().is_v4())))
+    {
+      boost::throw_exception(validation_error(
+          validation_error::invalid_option_value, std::string(),
+          group_option_name));
+    }
+    destinations.push_back(boost::asio::ip::udp::endpoint(group, port));
+  }
+
+  config_type::optional_address_v4 interface_address;
+  if (options_values.count(interface_option_name))
+  {
+    interface_address = boost::asio::ip::address_v4::from_string(
+        options_values[interface_option_name].as<std::string>());
+  }
+
+  const int hops = options_values[ttl_option_name].as<int>();
+  validate_option<int>(ttl_option_name, hops, 0, 255);
+
+  const bool loopback = options_values[loopback_option_name].as<bool>();
+
+  const boost::uint64_t rate =
+      options_values[rate_option_name].as<boost::uint64_t>();
+  validate_option<boost::uint64_t>(rate_option_name, rate, 1);
+
+  const std::size_t batch_size =
+      options_values[batch_option_name].as<std::size_t>();
+  // UIO_MAXIOV is the limit of sendmmsg
+  validate_option<std::size_t>(batch_option_name, batch_size, 1, 1024);
+
+  const std::size_t max_payload_size =
+      max_datagram_size - ma::multicast_feed::packet_header_size;
+  const std::size_t min_payload =
+      options_values[payload_size_option_name].as<std::size_t>();
+  validate_option<std::size_t>(payload_size_option_name, min_payload, 0,
+      max_payload_size);
+  std::size_t max_payload = min_payload;
+  if (options_values.count(max_payload_size_option_name))
+  {
+    max_payload = options_values[max_payload_size_option_name]
+        .as<std::size_t>();
+    validate_option<std::size_t>(max_payload_size_option_name, max_payload,
+        min_payload, max_payload_size);
+  }
+
+  config_type::optional_count packet_count;
+  if (options_values.count(count_option_name))
+  {
+    packet_count = options_values[count_option_name].as<boost::uint64_t>();
+    validate_option<boost::uint64_t>(count_option_name, *packet_count, 1);
+  }
+
+  config_type::optional_int socket_send_buffer_size;
+  if (options_values.count(sock_send_buffer_option_name))
+  {
+    const int buffer_size =
+        options_values[sock_send_buffer_option_name].as<int>();
+    validate_option<int>(sock_send_buffer_option_name, buffer_size, 0);
+    socket_send_buffer_size = buffer_size;
+  }
+
+  return config_type(destinations, interface_address, hops, loopback, rate,
+      batch_size, min_payload, max_payload, packet_count,
+      socket_send_buffer_size);
+}
+
+boost::posix_time::time_duration read_stats_interval(
+    const boost::program_options::variables_map& options_values)
+{
+  const long interval = options_values[stats_interval_option_name].as<long>();
+  validate_option<long>(stats_interval_option_name, interval, 1);
+  return boost::posix_time::milliseconds(interval);
+}
+
+void print_config(std::ostream& stream,
+    const boost::posix_time::time_duration& stats_interval,
+    const ma::multicast_feed::sender_config& config)
+{
+  stream << "Destinations         : ";
+  for (ma::multicast_feed::sender_config::endpoint_vector::const_iterator
+      i = config.destinations.begin(), end = config.destinations.end();
+      i != end; ++i)
+  {
+    stream << (i == config.destinations.begin() ? "" : ", ") << *i;
+  }
+  stream << std::endl
+         << "Interface            : "
+         << to_string(config.interface_address, default_system_value)
+         << std::endl
+         << "TTL                  : " << config.hops
+         << std::endl
+         << "Loopback             : " << to_string(config.loopback)
+         << std::endl
+         << "Target rate          : " << config.rate << " datagrams/s"
+         << std::endl
+         << "Burst size           : " << config.batch_size
+         << std::endl
+         << "Payload size         : " << config.min_payload_size;
+  if (config.max_payload_size != config.min_payload_size)
+  {
+    stream << " - " << config.max_payload_size;
+  }
+  stream << std::endl
+         << "Number of datagrams  : "
+         << to_string(config.packet_count, "unlimited")
+         << std::endl
+         << "Socket send buffer   : "
+         << to_string(config.socket_send_buffer_size, default_system_value)
+         << std::endl
+         << "Statistics interval  : " << stats_interval
+         << std::endl;
+}
+
+double counter_rate(boost::uint64_t delta,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::int64_t elapsed_us = elapsed.total_microseconds();
+  if (elapsed_us <= 0)
+  {
+    return 0;
+  }
+  return static_cast<double>(delta) * 1000000 / elapsed_us;
+}
+
+void print_counter_sample(std::ostream& stream, const char* name,
+    boost::uint64_t prev, boost::uint64_t current,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uint64_t delta = current - prev;
+  stream << ", " << name << " +" << delta
+         << " (" << counter_rate(delta, elapsed) << "/s)";
+}
+
+void print_stats_sample(std::ostream& stream,
+    const ma::multicast_feed::sender_stats& prev_stats,
+    const ma::multicast_feed::sender_stats& stats,
+    const boost::posix_time::time_duration& elapsed)
+{
+  // Build the whole line at once to not mix it with output of other handlers
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1)
+       << "Stats for last " << elapsed.total_milliseconds() << " ms";
+  print_counter_sample(line, "sent",
+      prev_stats.sent_packets, stats.sent_packets, elapsed);
+  print_counter_sample(line, "bytes",
+      prev_stats.sent_bytes, stats.sent_bytes, elapsed);
+  print_counter_sample(line, "sendmmsg calls",
+      prev_stats.send_calls, stats.send_calls, elapsed);
+  line << ", errors +" << stats.send_errors - prev_stats.send_errors
+       << ", blocked +" << stats.blocked_sends - prev_stats.blocked_sends
+       << ", lag " << stats.lag;
+  stream << line.str() << std::endl;
+}
+
+void print_stats(const ma::multicast_feed::sender_stats& stats)
+{
+  std::cout << "Sent datagrams   : " << stats.sent_packets
+            << std::endl
+            << "Sent bytes       : " << stats.sent_bytes
+            << std::endl
+            << "sendmmsg calls   : " << stats.send_calls
+            << std::endl
+            << "Send errors      : " << stats.send_errors
+            << std::endl
+            << "Blocked sends    : " << stats.blocked_sends
+            << std::endl;
+}
+
+struct execution_context : private boost::noncopyable
+{
+public:
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+
+  execution_context(ma::multicast_feed::sender& the_sender,
+      const boost::posix_time::time_duration& the_stats_interval,
+      ma::steady_deadline_timer& the_stats_timer,
+      ma::console_close_signal& the_close_signal)
+    : sender(the_sender)
+    , stats_interval(the_stats_interval)
+    , stats_timer(the_stats_timer)
+    , close_signal(the_close_signal)
+    , stopped(false)
+    , failed(false)
+    , last_stats()
+    , last_stats_time(time_traits_type::now())
+    , start_time(last_stats_time)
+  {
+  }
+
+  ma::multicast_feed::sender& sender;
+  const boost::posix_time::time_duration stats_interval;
+  ma::steady_deadline_timer&  stats_timer;
+  ma::console_close_signal&   close_signal;
+  bool stopped;
+  bool failed;
+  ma::multicast_feed::sender_stats last_stats;
+  time_type last_stats_time;
+  const time_type start_time;
+}; // struct execution_context
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error);
+
+void start_stats_timer(execution_context& context)
+{
+  namespace detail = ma::detail;
+
+  context.stats_timer.expires_from_now(
+      ma::to_steady_deadline_timer_duration(context.stats_interval));
+  context.stats_timer.async_wait(detail::bind(handle_stats_timer,
+      detail::ref(context), detail::placeholders::_1));
+}
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error)
+{
+  typedef execution_context::time_traits_type time_traits_type;
+
+  if ((boost::asio::error::operation_aborted == error) || context.stopped)
+  {
+    return;
+  }
+
+  const ma::multicast_feed::sender_stats stats = context.sender.stats();
+  const execution_context::time_type now = time_traits_type::now();
+  print_stats_sample(std::cout, context.last_stats, stats,
+      time_traits_type::to_posix_duration(
+          time_traits_type::subtract(now, context.last_stats_time)));
+  context.last_stats = stats;
+  context.last_stats_time = now;
+  start_stats_timer(context);
+}
+
+void stop_event_loop(execution_context& context)
+{
+  context.stopped = true;
+  boost::system::error_code ignored;
+  context.stats_timer.cancel(ignored);
+  context.close_signal.cancel(ignored);
+}
+
+void handle_app_exit(execution_context& context)
+{
+  if (context.stopped)
+  {
+    // Wait for console close is cancelled
+    return;
+  }
+  std::cout << "Application exit request detected." << std::endl;
+  context.sender.stop();
+  stop_event_loop(context);
+}
+
+void handle_sender_completion(execution_context& context,
+    const boost::system::error_code& error)
+{
+  if (error)
+  {
+    std::cout << "Sending failed with error: " << error.message()
+              << std::endl;
+    context.failed = true;
+  }
+  else
+  {
+    std::cout << "All datagrams have been sent." << std::endl;
+  }
+  stop_event_loop(context);
+}
+
+int run_sender(const boost::posix_time::time_duration& stats_interval,
+    const ma::multicast_feed::sender_config& config)
+{
+  namespace detail = ma::detail;
+  typedef execution_context::time_traits_type time_traits_type;
+
+  // Sender is paced by timer, so it shares the only thread with the rest
+  boost::asio::io_service   io_service(ma::to_io_context_concurrency_hint(1));
+  ma::multicast_feed::sender sender(io_service, config);
+  ma::steady_deadline_timer stats_timer(io_service);
+  ma::console_close_signal  close_signal(io_service);
+  execution_context context(sender, stats_interval, stats_timer,
+      close_signal);
+
+  if (boost::system::error_code error = sender.start(detail::bind(
+      handle_sender_completion, detail::ref(context),
+      detail::placeholders::_1)))
+  {
+    std::cout << "Sender can't start due to error: "
+              << error.message() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Press Ctrl+C to exit." << std::endl;
+  close_signal.async_wait(detail::bind(handle_app_exit, detail::ref(context)));
+  start_stats_timer(context);
+
+  io_service.run();
+
+  const ma::multicast_feed::sender_stats stats = sender.stats();
+  const boost::posix_time::time_duration elapsed =
+      time_traits_type::to_posix_duration(time_traits_type::subtract(
+          time_traits_type::now(), context.start_time));
+  print_stats(stats);
+  std::cout << std::fixed << std::setprecision(1)
+            << "Achieved rate    : "
+            << counter_rate(stats.sent_packets, elapsed) << " datagrams/s"
+            << std::endl;
+  return context.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    const boost::program_options::options_description
+        cmd_options_description = build_cmd_options_description();
+
+    boost::program_options::variables_map cmd_options;
+    boost::program_options::store(boost::program_options::parse_command_line(
+        argc, argv, cmd_options_description), cmd_options);
+    boost::program_options::notify(cmd_options);
+
+    if (cmd_options.count(help_option_name))
+    {
+      std::cout << cmd_options_description;
+      return EXIT_SUCCESS;
+    }
+
+    if (!cmd_options.count(port_option_name)
+        || !cmd_options.count(group_option_name))
+    {
+      std::cout << "Required options not specified" << std::endl
+                << cmd_options_description;
+      return EXIT_FAILURE;
+    }
+
+    const boost::posix_time::time_duration stats_interval =
+        read_stats_interval(cmd_options);
+    const ma::multicast_feed::sender_config config =
+        build_sender_config(cmd_options);
+
+    print_config(std::cout, stats_interval, config);
+
+    return run_sender(stats_interval, config);
+  }
+  catch (const boost::program_options::error& e)
+  {
+    std::cerr << "Error reading options: " << e.what() << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Unexpected error: " << e.what() << std::endl;
+  }
+  catch (...)
+  {
+    std::cerr << "Unknown error" << std::endl;
+  }
+  return EXIT_FAILURE;
+}
@@ -10,6 +10,7 @@ TRANSLATOR ma::echo::server::qt::MainForm
 //
 
 #include <limits>
+#include <algorithm>
 #include <stdexcept>
 #include <boost/optional.hpp>
 #include <boost/logic/tribool.hpp>
@@ -452,7 +453,9 @@ session_manager_config MainForm::buildSessionManagerConfig() const
 {
   unsigned short port;
   std::size_t    maxSessions;
+  std::size_t    acceptResumeSessions;
   std::size_t    recycledSessions;
+  std::size_t    warmSessions;
   std::size_t    maxStoppingSessions;
   int            listenBacklog;
   QWidget*       currentWidget = 0;
@@ -465,10 +468,17 @@ session_manager_config MainForm::buildSessionManagerConfig() const
     maxSessions = boost::numeric_cast<std::size_t>(
         ui_.maxSessionCountSpinBox->value());
 
+    //todo: read from UI
+    acceptResumeSessions = maxSessions - (std::max)(
+        static_cast<std::size_t>(1), maxSessions / 10);
+
     currentWidget = ui_.recycledSessionCountSpinBox;
     recycledSessions = boost::numeric_cast<std::size_t>(
         ui_.recycledSessionCountSpinBox->value());
 
+    //todo: read from UI
+    warmSessions = 0;
+
     //todo: read from UI
     maxStoppingSessions = 1000;
 
@@ -495,8 +505,8 @@ session_manager_config MainForm::buildSessionManagerConfig() const
 
   return session_manager_config(
       boost::asio::ip::tcp::endpoint(listenAddress, port),
-      maxSessions, recycledSessions, maxStoppingSessions, listenBacklog,
-      buildSessionConfig());
+      maxSessions, acceptResumeSessions, recycledSessions, warmSessions,
+      maxStoppingSessions, listenBacklog, buildSessionConfig());
 }
 
 MainForm::ServiceConfig MainForm::buildServiceConfig() const
@@ -0,0 +1,512 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <exception>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <ma/config.hpp>
+#include <ma/io_context_helpers.hpp>
+#include <ma/console_close_signal.hpp>
+#include <ma/steady_deadline_timer.hpp>
+#include <ma/thread_group.hpp>
+#include <ma/detail/memory.hpp>
+#include <ma/detail/functional.hpp>
+#include <ma/detail/thread.hpp>
+#include "service.hpp"
+
+namespace {
+
+typedef ma::detail::shared_ptr<boost::asio::io_service> io_service_ptr;
+typedef std::vector<io_service_ptr> io_service_vector;
+typedef ma::detail::shared_ptr<udp_echo_server::service> service_ptr;
+typedef std::vector<service_ptr> service_vector;
+typedef boost::optional<boost::posix_time::time_duration>
+    optional_time_duration;
+
+const char* help_option_name             = "help";
+const char* port_option_name             = "port";
+const char* address_option_name          = "address";
+const char* threads_option_name          = "threads";
+const char* batch_option_name            = "batch";
+const char* datagram_size_option_name    = "datagram-size";
+const char* offload_option_name          = "offload";
+const char* sock_recv_buffer_option_name = "sock-recv-buffer";
+const char* sock_send_buffer_option_name = "sock-send-buffer";
+const char* stats_interval_option_name   = "stats-interval";
+const std::string default_system_value   = "system default";
+
+template <typename Value>
+void validate_option(const std::string& option_name, const Value& option_value,
+    const Value& min, const Value& max = (std::numeric_limits<Value>::max)())
+{
+  if ((option_value < min) || (option_value > max))
+  {
+    using boost::program_options::validation_error;
+    boost::throw_exception(validation_error(
+        validation_error::invalid_option_value, std::string(), option_name));
+  }
+}
+
+template <typename Value>
+std::string to_string(const boost::optional<Value>& value,
+    const std::string& default_text)
+{
+  if (value)
+  {
+    return boost::lexical_cast<std::string>(*value);
+  }
+  return default_text;
+}
+
+std::string to_string(bool value)
+{
+  if (value)
+  {
+    return "on";
+  }
+  return "off";
+}
+
+boost::optional<int> read_socket_buffer_size(
+    const boost::program_options::variables_map& options_values,
+    const std::string& option_name)
+{
+  if (!options_values.count(option_name))
+  {
+    return boost::none;
+  }
+  int buffer_size = options_values[option_name].as<int>();
+  validate_option<int>(option_name, buffer_size, 0);
+  return buffer_size;
+}
+
+boost::program_options::options_description build_cmd_options_description(
+    std::size_t cpu_count)
+{
+  boost::program_options::options_description description("Allowed options");
+  description.add_options()
+    (
+      help_option_name,
+      "produce help message"
+    )
+    (
+      port_option_name,
+      boost::program_options::value<unsigned short>(),
+      "set the UDP port number to receive datagrams on"
+    )
+    (
+      address_option_name,
+      boost::program_options::value<std::string>()->default_value(
+          boost::asio::ip::address_v4::any().to_string()),
+      "set the UDP address to receive datagrams on (IPv4 or IPv6)"
+    )
+    (
+      threads_option_name,
+      boost::program_options::value<std::size_t>()->default_value(cpu_count),
+      "set the number of work threads (each one owns a socket bound" \
+          " with SO_REUSEPORT)"
+    )
+    (
+      batch_option_name,
+      boost::program_options::value<std::size_t>()->default_value(64),
+      "set the maximum number of datagrams received (sent) by single" \
+          " system call"
+    )
+    (
+      datagram_size_option_name,
+      boost::program_options::value<std::size_t>()->default_value(2048),
+      "set the maximum size of received datagram"
+    )
+    (
+      offload_option_name,
+      boost::program_options::value<bool>()->default_value(false),
+      "turn on UDP GRO for receiving and UDP GSO for echoing" \
+          " of coalesced datagrams"
+    )
+    (
+      sock_recv_buffer_option_name,
+      boost::program_options::value<int>(),
+      "set the size of socket receive buffer"
+    )
+    (
+      sock_send_buffer_option_name,
+      boost::program_options::value<int>(),
+      "set the size of socket send buffer"
+    )
+    (
+      stats_interval_option_name,
+      boost::program_options::value<long>(),
+      "set the interval (milliseconds) of printing statistics" \
+          " during the work, turned off if not specified"
+    );
+  return description;
+}
+
+udp_echo_server::service_config build_service_config(
+    const boost::program_options::variables_map& options_values)
+{
+  const unsigned short port =
+      options_values[port_option_name].as<unsigned short>();
+  const std::string address_str =
+      options_values[address_option_name].as<std::string>();
+  const boost::asio::ip::address address =
+      boost::asio::ip::address::from_string(address_str);
+
+  const std::size_t batch_size =
+      options_values[batch_option_name].as<std::size_t>();
+  // UIO_MAXIOV is the limit of recvmmsg / sendmmsg
+  validate_option<std::size_t>(batch_option_name, batch_size, 1, 1024);
+
+  const std::size_t datagram_size =
+      options_values[datagram_size_option_name].as<std::size_t>();
+  validate_option<std::size_t>(datagram_size_option_name, datagram_size, 1,
+      65535);
+
+  const bool offload = options_values[offload_option_name].as<bool>();
+
+  return udp_echo_server::service_config(
+      boost::asio::ip::udp::endpoint(address, port), batch_size, datagram_size,
+      offload,
+      read_socket_buffer_size(options_values, sock_recv_buffer_option_name),
+      read_socket_buffer_size(options_values, sock_send_buffer_option_name));
+}
+
+std::size_t read_thread_count(
+    const boost::program_options::variables_map& options_values)
+{
+  const std::size_t thread_count =
+      options_values[threads_option_name].as<std::size_t>();
+  validate_option<std::size_t>(threads_option_name, thread_count, 1);
+  return thread_count;
+}
+
+optional_time_duration read_stats_interval(
+    const boost::program_options::variables_map& options_values)
+{
+  if (!options_values.count(stats_interval_option_name))
+  {
+    return optional_time_duration();
+  }
+  const long interval = options_values[stats_interval_option_name].as<long>();
+  validate_option<long>(stats_interval_option_name, interval, 1);
+  return boost::posix_time::milliseconds(interval);
+}
+
+void print_config(std::ostream& stream, std::size_t cpu_count,
+    std::size_t thread_count, const optional_time_duration& stats_interval,
+    const udp_echo_server::service_config& config)
+{
+  stream << "Number of found CPUs   : " << cpu_count
+         << std::endl
+         << "Number of work threads : " << thread_count
+         << std::endl
+         << "Endpoint               : " << config.endpoint
+         << std::endl
+         << "Batch size             : " << config.batch_size
+         << std::endl
+         << "Max datagram size      : " << config.datagram_size
+         << std::endl
+         << "Segmentation offload   : "
+         << to_string(config.segmentation_offload)
+         << std::endl
+         << "Socket receive buffer  : "
+         << to_string(config.socket_recv_buffer_size, default_system_value)
+         << std::endl
+         << "Socket send buffer     : "
+         << to_string(config.socket_send_buffer_size, default_system_value)
+         << std::endl
+         << "Statistics interval    : "
+         << to_string(stats_interval, "none")
+         << std::endl;
+}
+
+udp_echo_server::service_stats total_stats(const service_vector& services)
+{
+  udp_echo_server::service_stats stats;
+  for (service_vector::const_iterator i = services.begin(),
+      end = services.end(); i != end; ++i)
+  {
+    stats += (*i)->stats();
+  }
+  return stats;
+}
+
+double counter_rate(boost::uint64_t delta,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::int64_t elapsed_us = elapsed.total_microseconds();
+  if (elapsed_us <= 0)
+  {
+    return 0;
+  }
+  return static_cast<double>(delta) * 1000000 / elapsed_us;
+}
+
+void print_counter_sample(std::ostream& stream, const char* name,
+    boost::uint64_t prev, boost::uint64_t current,
+    const boost::posix_time::time_duration& elapsed)
+{
+  const boost::uint64_t delta = current - prev;
+  stream << ", " << name << " +" << delta
+         << " (" << counter_rate(delta, elapsed) << "/s)";
+}
+
+void print_stats_sample(std::ostream& stream,
+    const udp_echo_server::service_stats& prev_stats,
+    const udp_echo_server::service_stats& stats,
+    const boost::posix_time::time_duration& elapsed)
+{
+  // Build the whole line at once to not mix it with output of other handlers
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1)
+       << "Stats for last " << elapsed.total_milliseconds() << " ms";
+  print_counter_sample(line, "received",
+      prev_stats.received_datagrams, stats.received_datagrams, elapsed);
+  print_counter_sample(line, "sent",
+      prev_stats.sent_datagrams, stats.sent_datagrams, elapsed);
+  print_counter_sample(line, "dropped",
+      prev_stats.dropped_datagrams, stats.dropped_datagrams, elapsed);
+  print_counter_sample(line, "bytes",
+      prev_stats.received_bytes, stats.received_bytes, elapsed);
+  print_counter_sample(line, "recvmmsg calls",
+      prev_stats.receive_calls, stats.receive_calls, elapsed);
+  print_counter_sample(line, "sendmmsg calls",
+      prev_stats.send_calls, stats.send_calls, elapsed);
+  stream << line.str() << std::endl;
+}
+
+void print_stats(const udp_echo_server::service_stats& stats)
+{
+  std::cout << "Received datagrams : " << stats.received_datagrams
+            << std::endl
+            << "Received bytes     : " << stats.received_bytes
+            << std::endl
+            << "Sent datagrams     : " << stats.sent_datagrams
+            << std::endl
+            << "Dropped datagrams  : " << stats.dropped_datagrams
+            << std::endl
+            << "recvmmsg calls     : " << stats.receive_calls
+            << std::endl
+            << "sendmmsg calls     : " << stats.send_calls
+            << std::endl;
+}
+
+struct execution_context : private boost::noncopyable
+{
+public:
+  typedef ma::steady_deadline_timer::time_type   time_type;
+  typedef ma::steady_deadline_timer::traits_type time_traits_type;
+
+  execution_context(const service_vector& the_services,
+      const optional_time_duration& the_stats_interval,
+      ma::steady_deadline_timer& the_stats_timer)
+    : services(the_services)
+    , stats_interval(the_stats_interval)
+    , stats_timer(the_stats_timer)
+    , stopped(false)
+    , last_stats()
+    , last_stats_time(time_traits_type::now())
+  {
+  }
+
+  const service_vector&         services;
+  const optional_time_duration& stats_interval;
+  ma::steady_deadline_timer&    stats_timer;
+  bool stopped;
+  udp_echo_server::service_stats last_stats;
+  time_type last_stats_time;
+}; // struct execution_context
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error);
+
+void start_stats_timer(execution_context& context)
+{
+  namespace detail = ma::detail;
+
+  context.stats_timer.expires_from_now(
+      ma::to_steady_deadline_timer_duration(*context.stats_interval));
+  context.stats_timer.async_wait(detail::bind(handle_stats_timer,
+      detail::ref(context), detail::placeholders::_1));
+}
+
+void handle_stats_timer(execution_context& context,
+    const boost::system::error_code& error)
+{
+  typedef execution_context::time_traits_type time_traits_type;
+
+  if ((boost::asio::error::operation_aborted == error) || context.stopped)
+  {
+    return;
+  }
+
+  const udp_echo_server::service_stats stats = total_stats(context.services);
+  const execution_context::time_type now = time_traits_type::now();
+  print_stats_sample(std::cout, context.last_stats, stats,
+      time_traits_type::to_posix_duration(
+          time_traits_type::subtract(now, context.last_stats_time)));
+  context.last_stats = stats;
+  context.last_stats_time = now;
+  start_stats_timer(context);
+}
+
+void handle_app_exit(execution_context& context)
+{
+  std::cout << "Application exit request detected." << std::endl;
+  context.stopped = true;
+  boost::system::error_code ignored;
+  context.stats_timer.cancel(ignored);
+  for (service_vector::const_iterator i = context.services.begin(),
+      end = context.services.end(); i != end; ++i)
+  {
+    (*i)->stop();
+  }
+}
+
+int run_server(std::size_t thread_count,
+    const optional_time_duration& stats_interval,
+    const udp_echo_server::service_config& config)
+{
+  namespace detail = ma::detail;
+
+  // Each service is handled by its own thread, so there is no need
+  // in synchronization of its handlers
+  io_service_vector io_services;
+  service_vector services;
+  for (std::size_t i = 0; i != thread_count; ++i)
+  {
+    io_service_ptr io_service = detail::make_shared<boost::asio::io_service>(
+        ma::to_io_context_concurrency_hint(1));
+    io_services.push_back(io_service);
+    services.push_back(detail::make_shared<udp_echo_server::service>(
+        detail::ref(*io_service), config));
+  }
+
+  for (service_vector::const_iterator i = services.begin(),
+      end = services.end(); i != end; ++i)
+  {
+    if (boost::system::error_code error = (*i)->start())
+    {
+      std::cout << "Server can't start due to error: "
+                << error.message() << std::endl;
+      // Already started services have pending waits using memory owned by
+      // these services, so let the waits complete before services are
+      // destroyed. Services run out of work once they are stopped.
+      for (service_vector::const_iterator j = services.begin(); j != i; ++j)
+      {
+        (*j)->stop();
+      }
+      for (io_service_vector::const_iterator j = io_services.begin(),
+          io_services_end = io_services.end(); j != io_services_end; ++j)
+      {
+        (*j)->run();
+      }
+      return EXIT_FAILURE;
+    }
+  }
+
+  boost::asio::io_service   event_loop(ma::to_io_context_concurrency_hint(1));
+  ma::steady_deadline_timer stats_timer(event_loop);
+  ma::console_close_signal  close_signal(event_loop);
+  execution_context context(services, stats_interval, stats_timer);
+
+  // Wait for console close
+  std::cout << "Press Ctrl+C to exit." << std::endl;
+  close_signal.async_wait(detail::bind(handle_app_exit, detail::ref(context)));
+
+  if (stats_interval)
+  {
+    start_stats_timer(context);
+  }
+
+  ma::thread_group work_threads;
+  for (io_service_vector::const_iterator i = io_services.begin(),
+      end = io_services.end(); i != end; ++i)
+  {
+    typedef std::size_t (boost::asio::io_service::*run_func)();
+    work_threads.create_thread(detail::bind(
+        static_cast<run_func>(&boost::asio::io_service::run), i->get()));
+  }
+  std::cout << "Server has started." << std::endl;
+
+  // Services run out of work once they are stopped
+  event_loop.run();
+
+  std::cout << "Waiting until work threads stop." << std::endl;
+  work_threads.join_all();
+  std::cout << "Work threads have stopped." << std::endl;
+
+  print_stats(total_stats(services));
+  return EXIT_SUCCESS;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    const std::size_t cpu_count = ma::detail::thread::hardware_concurrency();
+    const boost::program_options::options_description
+        cmd_options_description = build_cmd_options_description(cpu_count);
+
+    boost::program_options::variables_map cmd_options;
+    boost::program_options::store(boost::program_options::parse_command_line(
+        argc, argv, cmd_options_description), cmd_options);
+    boost::program_options::notify(cmd_options);
+
+    if (cmd_options.count(help_option_name))
+    {
+      std::cout << cmd_options_description;
+      return EXIT_SUCCESS;
+    }
+
+    if (!cmd_options.count(port_option_name))
+    {
+      std::cout << "Port is not specified" << std::endl
+                << cmd_options_description;
+      return EXIT_FAILURE;
+    }
+
+    const std::size_t thread_count = read_thread_count(cmd_options);
+    const optional_time_duration stats_interval =
+        read_stats_interval(cmd_options);
+    const udp_echo_server::service_config config =
+        build_service_config(cmd_options);
+
+    print_config(std::cout, cpu_count, thread_count, stats_interval, config);
+
+    return run_server(thread_count, stats_interval, config);
+  }
+  catch (const boost::program_options::error& e)
+  {
+    std::cerr << "Error reading options: " << e.what() << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Unexpected error: " << e.what() << std::endl;
+  }
+  catch (...)
+  {
+    std::cerr << "Unknown error" << std::endl;
+  }
+  return EXIT_FAILURE;
+}
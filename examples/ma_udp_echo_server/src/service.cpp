@@ -0,0 +1,452 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <boost/assert.hpp>
+#include <ma/custom_alloc_handler.hpp>
+#include <ma/detail/functional.hpp>
+#include "service.hpp"
+
+namespace udp_echo_server {
+
+namespace {
+
+// Number of batches handled before letting other handlers run
+const std::size_t max_batches_per_run = 16;
+
+// UDP GRO can coalesce datagrams up to this size
+const std::size_t max_coalesced_size = 65535;
+
+std::size_t segment_count(std::size_t size, std::size_t segment_size)
+{
+  if (!segment_size)
+  {
+    return 1;
+  }
+  return (size + segment_size - 1) / segment_size;
+}
+
+bool would_block(int error)
+{
+  return (EAGAIN == error) || (EWOULDBLOCK == error);
+}
+
+} // anonymous namespace
+
+service_config::service_config(
+    const boost::asio::ip::udp::endpoint& the_endpoint,
+    std::size_t the_batch_size,
+    std::size_t the_datagram_size,
+    bool the_segmentation_offload,
+    const optional_int& the_socket_recv_buffer_size,
+    const optional_int& the_socket_send_buffer_size)
+  : endpoint(the_endpoint)
+  , batch_size(the_batch_size)
+  , datagram_size(the_datagram_size)
+  , segmentation_offload(the_segmentation_offload)
+  , socket_recv_buffer_size(the_socket_recv_buffer_size)
+  , socket_send_buffer_size(the_socket_send_buffer_size)
+{
+  BOOST_ASSERT_MSG(the_batch_size > 0, "batch_size must be > 0");
+
+  BOOST_ASSERT_MSG(the_datagram_size > 0, "datagram_size must be > 0");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_recv_buffer_size || (*the_socket_recv_buffer_size) >= 0,
+      "Defined socket_recv_buffer_size must be >= 0");
+
+  BOOST_ASSERT_MSG(
+      !the_socket_send_buffer_size || (*the_socket_send_buffer_size) >= 0,
+      "Defined socket_send_buffer_size must be >= 0");
+}
+
+service_stats::service_stats()
+  : received_datagrams(0)
+  , received_bytes(0)
+  , sent_datagrams(0)
+  , dropped_datagrams(0)
+  , receive_calls(0)
+  , send_calls(0)
+{
+}
+
+service_stats& service_stats::operator+=(const service_stats& other)
+{
+  received_datagrams += other.received_datagrams;
+  received_bytes     += other.received_bytes;
+  sent_datagrams     += other.sent_datagrams;
+  dropped_datagrams  += other.dropped_datagrams;
+  receive_calls      += other.receive_calls;
+  send_calls         += other.send_calls;
+  return *this;
+}
+
+service::service(boost::asio::io_service& io_service,
+    const service_config& config)
+  : batch_size_(config.batch_size)
+  , datagram_size_(config.segmentation_offload
+        ? (std::max)(config.datagram_size, max_coalesced_size)
+        : config.datagram_size)
+  , control_size_(config.segmentation_offload ? CMSG_SPACE(sizeof(int)) : 0)
+  , segmentation_offload_(config.segmentation_offload)
+  , endpoint_(config.endpoint)
+  , socket_recv_buffer_size_(config.socket_recv_buffer_size)
+  , socket_send_buffer_size_(config.socket_send_buffer_size)
+  , io_service_(io_service)
+  , socket_(io_service)
+  , stopped_(false)
+  , data_(batch_size_ * datagram_size_)
+  , control_(batch_size_ * control_size_)
+  , messages_(batch_size_)
+  , iovecs_(batch_size_)
+  , addresses_(batch_size_)
+  , segments_(batch_size_)
+  , send_begin_(0)
+  , send_end_(0)
+  , received_datagrams_(0)
+  , received_bytes_(0)
+  , sent_datagrams_(0)
+  , dropped_datagrams_(0)
+  , receive_calls_(0)
+  , send_calls_(0)
+{
+}
+
+boost::system::error_code service::start()
+{
+  boost::system::error_code error;
+  socket_.open(endpoint_.protocol(), error);
+  if (error)
+  {
+    return error;
+  }
+
+  error = apply_socket_options();
+  if (!error)
+  {
+    socket_.bind(endpoint_, error);
+  }
+  if (!error)
+  {
+    // System calls are made directly and they must not block
+    socket_.non_blocking(true, error);
+  }
+  if (error)
+  {
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    return error;
+  }
+
+  start_read_wait();
+  return boost::system::error_code();
+}
+
+void service::stop()
+{
+  io_service_.post(ma::detail::bind(&this_type::handle_stop, this));
+}
+
+service_stats service::stats() const
+{
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  service_stats stats;
+  stats.received_datagrams = received_datagrams_.load(order);
+  stats.received_bytes     = received_bytes_.load(order);
+  stats.sent_datagrams     = sent_datagrams_.load(order);
+  stats.dropped_datagrams  = dropped_datagrams_.load(order);
+  stats.receive_calls      = receive_calls_.load(order);
+  stats.send_calls         = send_calls_.load(order);
+  return stats;
+}
+
+void service::handle_wait(const boost::system::error_code& error)
+{
+  if (stopped_)
+  {
+    return;
+  }
+  if (error)
+  {
+    // Readiness of socket can't be waited anymore
+    handle_stop();
+    return;
+  }
+  continue_work();
+}
+
+void service::handle_continue()
+{
+  if (stopped_)
+  {
+    return;
+  }
+  continue_work();
+}
+
+void service::handle_stop()
+{
+  stopped_ = true;
+  boost::system::error_code ignored;
+  socket_.close(ignored);
+}
+
+void service::continue_work()
+{
+  for (std::size_t i = 0; i != max_batches_per_run; ++i)
+  {
+    // Echo the rest of the previous batch first
+    if (!send_batch())
+    {
+      start_write_wait();
+      return;
+    }
+    if (!receive_batch())
+    {
+      if (!stopped_)
+      {
+        start_read_wait();
+      }
+      return;
+    }
+  }
+  // Socket can still have datagrams which won't be notified about
+  // (edge-triggered demultiplexer), so continue after other handlers
+  start_continue();
+}
+
+bool service::receive_batch()
+{
+  for (std::size_t i = 0; i != batch_size_; ++i)
+  {
+    iovecs_[i].iov_base = &data_[i * datagram_size_];
+    iovecs_[i].iov_len  = datagram_size_;
+    ::msghdr& header = messages_[i].msg_hdr;
+    header.msg_name       = &addresses_[i];
+    header.msg_namelen    = sizeof(addresses_[i]);
+    header.msg_iov        = &iovecs_[i];
+    header.msg_iovlen     = 1;
+    header.msg_control    = control_size_ ? &control_[i * control_size_] : 0;
+    header.msg_controllen = control_size_;
+    header.msg_flags      = 0;
+  }
+
+  int received;
+  for (;;)
+  {
+    received = ::recvmmsg(socket_.native_handle(), &messages_[0],
+        static_cast<unsigned int>(batch_size_), MSG_DONTWAIT, 0);
+    if (received > 0)
+    {
+      break;
+    }
+    const int error = received ? errno : EAGAIN;
+    if (would_block(error))
+    {
+      return false;
+    }
+    // ICMP errors caused by previously sent datagrams are reported once
+    if ((EINTR == error) || (ECONNREFUSED == error))
+    {
+      continue;
+    }
+    // Datagrams can't be received anymore
+    handle_stop();
+    return false;
+  }
+
+  boost::uint64_t datagrams = 0;
+  boost::uint64_t bytes = 0;
+  for (std::size_t i = 0, count = static_cast<std::size_t>(received);
+      i != count; ++i)
+  {
+    ::msghdr& header = messages_[i].msg_hdr;
+    const std::size_t size = messages_[i].msg_len;
+    std::size_t segment_size = 0;
+
+#if defined(UDP_GRO) && defined(UDP_SEGMENT)
+    if (segmentation_offload_)
+    {
+      for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg;
+          cmsg = CMSG_NXTHDR(&header, cmsg))
+      {
+        if ((SOL_UDP == cmsg->cmsg_level) && (UDP_GRO == cmsg->cmsg_type))
+        {
+          int gro_size;
+          std::memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+          segment_size = static_cast<std::size_t>(gro_size);
+        }
+      }
+    }
+#endif // defined(UDP_GRO) && defined(UDP_SEGMENT)
+
+    // Reuse the same header for echo
+    iovecs_[i].iov_len = size;
+    header.msg_controllen = 0;
+    header.msg_flags = 0;
+
+#if defined(UDP_GRO) && defined(UDP_SEGMENT)
+    if (segment_size && (size > segment_size))
+    {
+      // Echo coalesced datagrams with the same segmentation (UDP GSO)
+      header.msg_controllen = CMSG_SPACE(sizeof(boost::uint16_t));
+      ::cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type  = UDP_SEGMENT;
+      cmsg->cmsg_len   = CMSG_LEN(sizeof(boost::uint16_t));
+      const boost::uint16_t gso_size =
+          static_cast<boost::uint16_t>(segment_size);
+      std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    }
+#endif // defined(UDP_GRO) && defined(UDP_SEGMENT)
+
+    segments_[i] = segment_count(size, segment_size);
+    datagrams += segments_[i];
+    bytes     += size;
+  }
+
+  send_begin_ = 0;
+  send_end_   = static_cast<std::size_t>(received);
+
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  receive_calls_.fetch_add(1, order);
+  received_datagrams_.fetch_add(datagrams, order);
+  received_bytes_.fetch_add(bytes, order);
+  return true;
+}
+
+bool service::send_batch()
+{
+  boost::uint64_t calls = 0;
+  boost::uint64_t sent = 0;
+  boost::uint64_t dropped = 0;
+  bool completed = true;
+  while (send_begin_ != send_end_)
+  {
+    const int result = ::sendmmsg(socket_.native_handle(),
+        &messages_[send_begin_],
+        static_cast<unsigned int>(send_end_ - send_begin_), MSG_DONTWAIT);
+    if (result > 0)
+    {
+      ++calls;
+      for (std::size_t end = send_begin_ + static_cast<std::size_t>(result);
+          send_begin_ != end; ++send_begin_)
+      {
+        sent += segments_[send_begin_];
+      }
+      continue;
+    }
+    const int error = result ? errno : EAGAIN;
+    if (would_block(error))
+    {
+      completed = false;
+      break;
+    }
+    if (EINTR == error)
+    {
+      continue;
+    }
+    // Datagram can't be sent (f.e. destination is unreachable), so drop it
+    dropped += segments_[send_begin_];
+    ++send_begin_;
+  }
+
+  const ma::detail::memory_order order = ma::detail::memory_order_relaxed;
+  if (calls)
+  {
+    send_calls_.fetch_add(calls, order);
+    sent_datagrams_.fetch_add(sent, order);
+  }
+  if (dropped)
+  {
+    dropped_datagrams_.fetch_add(dropped, order);
+  }
+  return completed;
+}
+
+void service::start_read_wait()
+{
+  socket_.async_receive(boost::asio::null_buffers(),
+      ma::make_custom_alloc_handler(allocator_, ma::detail::bind(
+          &this_type::handle_wait, this, ma::detail::placeholders::_1)));
+}
+
+void service::start_write_wait()
+{
+  socket_.async_send(boost::asio::null_buffers(),
+      ma::make_custom_alloc_handler(allocator_, ma::detail::bind(
+          &this_type::handle_wait, this, ma::detail::placeholders::_1)));
+}
+
+void service::start_continue()
+{
+  io_service_.post(ma::make_custom_alloc_handler(allocator_,
+      ma::detail::bind(&this_type::handle_continue, this)));
+}
+
+boost::system::error_code service::apply_socket_options()
+{
+  typedef boost::asio::ip::udp::socket socket_type;
+  typedef boost::asio::detail::socket_option::boolean<
+      SOL_SOCKET, SO_REUSEPORT> reuse_port_option;
+
+  // Let multiple services share the same endpoint
+  {
+    boost::system::error_code error;
+    socket_.set_option(reuse_port_option(true), error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (socket_recv_buffer_size_)
+  {
+    boost::system::error_code error;
+    socket_type::receive_buffer_size opt(*socket_recv_buffer_size_);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (socket_send_buffer_size_)
+  {
+    boost::system::error_code error;
+    socket_type::send_buffer_size opt(*socket_send_buffer_size_);
+    socket_.set_option(opt, error);
+    if (error)
+    {
+      return error;
+    }
+  }
+
+  if (segmentation_offload_)
+  {
+#if defined(UDP_GRO) && defined(UDP_SEGMENT)
+    typedef boost::asio::detail::socket_option::boolean<
+        SOL_UDP, UDP_GRO> gro_option;
+    boost::system::error_code error;
+    socket_.set_option(gro_option(true), error);
+    if (error)
+    {
+      return error;
+    }
+#else
+    return boost::asio::error::operation_not_supported;
+#endif
+  }
+
+  return boost::system::error_code();
+}
+
+} // namespace udp_echo_server
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef UDP_ECHO_SERVER_SERVICE_HPP
+#define UDP_ECHO_SERVER_SERVICE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <vector>
+#include <sys/socket.h>
+#include <boost/asio.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <ma/handler_allocator.hpp>
+#include <ma/detail/atomic.hpp>
+
+namespace udp_echo_server {
+
+struct service_config
+{
+public:
+  typedef boost::optional<int> optional_int;
+
+  service_config(const boost::asio::ip::udp::endpoint& endpoint,
+      std::size_t batch_size,
+      std::size_t datagram_size,
+      bool segmentation_offload,
+      const optional_int& socket_recv_buffer_size,
+      const optional_int& socket_send_buffer_size);
+
+  boost::asio::ip::udp::endpoint endpoint;
+  /// Max number of datagrams received (sent) by single system call.
+  std::size_t   batch_size;
+  /// Max size of received datagram.
+  std::size_t   datagram_size;
+  /// UDP GRO for receiving and UDP GSO for echoing (coalesced datagrams are
+  /// echoed with the same segment size).
+  bool          segmentation_offload;
+  optional_int  socket_recv_buffer_size;
+  optional_int  socket_send_buffer_size;
+}; // struct service_config
+
+struct service_stats
+{
+  service_stats();
+
+  service_stats& operator+=(const service_stats&);
+
+  boost::uint64_t received_datagrams;
+  boost::uint64_t received_bytes;
+  boost::uint64_t sent_datagrams;
+  boost::uint64_t dropped_datagrams;
+  boost::uint64_t receive_calls;
+  boost::uint64_t send_calls;
+}; // struct service_stats
+
+/// UDP echo service which uses recvmmsg / sendmmsg with preallocated batches.
+/**
+ * Service owns single socket bound with SO_REUSEPORT, so multiple services
+ * (one per thread) can share the same endpoint and kernel distributes
+ * datagrams among them. Handlers of service are not synchronized, so
+ * io_service of service has to be run by a single thread.
+ */
+class service : private boost::noncopyable
+{
+private:
+  typedef service this_type;
+
+public:
+  service(boost::asio::io_service& io_service, const service_config& config);
+
+  /// Opens and binds socket, then starts echoing.
+  boost::system::error_code start();
+
+  /// Closes socket. Thread-safe.
+  void stop();
+
+  /// Thread-safe.
+  service_stats stats() const;
+
+private:
+  typedef ma::detail::atomic<boost::uint64_t> atomic_counter;
+
+  void handle_wait(const boost::system::error_code&);
+  void handle_continue();
+  void handle_stop();
+
+  void continue_work();
+  bool receive_batch();
+  bool send_batch();
+  void start_read_wait();
+  void start_write_wait();
+  void start_continue();
+  boost::system::error_code apply_socket_options();
+
+  const std::size_t batch_size_;
+  const std::size_t datagram_size_;
+  const std::size_t control_size_;
+  const bool        segmentation_offload_;
+  const boost::asio::ip::udp::endpoint endpoint_;
+  const service_config::optional_int   socket_recv_buffer_size_;
+  const service_config::optional_int   socket_send_buffer_size_;
+
+  boost::asio::io_service&     io_service_;
+  boost::asio::ip::udp::socket socket_;
+  bool                         stopped_;
+
+  // Preallocated batch. Received datagrams are echoed with the same headers.
+  std::vector<char>             data_;
+  std::vector<char>             control_;
+  std::vector< ::mmsghdr>       messages_;
+  std::vector< ::iovec>         iovecs_;
+  std::vector< ::sockaddr_storage> addresses_;
+  std::vector<std::size_t>      segments_;
+  std::size_t                   send_begin_;
+  std::size_t                   send_end_;
+
+  atomic_counter received_datagrams_;
+  atomic_counter received_bytes_;
+  atomic_counter sent_datagrams_;
+  atomic_counter dropped_datagrams_;
+  atomic_counter receive_calls_;
+  atomic_counter send_calls_;
+
+  ma::in_place_handler_allocator<128> allocator_;
+}; // class service
+
+} // namespace udp_echo_server
+
+#endif // UDP_ECHO_SERVER_SERVICE_HPP
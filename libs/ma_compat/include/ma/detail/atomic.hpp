@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_DETAIL_ATOMIC_HPP
+#define MA_DETAIL_ATOMIC_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <ma/config.hpp>
+
+#if defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+#include <atomic>
+
+#else  // defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+#include <boost/atomic.hpp>
+
+#endif // defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+namespace ma {
+namespace detail {
+
+#if defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+using std::atomic;
+using std::memory_order;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_acq_rel;
+using std::memory_order_seq_cst;
+
+#else  // defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+using boost::atomic;
+using boost::memory_order;
+using boost::memory_order_relaxed;
+using boost::memory_order_acquire;
+using boost::memory_order_release;
+using boost::memory_order_acq_rel;
+using boost::memory_order_seq_cst;
+
+#endif // defined(MA_USE_CXX11_STDLIB_ATOMIC)
+
+} // namespace detail
+} // namespace ma
+
+#endif // MA_DETAIL_ATOMIC_HPP
@@ -32,6 +32,8 @@ namespace detail {
 
 using std::mt19937;
 using std::uniform_int_distribution;
+using std::lognormal_distribution;
+using std::discrete_distribution;
 
 #else  // defined(MA_USE_CXX11_STDLIB_RANDOM)
 
@@ -39,6 +41,8 @@ using std::uniform_int_distribution;
 
 using boost::random::mt19937;
 using boost::random::uniform_int_distribution;
+using boost::random::lognormal_distribution;
+using boost::random::discrete_distribution;
 
 #else // BOOST_VERSION >= 104700
 
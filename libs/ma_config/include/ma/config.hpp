@@ -33,6 +33,7 @@
 #define MA_USE_CXX11_STDLIB_TUPLE
 #define MA_USE_CXX11_STDLIB_FUNCTIONAL
 #define MA_USE_CXX11_STDLIB_THREAD
+#define MA_USE_CXX11_STDLIB_ATOMIC
 #define MA_USE_CXX11_STDLIB_TYPE_TRAITS
 #define MA_USE_CXX11_STDLIB_RANDOM
 
@@ -42,6 +43,7 @@
 #define MA_USE_CXX11_STDLIB_TUPLE
 #undef  MA_USE_CXX11_STDLIB_FUNCTIONAL
 #undef  MA_USE_CXX11_STDLIB_THREAD
+#undef  MA_USE_CXX11_STDLIB_ATOMIC
 #define MA_USE_CXX11_STDLIB_TYPE_TRAITS
 #define MA_USE_CXX11_STDLIB_RANDOM
 
@@ -51,6 +53,7 @@
 #undef  MA_USE_CXX11_STDLIB_TUPLE
 #undef  MA_USE_CXX11_STDLIB_FUNCTIONAL
 #undef  MA_USE_CXX11_STDLIB_THREAD
+#undef  MA_USE_CXX11_STDLIB_ATOMIC
 #undef  MA_USE_CXX11_STDLIB_TYPE_TRAITS
 #undef  MA_USE_CXX11_STDLIB_RANDOM
 
@@ -86,6 +86,10 @@ public:
   /// Return buffer to the state as was right after construction.
   void reset();
 
+  /// Exchange memory and state with other buffer. Doesn't move or copy
+  /// buffered data.
+  void swap(cyclic_buffer& other);
+
   /// Reduce filled sequence by marking first size bytes of filled sequence as
   /// nonfilled sequence.
   /**
@@ -120,10 +124,20 @@ public:
   /// The size of returned buffer sequence is not greater than max_size.
   mutable_buffers_type prepared(std::size_t max_size) const;
 
+  /// Return constant buffer sequence representing filled sequence without
+  /// its first offset bytes.
+  /// The size of returned buffer sequence is not greater than max_size.
+  /**
+   * Is useful when beginning of filled sequence is already handled (f.e.
+   * is sent) but can't be committed yet.
+   */
+  const_buffers_type data(std::size_t offset, std::size_t max_size) const;
+
   std::size_t size() const;
 
 private:
-  const_buffers_type   data_of_size(std::size_t buffers_size) const;
+  const_buffers_type   data_of_size(std::size_t offset,
+      std::size_t buffers_size) const;
   mutable_buffers_type prepared_of_size(std::size_t buffers_size) const;
 
 #if defined(MA_USE_CXX11_STDLIB_MEMORY)
@@ -197,6 +211,16 @@ inline void cyclic_buffer::reset()
   nonfilled_start_ = filled_start_ = filled_size_ = 0;
 }
 
+inline void cyclic_buffer::swap(cyclic_buffer& other)
+{
+  data_.swap(other.data_);
+  std::swap(size_, other.size_);
+  std::swap(nonfilled_start_, other.nonfilled_start_);
+  std::swap(nonfilled_size_, other.nonfilled_size_);
+  std::swap(filled_start_, other.filled_start_);
+  std::swap(filled_size_, other.filled_size_);
+}
+
 inline void cyclic_buffer::commit(std::size_t size)
 {
   if (size > filled_size_)
@@ -239,7 +263,7 @@ inline void cyclic_buffer::consume(std::size_t size)
 
 inline cyclic_buffer::const_buffers_type cyclic_buffer::data() const
 {
-  return data_of_size(filled_size_);
+  return data_of_size(0, filled_size_);
 }
 
 inline cyclic_buffer::mutable_buffers_type cyclic_buffer::prepared() const
@@ -250,7 +274,7 @@ inline cyclic_buffer::mutable_buffers_type cyclic_buffer::prepared() const
 inline cyclic_buffer::const_buffers_type
 cyclic_buffer::data(std::size_t max_size) const
 {
-  return data_of_size((std::min<std::size_t>)(filled_size_, max_size));
+  return data_of_size(0, (std::min<std::size_t>)(filled_size_, max_size));
 }
 
 inline cyclic_buffer::mutable_buffers_type
@@ -259,29 +283,44 @@ cyclic_buffer::prepared(std::size_t max_size) const
   return prepared_of_size((std::min<std::size_t>)(nonfilled_size_, max_size));
 }
 
+inline cyclic_buffer::const_buffers_type
+cyclic_buffer::data(std::size_t offset, std::size_t max_size) const
+{
+  if (offset > filled_size_)
+  {
+    boost::throw_exception(std::length_error(
+        "filled sequence size is too small to skip given offset"));
+  }
+  return data_of_size(offset,
+      (std::min<std::size_t>)(filled_size_ - offset, max_size));
+}
+
 inline std::size_t cyclic_buffer::size() const
 {
   return size_;
 }
 
 inline cyclic_buffer::const_buffers_type
-cyclic_buffer::data_of_size(std::size_t buffers_size) const
+cyclic_buffer::data_of_size(std::size_t offset,
+    std::size_t buffers_size) const
 {
-  BOOST_ASSERT_MSG(buffers_size <= filled_size_,
-      "The specified buffers size must be <= curent filled size");
+  BOOST_ASSERT_MSG(offset + buffers_size <= filled_size_,
+      "The specified offset and buffers size must be <= curent filled size");
   if (!buffers_size)
   {
     return const_buffers_type();
   }
-  std::size_t d = size_ - filled_start_;
+  std::size_t start = size_ - filled_start_ > offset
+      ? filled_start_ + offset : offset - (size_ - filled_start_);
+  std::size_t d = size_ - start;
   if (buffers_size > d)
   {
     return const_buffers_type(
-        boost::asio::const_buffer(data_.get() + filled_start_, d),
+        boost::asio::const_buffer(data_.get() + start, d),
         boost::asio::const_buffer(data_.get(), buffers_size - d));
   }
   return const_buffers_type(boost::asio::const_buffer(
-      data_.get() + filled_start_, buffers_size));
+      data_.get() + start, buffers_size));
 }
 
 inline cyclic_buffer::mutable_buffers_type
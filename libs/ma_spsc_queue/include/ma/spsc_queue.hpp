@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2010-2015 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef MA_SPSC_QUEUE_HPP
+#define MA_SPSC_QUEUE_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <stdexcept>
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/throw_exception.hpp>
+#include <ma/detail/atomic.hpp>
+
+namespace ma {
+
+/// Lock-free bounded queue for a single producer and a single consumer.
+/**
+ * Queue is a ring of slots which are allocated (copy constructed from the
+ * given value) at construction and are never freed or constructed again.
+ * Values are not moved into and out of the queue - producer fills prepared
+ * slots in place and then commits them, consumer reads slots in place and
+ * then consumes them. Contents of a consumed slot are kept as is, so slots
+ * can hold pointers to resources allocated once by the producer.
+ *
+ * Producer methods (prepared_size, prepared, commit, push) can be called
+ * by one thread and consumer methods (size, front, consume, pop) can be
+ * called by another one at the same time without any synchronization.
+ * Producer and consumer indices are placed on separate cache lines and
+ * each side caches the last seen index of the other side to not touch
+ * that cache line when it is not required.
+ *
+ * Capacity is rounded up to the closest power of 2.
+ */
+template <typename Value>
+class spsc_queue : private boost::noncopyable
+{
+public:
+  typedef Value value_type;
+
+  explicit spsc_queue(std::size_t capacity,
+      const value_type& value = value_type());
+
+  /// Actual capacity of the queue. Thread-safe.
+  std::size_t capacity() const;
+
+  /// Producer side. Number of free slots.
+  std::size_t prepared_size();
+
+  /// Producer side. Free slot at the given offset.
+  /**
+   * Offset has to be less than the value returned by the last call of
+   * prepared_size.
+   */
+  value_type& prepared(std::size_t offset = 0);
+
+  /// Producer side. Makes the first count free slots available to consumer.
+  void commit(std::size_t count = 1);
+
+  /// Producer side. Copies the given value into the queue if it is not full.
+  bool push(const value_type& value);
+
+  /// Consumer side. Number of filled slots.
+  std::size_t size();
+
+  /// Consumer side. Filled slot at the given offset.
+  /**
+   * Offset has to be less than the value returned by the last call of size.
+   */
+  value_type& front(std::size_t offset = 0);
+
+  /// Consumer side. Makes the first count filled slots free.
+  void consume(std::size_t count = 1);
+
+  /// Consumer side. Copies the first value out of the queue if it is
+  /// not empty.
+  bool pop(value_type& value);
+
+private:
+  typedef ma::detail::atomic<std::size_t> atomic_index;
+
+  enum { cache_line_size = 64 };
+
+  static std::size_t round_up_capacity(std::size_t capacity);
+
+  std::vector<value_type> slots_;
+  const std::size_t mask_;
+
+  char padding1_[cache_line_size];
+  // Index of the first filled slot. Modified by consumer.
+  atomic_index head_;
+  // Index of the first free slot as it was seen by consumer.
+  std::size_t  consumer_tail_;
+
+  char padding2_[cache_line_size];
+  // Index of the first free slot. Modified by producer.
+  atomic_index tail_;
+  // Index of the first filled slot as it was seen by producer.
+  std::size_t  producer_head_;
+
+  char padding3_[cache_line_size];
+}; // class spsc_queue
+
+template <typename Value>
+spsc_queue<Value>::spsc_queue(std::size_t capacity, const value_type& value)
+  : slots_(round_up_capacity(capacity), value)
+  , mask_(slots_.size() - 1)
+  , head_(0)
+  , consumer_tail_(0)
+  , tail_(0)
+  , producer_head_(0)
+{
+}
+
+template <typename Value>
+std::size_t spsc_queue<Value>::capacity() const
+{
+  return slots_.size();
+}
+
+template <typename Value>
+std::size_t spsc_queue<Value>::prepared_size()
+{
+  const std::size_t tail = tail_.load(ma::detail::memory_order_relaxed);
+  producer_head_ = head_.load(ma::detail::memory_order_acquire);
+  return slots_.size() - (tail - producer_head_);
+}
+
+template <typename Value>
+typename spsc_queue<Value>::value_type& spsc_queue<Value>::prepared(
+    std::size_t offset)
+{
+  const std::size_t tail = tail_.load(ma::detail::memory_order_relaxed);
+  BOOST_ASSERT_MSG(offset < slots_.size() - (tail - producer_head_),
+      "Offset is out of free slots");
+  return slots_[(tail + offset) & mask_];
+}
+
+template <typename Value>
+void spsc_queue<Value>::commit(std::size_t count)
+{
+  const std::size_t tail = tail_.load(ma::detail::memory_order_relaxed);
+  BOOST_ASSERT_MSG(count <= slots_.size() - (tail - producer_head_),
+      "Count is out of free slots");
+  tail_.store(tail + count, ma::detail::memory_order_release);
+}
+
+template <typename Value>
+bool spsc_queue<Value>::push(const value_type& value)
+{
+  const std::size_t tail = tail_.load(ma::detail::memory_order_relaxed);
+  if ((tail - producer_head_ == slots_.size()) && !prepared_size())
+  {
+    return false;
+  }
+  slots_[tail & mask_] = value;
+  tail_.store(tail + 1, ma::detail::memory_order_release);
+  return true;
+}
+
+template <typename Value>
+std::size_t spsc_queue<Value>::size()
+{
+  const std::size_t head = head_.load(ma::detail::memory_order_relaxed);
+  consumer_tail_ = tail_.load(ma::detail::memory_order_acquire);
+  return consumer_tail_ - head;
+}
+
+template <typename Value>
+typename spsc_queue<Value>::value_type& spsc_queue<Value>::front(
+    std::size_t offset)
+{
+  const std::size_t head = head_.load(ma::detail::memory_order_relaxed);
+  BOOST_ASSERT_MSG(offset < consumer_tail_ - head,
+      "Offset is out of filled slots");
+  return slots_[(head + offset) & mask_];
+}
+
+template <typename Value>
+void spsc_queue<Value>::consume(std::size_t count)
+{
+  const std::size_t head = head_.load(ma::detail::memory_order_relaxed);
+  BOOST_ASSERT_MSG(count <= consumer_tail_ - head,
+      "Count is out of filled slots");
+  head_.store(head + count, ma::detail::memory_order_release);
+}
+
+template <typename Value>
+bool spsc_queue<Value>::pop(value_type& value)
+{
+  const std::size_t head = head_.load(ma::detail::memory_order_relaxed);
+  if ((consumer_tail_ == head) && !size())
+  {
+    return false;
+  }
+  value = slots_[head & mask_];
+  head_.store(head + 1, ma::detail::memory_order_release);
+  return true;
+}
+
+template <typename Value>
+std::size_t spsc_queue<Value>::round_up_capacity(std::size_t capacity)
+{
+  const std::size_t max_capacity =
+      ((std::numeric_limits<std::size_t>::max)() >> 1) + 1;
+  if (!capacity || (capacity > max_capacity))
+  {
+    boost::throw_exception(std::length_error("invalid capacity"));
+  }
+  std::size_t rounded = 1;
+  while (rounded < capacity)
+  {
+    rounded <<= 1;
+  }
+  return rounded;
+}
+
+} // namespace ma
+
+#endif // MA_SPSC_QUEUE_HPP
@@ -0,0 +1 @@
+// Fake source file to build C++ library
\ No newline at end of file
@@ -204,6 +204,77 @@ TEST(generic_test, data_contains_same_bytes_as_put_into_prepared)
   }
 }
 
+TEST_P(generic_test, skip_more_than_filled)
+{
+  const std::size_t buffer_size = GetParam();
+  ma::cyclic_buffer buffer(buffer_size);
+  ASSERT_THROW(buffer.data(1, buffer_size), std::length_error);
+}
+
+TEST(generic_test, data_with_offset_skips_first_bytes)
+{
+  typedef ma::cyclic_buffer::const_buffers_type const_buffers_type;
+  typedef ma::cyclic_buffer::mutable_buffers_type mutable_buffers_type;
+  typedef boost::asio::buffers_iterator<const_buffers_type> const_buffers_iterator;
+  typedef boost::asio::buffers_iterator<mutable_buffers_type> mutable_buffers_iterator;
+  ma::cyclic_buffer buffer(16);
+  buffer.consume(12);
+  buffer.commit(12);
+  {
+    char num = 0;
+    mutable_buffers_type nonfilled = buffer.prepared(10);
+    for (mutable_buffers_iterator i = boost::asio::buffers_begin(nonfilled),
+        end = boost::asio::buffers_end(nonfilled); i != end; ++i)
+    {
+      *i = num++;
+    }
+  }
+  buffer.consume(10);
+  // Offset within the first continuous block
+  {
+    const const_buffers_type filled = buffer.data(2, 6);
+    ASSERT_EQ(2U, std::distance(filled.begin(), filled.end()));
+    ASSERT_EQ(6U, boost::asio::buffer_size(filled));
+    char num = 2;
+    for (const_buffers_iterator i = boost::asio::buffers_begin(filled),
+        end = boost::asio::buffers_end(filled); i != end; ++i)
+    {
+      ASSERT_EQ(static_cast<int>(num++), static_cast<int>(*i));
+    }
+  }
+  // Offset reaching the end of the first continuous block
+  {
+    const const_buffers_type filled = buffer.data(4, buffer.size());
+    ASSERT_EQ(1U, std::distance(filled.begin(), filled.end()));
+    ASSERT_EQ(6U, boost::asio::buffer_size(filled));
+    char num = 4;
+    for (const_buffers_iterator i = boost::asio::buffers_begin(filled),
+        end = boost::asio::buffers_end(filled); i != end; ++i)
+    {
+      ASSERT_EQ(static_cast<int>(num++), static_cast<int>(*i));
+    }
+  }
+  ASSERT_EQ(0U, boost::asio::buffer_size(buffer.data(10, buffer.size())));
+}
+
+TEST(generic_test, swap_exchanges_memory_and_state)
+{
+  ma::cyclic_buffer buffer1(16);
+  ma::cyclic_buffer buffer2(8);
+  buffer1.consume(10);
+  buffer1.commit(4);
+  const void* memory1 = boost::asio::buffer_cast<const void*>(
+      *buffer1.data().begin());
+  buffer1.swap(buffer2);
+  ASSERT_EQ(8U, buffer1.size());
+  ASSERT_EQ(0U, boost::asio::buffer_size(buffer1.data()));
+  ASSERT_EQ(8U, boost::asio::buffer_size(buffer1.prepared()));
+  ASSERT_EQ(16U, buffer2.size());
+  ASSERT_EQ(6U, boost::asio::buffer_size(buffer2.data()));
+  ASSERT_EQ(memory1, boost::asio::buffer_cast<const void*>(
+      *buffer2.data().begin()));
+}
+
 TEST(complex_test, looping_free_space)
 {
   typedef ma::cyclic_buffer::mutable_buffers_type mutable_buffers_type;
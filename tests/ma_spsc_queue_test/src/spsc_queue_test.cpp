@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2018 Marat Abrarov (abrarov@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <cstddef>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <ma/spsc_queue.hpp>
+#include <ma/detail/functional.hpp>
+#include <ma/detail/thread.hpp>
+
+namespace ma {
+namespace test {
+namespace spsc_queue_test {
+
+typedef ma::spsc_queue<std::size_t> queue_type;
+
+class generic_test : public testing::TestWithParam<std::size_t>
+{
+}; // class generic_test
+
+INSTANTIATE_TEST_CASE_P(capacity, generic_test,
+    testing::Values(1, 2, 3, 5, 128));
+
+TEST_P(generic_test, capacity_is_rounded_up_to_power_of_2)
+{
+  const std::size_t capacity = GetParam();
+  const queue_type queue(capacity);
+  ASSERT_LE(capacity, queue.capacity());
+  ASSERT_GT(capacity * 2, queue.capacity());
+  ASSERT_EQ(0U, queue.capacity() & (queue.capacity() - 1));
+}
+
+TEST_P(generic_test, empty)
+{
+  queue_type queue(GetParam());
+  std::size_t value = 0;
+  ASSERT_EQ(0U, queue.size());
+  ASSERT_EQ(queue.capacity(), queue.prepared_size());
+  ASSERT_FALSE(queue.pop(value));
+}
+
+TEST_P(generic_test, push_until_full_and_pop_until_empty)
+{
+  queue_type queue(GetParam());
+  const std::size_t capacity = queue.capacity();
+  // Pass the ring boundary a few times
+  for (std::size_t round = 0; round != 3; ++round)
+  {
+    for (std::size_t i = 0; i != capacity; ++i)
+    {
+      ASSERT_TRUE(queue.push(round * capacity + i));
+    }
+    ASSERT_FALSE(queue.push(0));
+    ASSERT_EQ(capacity, queue.size());
+    ASSERT_EQ(0U, queue.prepared_size());
+    for (std::size_t i = 0; i != capacity; ++i)
+    {
+      std::size_t value = 0;
+      ASSERT_TRUE(queue.pop(value));
+      ASSERT_EQ(round * capacity + i, value);
+    }
+    std::size_t value = 0;
+    ASSERT_FALSE(queue.pop(value));
+  }
+}
+
+TEST_P(generic_test, slots_are_filled_and_read_in_place)
+{
+  queue_type queue(GetParam(), 7);
+  const std::size_t capacity = queue.capacity();
+  ASSERT_EQ(capacity, queue.prepared_size());
+  for (std::size_t i = 0; i != capacity; ++i)
+  {
+    // Slots are copy constructed from the given value
+    ASSERT_EQ(7U, queue.prepared(i));
+    queue.prepared(i) = i;
+  }
+  queue.commit(capacity);
+  ASSERT_EQ(0U, queue.prepared_size());
+  ASSERT_EQ(capacity, queue.size());
+  for (std::size_t i = 0; i != capacity; ++i)
+  {
+    ASSERT_EQ(i, queue.front(i));
+  }
+  queue.consume(capacity);
+  ASSERT_EQ(0U, queue.size());
+  ASSERT_EQ(capacity, queue.prepared_size());
+  // Consumed slots keep their values
+  for (std::size_t i = 0; i != capacity; ++i)
+  {
+    ASSERT_EQ(i, queue.prepared(i));
+  }
+}
+
+TEST(spsc_queue, zero_capacity)
+{
+  ASSERT_THROW(queue_type queue(0), std::length_error);
+}
+
+TEST(spsc_queue, partial_commit_and_consume)
+{
+  queue_type queue(8);
+  ASSERT_EQ(8U, queue.prepared_size());
+  queue.prepared(0) = 1;
+  queue.prepared(1) = 2;
+  queue.prepared(2) = 3;
+  queue.commit(2);
+  ASSERT_EQ(6U, queue.prepared_size());
+  ASSERT_EQ(2U, queue.size());
+  ASSERT_EQ(1U, queue.front());
+  queue.consume();
+  ASSERT_EQ(1U, queue.size());
+  ASSERT_EQ(2U, queue.front());
+  ASSERT_EQ(7U, queue.prepared_size());
+}
+
+namespace {
+
+const std::size_t transferred_count = 1000000;
+
+void produce(queue_type& queue)
+{
+  std::size_t value = 0;
+  while (value != transferred_count)
+  {
+    const std::size_t batch_size = queue.prepared_size();
+    for (std::size_t i = 0; (i != batch_size) && (value != transferred_count);
+        ++i, ++value)
+    {
+      queue.prepared() = value;
+      queue.commit();
+    }
+    if (!batch_size)
+    {
+      ma::detail::this_thread::yield();
+    }
+  }
+}
+
+} // anonymous namespace
+
+TEST(spsc_queue, values_are_transferred_between_threads_in_order)
+{
+  queue_type queue(64);
+  ma::detail::thread producer(ma::detail::bind(produce,
+      ma::detail::ref(queue)));
+  std::size_t expected = 0;
+  bool ordered = true;
+  while (expected != transferred_count)
+  {
+    std::size_t value = 0;
+    if (!queue.pop(value))
+    {
+      ma::detail::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && (expected == value);
+    ++expected;
+  }
+  producer.join();
+  ASSERT_TRUE(ordered);
+  ASSERT_EQ(0U, queue.size());
+}
+
+} // namespace spsc_queue_test
+} // namespace test
+} // namespace ma